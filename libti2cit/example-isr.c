@@ -11,108 +11,7 @@
 #include "driverlib/gpio.h"
 #include "driverlib/i2c.h"
 #include "driverlib/rom.h"
-
-static uint8_t hih_command_mode_retry(uint32_t sysclock, uint32_t addr, char * str)
-{
-	static const uint8_t hih_cmd_mode[] = { 0xa0, 0, 0 };
-	uint8_t r = libti2cit_m_sync_send(I2C2_BASE, addr << 1, sizeof(hih_cmd_mode)/sizeof(hih_cmd_mode[0]), hih_cmd_mode);
-	if (r) {
-		UARTsend("cmdmode nack ");
-		u8tohex(str, r);
-		UARTsend(str);
-		UARTsend("\r\n");
-		return 1;
-	}
-
-	uint8_t hih_eep_read[3] = { 0, 0, 0 };
-	uint8_t hih_eep_data[3] = { 0, 0, 0 };
-	uint32_t eep;
-
-#if 0
-	hih_eep_read[0] = 0x17 | 0x40;
-	hih_eep_read[1] = 0x9a;
-	hih_eep_read[2] = 0xcb;
-	UARTsend("eep wr ");
-	if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1), sizeof(hih_eep_read)/sizeof(hih_eep_read[0]), hih_eep_read)) {
-		UARTsend("nack\r\n");
-		return 1;
-	}
-
-	hih_eep_read[1] = 0;
-	hih_eep_read[2] = 0;
-	ROM_SysCtlDelay(sysclock/832);	// wait 12ms for response
-	if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1) | 1, 0, 0)) {
-		UARTsend("status nack\r\n");
-		return 1;
-	}
-	if (libti2cit_m_sync_recv(I2C2_BASE, 1, hih_eep_data)) return 1;
-
-	UARTsend(" r");
-	u8tohex(str, hih_eep_data[0]);	// must be 0x81 for success, 0x80 means still busy, 0x82 is illegal operation, all else are device failure
-	UARTsend(str);
-	UARTsend("\r\n");
-#endif
-
-	for (eep = 0; eep < 0x20; eep++) {
-		UARTsend("eep read ");
-		u8tohex(str, eep);
-		UARTsend(str);
-
-		hih_eep_read[0] = eep;
-		if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1), sizeof(hih_eep_read)/sizeof(hih_eep_read[0]), hih_eep_read)) {
-			UARTsend("eepread nack\r\n");
-			return 1;
-		}
-		ROM_SysCtlDelay(sysclock/10000);	// wait 100us for response
-		if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1) | 1, 0, 0)) {
-			UARTsend("eepread nack\r\n");
-			return 1;
-		}
-		if (libti2cit_m_sync_recv(I2C2_BASE, sizeof(hih_eep_data)/sizeof(hih_eep_data[0]), hih_eep_data)) return 1;
-
-		uint32_t j;
-		for (j = 0; j < 3; j++) {
-			UARTsend(" r");
-			u8tohex(str, hih_eep_data[j]);
-			UARTsend(str);
-		}
-		UARTsend("\r\n");
-	}
-	return 0;
-}
-
-static void hih_command_mode_exit(uint32_t sysclock, uint32_t addr, char * str)
-{
-	static const uint8_t hih_cmd_mode[] = { 0x80, 0, 0 };
-	uint8_t r = libti2cit_m_sync_send(I2C2_BASE, addr << 1, sizeof(hih_cmd_mode)/sizeof(hih_cmd_mode[0]), hih_cmd_mode);
-	if (r) {
-		UARTsend("cmdmode_exit nack ");
-		u8tohex(str, r);
-		UARTsend(str);
-		UARTsend("\r\n");
-	}
-
-	ROM_SysCtlDelay(sysclock/25);		// wait 40ms for device to exit command mode
-}
-
-static uint8_t hih_command_mode(uint32_t sysclock, uint32_t addr, char * str)
-{
-	ROM_GPIOPinWrite(GPIO_PORTL_BASE, GPIO_PIN_2 | GPIO_PIN_3, 0);
-	ROM_SysCtlDelay(sysclock/1000);		// wait 1ms for device to power down
-	ROM_GPIOPinWrite(GPIO_PORTL_BASE, GPIO_PIN_2 | GPIO_PIN_3, GPIO_PIN_3);
-	ROM_SysCtlDelay(sysclock/10000);	// wait 100us for device to power up
-
-	uint32_t n;
-	for (n = 0; n < 5; n++) {
-		if (!hih_command_mode_retry(sysclock, addr, str)) {
-			// command mode success
-			hih_command_mode_exit(sysclock, addr, str);
-			return 0;
-		}
-	}
-	UARTsend("unable to enter command mode\r\n");
-	return 1;
-}
+#include "driverlib/timer.h"
 
 static void i2cInt_isr_dump(uint32_t status)
 {
@@ -138,137 +37,147 @@ static void i2cInt_isr_dump(uint32_t status)
 }
 
 typedef struct example_isr_st_ {
-	libti2cit_int_st ti2cit;
+	libti2cit_pt_st pt;	// MUST be first: scan_thread() casts pt back to example_isr_st
 	uint32_t scan_addr;
-	uint32_t scan_found;
-	uint32_t talk_count;
 	uint32_t sysclock;
+	libti2cit_recover_st recover;
+	libti2cit_nvm_st nvm;
+	volatile uint32_t nvm_running;	// i2c2Int_isr() gives the interrupt to nvm.st: one libti2cit_int_st per base
+	uint8_t nvm_r;
+	uint8_t hih_eep[0x20 * 2];
+	libti2cit_sched_st sched;
+	volatile uint32_t sched_running;	// i2c2Int_isr() gives the interrupt to sched.st
+	libti2cit_sched_dev_st dev[8];
+	uint8_t dev_buf[8][4];
 } example_isr_st;
 
 example_isr_st i2c2;
 
-static void scan_next_addr(libti2cit_int_st * st, uint32_t status);
-static void scan_start()
+static const uint8_t hih_cmd_mode[] = { 0xa0, 0, 0 };
+static const uint8_t hih_cmd_exit[] = { 0x80, 0, 0 };
+
+static void hih_eep_done(libti2cit_nvm_st * nvm, uint8_t r)
 {
-	if (i2c2.scan_addr > 127) return;
-
-	// start by assuming a device is present -- if NACK is received, then it is not present
-	i2c2.ti2cit.buf = 0;
-	i2c2.ti2cit.user_cb = scan_next_addr;
-	i2c2.ti2cit.addr = i2c2.scan_addr << 1;
-	i2c2.ti2cit.len = 0;
-	i2c2.scan_found = 1;
-	libti2cit_m_isr_nofifo_send(&i2c2.ti2cit);
+	i2c2.nvm_running = 0;
+	i2c2.nvm_r = r;
+	libti2cit_pt_resume(&i2c2.pt);	// scan_thread() carries on after its LIBTI2CIT_PT_YIELD()
 }
 
-static void talk_to_device();
-static void scan_next_addr(libti2cit_int_st * st, uint32_t status)
+static void hih_eep_print()
 {
-	if (status & I2C_MIMR_NACKIM) {
-		i2c2.scan_found = 0;	// got a nack for this address
-		return;
-	}
-
-	// wait for i2c state machine to reach STOP state
-	if (!(status & I2C_MIMR_STOPIM)) {
-		UARTsend("scan_nxt ");
-		i2cInt_isr_dump(status);
+	char str[8];
+	if (i2c2.nvm_r) {
+		UARTsend("eepread fail ");
+		u8tohex(str, i2c2.nvm_r);
+		UARTsend(str);
+		UARTsend("\r\n");
 		return;
 	}
-
-	if (i2c2.scan_found) {
-		// ACK received at i2c2.scan_addr: device found
-		i2c2.scan_found = 0;
-		ROM_UARTCharPut(UART0_BASE, '[');
-		char str[8];
-		u8tohex(str, i2c2.scan_addr);
+	uint32_t eep;
+	for (eep = 0; eep < 0x20; eep++) {
+		UARTsend("eep read ");
+		u8tohex(str, eep);
 		UARTsend(str);
-		ROM_UARTCharPut(UART0_BASE, ']');
-
-		i2c2.ti2cit.user_cb = 0;
-		i2c2.talk_count = 0;
-		talk_to_device();	// talk_to_device() will call scan_next_addr() when it is finished
-		return;
+		UARTsend(" r");
+		u8tohex(str, i2c2.hih_eep[eep * 2]);
+		UARTsend(str);
+		UARTsend(" r");
+		u8tohex(str, i2c2.hih_eep[eep * 2 + 1]);
+		UARTsend(str);
+		UARTsend("\r\n");
 	}
-
-	i2c2.scan_addr++;
-	scan_start();
 }
 
-static void talk_to_device_cb(libti2cit_int_st * st, uint32_t status);
-static void talk_to_device()
+/* main_isr() reads every device found with libti2cit_sched_...() after the scan */
+static void sched_add(uint32_t addr)
 {
-	if (i2c2.talk_count >= 10) {
-		// done talking to device, resume scanning
-		scan_next_addr(&i2c2.ti2cit, I2C_MIMR_STOPIM);
-		return;
-	}
-
-	i2c2.ti2cit.buf = 0;
-	i2c2.ti2cit.user_cb = talk_to_device_cb;
-	i2c2.ti2cit.addr = (i2c2.scan_addr << 1) | 1;
-	i2c2.ti2cit.len = 0;
-	libti2cit_m_isr_nofifo_send(&i2c2.ti2cit);
+	if (i2c2.sched.ndev >= sizeof(i2c2.dev)/sizeof(i2c2.dev[0])) return;
+	libti2cit_sched_dev_st * d = &i2c2.dev[i2c2.sched.ndev];
+	d->measure.addr = addr << 1;	// quick command: start a measurement
+	d->fetch.addr = addr << 1;
+	d->fetch.rbuf = i2c2.dev_buf[i2c2.sched.ndev];
+	d->fetch.rlen = sizeof(i2c2.dev_buf[0]);
+	i2c2.sched.ndev++;
 }
 
-uint8_t read_buf[4];
-static void talk_to_device_read(libti2cit_int_st * st, uint32_t status);
-static void talk_to_device_cb(libti2cit_int_st * st, uint32_t status)
+/* the scan is a protothread: it returns at each LIBTI2CIT_PT_...() and is run again from there when the transaction is
+ * done, so it reads top to bottom even though all of it after the first quick command runs from i2c2Int_isr()
+ */
+static void scan_thread(libti2cit_pt_st * pt)
 {
-	/* TODO: to really be an interrupt example, set up a timer interrupt and run from the timer isr */
-	ROM_SysCtlDelay(i2c2.sysclock/300);
+	example_isr_st * e = (example_isr_st *) pt;
+	char str[8];
+	LIBTI2CIT_PT_BEGIN(pt);
+	for (e->scan_addr = 1; e->scan_addr <= 127; e->scan_addr++) {
+		LIBTI2CIT_PT_XFER(pt, e->scan_addr << 1, 0, 0, 0, 0);	// quick command
+		if (pt->status & I2C_MIMR_NACKIM) continue;	// no device at this address
+		if (pt->status) {
+			UARTsend("scan ");
+			i2cInt_isr_dump(pt->status);
+			continue;
+		}
 
-	i2c2.ti2cit.buf = read_buf;
-	i2c2.ti2cit.user_cb = talk_to_device_read;
-	i2c2.ti2cit.len = sizeof(read_buf);
-	libti2cit_m_isr_nofifo_recv(&i2c2.ti2cit);
+		UARTputc('[');
+		u8tohex(str, e->scan_addr);
+		UARTsend(str);
+		UARTputc(']');
+		sched_add(e->scan_addr);
+
+		if (0) {
+			// HIH6130 command mode: 0xa0, the 32 eeprom words with libti2cit_nvm_isr_read(), 0x80
+			// libti2cit reads the status byte after each eeprom command until the sensor is done: no fixed delays
+			ROM_GPIOPinWrite(GPIO_PORTL_BASE, GPIO_PIN_2 | GPIO_PIN_3, 0);
+			ROM_SysCtlDelay(e->sysclock/1000);	// wait 1ms for device to power down
+			ROM_GPIOPinWrite(GPIO_PORTL_BASE, GPIO_PIN_2 | GPIO_PIN_3, GPIO_PIN_3);
+			ROM_SysCtlDelay(e->sysclock/10000);	// wait 100us for device to power up
+
+			LIBTI2CIT_PT_XFER(pt, e->scan_addr << 1, hih_cmd_mode, sizeof(hih_cmd_mode), 0, 0);
+			if (pt->status) {
+				UARTsend("unable to enter command mode\r\n");
+				continue;
+			}
+
+			e->nvm.st.base = I2C2_BASE;
+			e->nvm.st.recover = &e->recover;
+			e->nvm.addr = e->scan_addr;
+			e->nvm.type = LIBTI2CIT_NVM_HIH;
+			e->nvm.timeout = e->sysclock/50;	// give up after 20ms
+			e->nvm.done = hih_eep_done;
+			e->nvm_running = 1;
+			libti2cit_nvm_isr_read(&e->nvm, 0, sizeof(e->hih_eep), e->hih_eep);	// all 32 words in one call
+			LIBTI2CIT_PT_YIELD(pt);
+			hih_eep_print();
+
+			// leave command mode. No need to wait for it: a measurement read before the device is back is only stale
+			LIBTI2CIT_PT_XFER(pt, e->scan_addr << 1, hih_cmd_exit, sizeof(hih_cmd_exit), 0, 0);
+		}
+	}
+	LIBTI2CIT_PT_END(pt);
 }
 
-static void talk_to_device_read(libti2cit_int_st * st, uint32_t status)
+/* done of every libti2cit_sched_dev_st: called from the interrupt after each fetch */
+static uint32_t sched_done(libti2cit_sched_st * sched, libti2cit_sched_dev_st * d)
 {
-	if (status & I2C_MIMR_NACKIM) {
-		// retry talk_to_device()
-		UARTsend("talk nack\r\n");
-		i2c2.ti2cit.user_cb = 0;
-		i2c2.talk_count++;
-		talk_to_device();
-		return;
-	}
-
-	if (!(status & I2C_MIMR_STOPIM)) {
-		UARTsend("not sure why not in STOP ");
-		i2cInt_isr_dump(status);
-		return;
-	}
-
-	if (i2c2.ti2cit.nread != 4) {
-		UARTsend("talk wrong len\r\n");
-		i2c2.ti2cit.user_cb = 0;
-		i2c2.talk_count++;
-		talk_to_device();
-		return;
+	char str[32];
+	if (d->measure.status || d->fetch.status) {
+		UARTsend("sched nack ");
+		u8tohex(str, d->fetch.addr >> 1);
+		UARTsend(str);
+		UARTsend("\r\n");
+		return 0;
 	}
 
-	i2c2.ti2cit.user_cb = 0;
-	ROM_UARTCharPut(UART0_BASE, ' ');
 	uint32_t v = 0;
-	char str[32];
 	uint32_t i;
-	for (i = 0; i < sizeof(read_buf)/sizeof(read_buf[0]); i++) {
+	for (i = 0; i < d->fetch.rlen; i++) {
 		v <<= 8;
-		v |= read_buf[i];
-		u8tohex(str, read_buf[i]);
-		UARTsend(str);
-	}
-
-	if (v & 0x40000000l) {
-		// device not ready yet
-		talk_to_device();
-		return;
+		v |= d->fetch.rbuf[i];
 	}
+	if (v & 0x40000000l) return 1;	// device not ready yet: fetch again next tick
 
-	// decode data
-	UARTsend("\r\ntemp=");
+	u8tohex(str, d->fetch.addr >> 1);
+	UARTsend(str);
+	UARTsend(" temp=");
 	int32_t tc1 = ((v & 0xffff) >> 2)*165;
 	tc1 = (tc1*100) >> 14;
 	tc1 -= 4000;
@@ -290,11 +199,7 @@ static void talk_to_device_read(libti2cit_int_st * st, uint32_t status)
 	str[2] = '.';
 	UARTsend(str);
 	UARTsend(" F\r\n");
-
-	if (0) hih_command_mode(i2c2.sysclock, i2c2.scan_addr, str);
-
-	// done talking to device, resume scanning
-	scan_next_addr(&i2c2.ti2cit, I2C_MIMR_STOPIM);
+	return 0;
 }
 
 void main_isr(uint32_t sysclock)
@@ -306,19 +211,24 @@ void main_isr(uint32_t sysclock)
 		len--;
 	}
 
-	i2c2.ti2cit.base = I2C2_BASE;
+	i2c2.pt.st.base = I2C2_BASE;
 	i2c2.sysclock = sysclock;
-	libti2cit_m_int_clear(&i2c2.ti2cit);
+	i2c2.recover.gpio_base = GPIO_PORTL_BASE;	// see the pin setup in example-main.c
+	i2c2.recover.scl = GPIO_PIN_1;
+	i2c2.recover.sda = GPIO_PIN_0;
+	i2c2.recover.half_bit = sysclock / 3 / (2 * 400000);
+	i2c2.pt.st.recover = &i2c2.recover;
+	libti2cit_m_int_clear(&i2c2.pt.st);
 
 	ROM_IntMasterEnable();
 	ROM_IntEnable(INT_I2C2);
 	ROM_I2CMasterIntEnableEx(I2C2_BASE, I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM | I2C_MIMR_IM);
 
-	scan_start();
+	libti2cit_pt_start(&i2c2.pt, scan_thread);
 
 	uint32_t time_out = 1000000lu;
-	for (; i2c2.scan_addr <= 127 && time_out; ROM_SysCtlDelay(sysclock/50), time_out--) {
-		ROM_UARTCharPut(UART0_BASE, '.');
+	for (; i2c2.pt.running && time_out; ROM_SysCtlDelay(sysclock/50), time_out--) {
+		UARTputc('.');
 	}
 
 	if (!time_out) {
@@ -327,28 +237,69 @@ void main_isr(uint32_t sysclock)
 		UARTsend("done\r\n");
 	}
 
-	ROM_I2CMasterIntDisable(i2c2.ti2cit.base);
+	// read every device found 10 times, all of them at once: Timer 0A ticks every 1ms and libti2cit_sched_tick()
+	// starts each measure and fetch when it is due, so no time is spent waiting for a conversion
+	uint32_t i;
+	for (i = 0; i < i2c2.sched.ndev; i++) {
+		i2c2.dev[i].period = 100;	// 10 readings a second
+		i2c2.dev[i].conv = 37;		// the HIH6130 takes 36.65ms
+		i2c2.dev[i].done = sched_done;
+	}
+	i2c2.sched.st.base = I2C2_BASE;
+	i2c2.sched.st.recover = &i2c2.recover;
+	i2c2.sched.dev = i2c2.dev;
+	libti2cit_sched_start(&i2c2.sched);
+	i2c2.sched_running = 1;
+
+	ROM_TimerConfigure(TIMER0_BASE, TIMER_CFG_PERIODIC);
+	ROM_TimerLoadSet(TIMER0_BASE, TIMER_A, sysclock/1000);
+	ROM_IntPrioritySet(INT_TIMER0A, 0);	// the same priority as INT_I2C2, see libti2cit_sched_tick()
+	ROM_IntPrioritySet(INT_I2C2, 0);
+	ROM_TimerIntEnable(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+	ROM_IntEnable(INT_TIMER0A);
+	ROM_TimerEnable(TIMER0_BASE, TIMER_A);
+
+	for (time_out = 300; i2c2.sched.ndev && time_out; ROM_SysCtlDelay(sysclock/300), time_out--) {
+		for (i = 0; i < i2c2.sched.ndev && i2c2.dev[i].nread + i2c2.dev[i].nerr >= 10; i++) ;
+		if (i == i2c2.sched.ndev) break;
+	}
+
+	ROM_TimerDisable(TIMER0_BASE, TIMER_A);
+	ROM_TimerIntDisable(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+	ROM_IntDisable(INT_TIMER0A);
+	while (i2c2.sched.running) ;	// let the last batch finish
+	i2c2.sched_running = 0;
+
+	ROM_I2CMasterIntDisable(i2c2.pt.st.base);
 	ROM_IntDisable(INT_I2C2);
 	ROM_IntMasterDisable();
 
-	libti2cit_m_int_clear(&i2c2.ti2cit);
+	libti2cit_m_int_clear(&i2c2.pt.st);
 }
 
 void i2c2Int_isr()
 {
-	uint32_t status = libti2cit_m_isr_isr(&i2c2.ti2cit);
+	libti2cit_int_st * st = &i2c2.pt.st;
+	if (i2c2.nvm_running) st = &i2c2.nvm.st;
+	if (i2c2.sched_running) st = &i2c2.sched.st;
+	uint32_t status = libti2cit_m_isr_isr(st);
 	if (status & LIBTI2CIT_ISR_UNEXPECTED) {
 		UARTsend("isr unexpected ");
 		i2cInt_isr_dump(status);
 	}
 	if (status & I2C_MIMR_ARBLOSTIM) {
-		UARTsend("isr: arblost\r\n");
+		UARTsend("isr: arblost, bus recovered\r\n");
 	}
 	if (status & I2C_MIMR_CLKIM) {
-		UARTsend("isr: clk timeout\r\n");
+		UARTsend("isr: clk timeout, bus recovered\r\n");
 	}
 }
 
+void timer0Int_isr()
+{
+	libti2cit_sched_tick(&i2c2.sched);
+}
+
 void i2c7Int_isr()
 {
 	UARTsend("TODO: i2c7Int_isr()\r\n");
@@ -0,0 +1,201 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "example-main.h"
+#include "libti2cit.h"
+
+#include "inc/hw_i2c.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/i2c.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+/* uDMA channels for the I2C2 RX and TX FIFOs: see "uDMA Channel Assignments" in the TM4C1294 datasheet
+ * the UDMA_CHn_... values are (encoding << 16) | n, which is what ROM_uDMAChannelAssign() takes; libti2cit wants n
+ */
+#define EXAMPLE_DMA_RX UDMA_CH4_I2C2RX
+#define EXAMPLE_DMA_TX UDMA_CH5_I2C2TX
+
+// the uDMA control table must be 1024-byte aligned
+static uint8_t dma_table[1024] __attribute__ ((aligned(1024)));
+
+static void i2cInt_isr_dump(uint32_t status)
+{
+	static char buf[] = "status=0000";
+	u16tohex(&buf[7], status);
+	buf[11] = 0;
+	UARTsend(buf);
+
+	if (status & I2C_MIMR_IM) UARTsend(" RIS");
+	if (status & I2C_MIMR_CLKIM) UARTsend(" CLK");
+	if (status & I2C_MIMR_DMARXIM) UARTsend(" dmaRX");
+	if (status & I2C_MIMR_DMATXIM) UARTsend(" dmaTX");
+	if (status & I2C_MIMR_NACKIM) UARTsend(" nack");
+	if (status & I2C_MIMR_STOPIM) UARTsend(" stop");
+	if (status & I2C_MIMR_ARBLOSTIM) UARTsend(" arb");
+
+	UARTsend("\r\n");
+}
+
+typedef struct example_isrdma_st_ {
+	libti2cit_int_st ti2cit;
+	uint32_t scan_addr;
+	uint32_t scan_map[4];
+	uint32_t sysclock;
+} example_isrdma_st;
+
+static example_isrdma_st i2c2;
+static uint8_t dump_buf[64];
+
+static void scan_next_addr(libti2cit_int_st * st, uint32_t status);
+static void scan_start()
+{
+	// libti2cit_m_scan() fills in scan_map from the i2c interrupt, then calls scan_next_addr() once
+	i2c2.ti2cit.user_cb = scan_next_addr;
+	i2c2.ti2cit.scan = i2c2.scan_map;
+	libti2cit_m_scan(&i2c2.ti2cit);
+}
+
+static void dump_device();
+static void scan_next_addr(libti2cit_int_st * st, uint32_t status)
+{
+	if (!(status & I2C_MIMR_STOPIM)) {
+		UARTsend("scan_nxt ");
+		i2cInt_isr_dump(status);
+		i2c2.scan_addr = 128;	// give up
+		return;
+	}
+
+	// find the next device in scan_map
+	for (; i2c2.scan_addr <= 127; i2c2.scan_addr++) {
+		if (!(i2c2.scan_map[i2c2.scan_addr >> 5] & (1u << (i2c2.scan_addr & 31)))) continue;
+
+		UARTputc('[');
+		char str[8];
+		u8tohex(str, i2c2.scan_addr);
+		UARTsend(str);
+		UARTputc(']');
+
+		dump_device();	// dump_device() will call scan_next_addr() when it is finished
+		return;
+	}
+}
+
+static void dump_device_recv(libti2cit_int_st * st, uint32_t status);
+static void dump_device()
+{
+	i2c2.ti2cit.buf = 0;
+	i2c2.ti2cit.user_cb = dump_device_recv;
+	i2c2.ti2cit.addr = (i2c2.scan_addr << 1) | 1;
+	i2c2.ti2cit.len = 0;
+	libti2cit_m_isr_send(&i2c2.ti2cit);
+}
+
+static void dump_device_done(libti2cit_int_st * st, uint32_t status);
+static void dump_device_recv(libti2cit_int_st * st, uint32_t status)
+{
+	if (status & I2C_MIMR_NACKIM) {
+		UARTsend("dump nack\r\n");
+		// skip this device: the STOP that follows the NACK goes to scan_next_addr(), not back here
+		i2c2.ti2cit.user_cb = scan_next_addr;
+		i2c2.scan_addr++;
+		return;
+	}
+
+	// the uDMA reads the whole buffer: the next interrupt is when it is all done
+	i2c2.ti2cit.buf = dump_buf;
+	i2c2.ti2cit.user_cb = dump_device_done;
+	i2c2.ti2cit.len = sizeof(dump_buf);
+	libti2cit_m_isrdma_recv(&i2c2.ti2cit);
+}
+
+static void dump_device_done(libti2cit_int_st * st, uint32_t status)
+{
+	if (!(status & I2C_MIMR_STOPIM)) {
+		UARTsend("dump failed ");
+		i2cInt_isr_dump(status);
+		return;
+	}
+
+	char str[8];
+	uint32_t i;
+	for (i = 0; i < st->nread; i++) {
+		if (!(i & 15)) UARTsend("\r\n ");
+		u8tohex(str, dump_buf[i]);
+		UARTputc(' ');
+		UARTsend(str);
+	}
+	UARTsend("\r\n ints=");
+	printf_int32(str, st->nisr);
+	UARTsend(str);
+	UARTsend("\r\n");
+
+	// done with this device, go to the next one
+	i2c2.ti2cit.user_cb = 0;
+	i2c2.scan_addr++;
+	scan_next_addr(&i2c2.ti2cit, I2C_MIMR_STOPIM);
+}
+
+void main_isrdma(uint32_t sysclock)
+{
+	char * p = (char *) &i2c2;
+	uint32_t len = sizeof(i2c2);
+	while (len) {
+		*(p++) = 0;
+		len--;
+	}
+
+	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA)) ;
+	ROM_uDMAEnable();
+	ROM_uDMAControlBaseSet(dma_table);
+	ROM_uDMAChannelAssign(EXAMPLE_DMA_RX);
+	ROM_uDMAChannelAssign(EXAMPLE_DMA_TX);
+
+	i2c2.ti2cit.base = I2C2_BASE;
+	i2c2.ti2cit.dma_rx = EXAMPLE_DMA_RX & 0xff;
+	i2c2.ti2cit.dma_tx = EXAMPLE_DMA_TX & 0xff;
+	i2c2.sysclock = sysclock;
+	libti2cit_m_int_clear(&i2c2.ti2cit);
+
+	ROM_IntMasterEnable();
+	ROM_IntEnable(INT_I2C2);
+	ROM_I2CMasterIntEnableEx(I2C2_BASE, I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM | I2C_MIMR_IM);
+
+	scan_start();
+
+	uint32_t time_out = 1000000lu;
+	for (; i2c2.scan_addr <= 127 && time_out; ROM_SysCtlDelay(sysclock/50), time_out--) {
+		UARTputc('.');
+	}
+
+	if (!time_out) {
+		UARTsend("gave up, took too long\r\n");
+	} else {
+		UARTsend("done\r\n");
+	}
+
+	ROM_I2CMasterIntDisable(i2c2.ti2cit.base);
+	ROM_IntDisable(INT_I2C2);
+	ROM_IntMasterDisable();
+
+	libti2cit_m_int_clear(&i2c2.ti2cit);
+}
+
+void i2c2Int_isrdma()
+{
+	uint32_t status = libti2cit_m_isr_isr(&i2c2.ti2cit);
+	if (status & LIBTI2CIT_ISR_UNEXPECTED) {
+		UARTsend("isr unexpected ");
+		i2cInt_isr_dump(status);
+	}
+	if (status & I2C_MIMR_ARBLOSTIM) {
+		UARTsend("isr: arblost\r\n");
+	}
+	if (status & I2C_MIMR_CLKIM) {
+		UARTsend("isr: clk timeout\r\n");
+	}
+}
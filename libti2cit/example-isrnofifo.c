@@ -11,6 +11,7 @@
 #include "driverlib/gpio.h"
 #include "driverlib/i2c.h"
 #include "driverlib/rom.h"
+#include "driverlib/timer.h"
 
 static void i2cInt_isr_dump(uint32_t status)
 {
@@ -78,11 +79,11 @@ static void scan_next_addr(libti2cit_int_st * st, uint32_t status)
 	if (i2c2.scan_found) {
 		// ACK received at i2c2.scan_addr: device found
 		i2c2.scan_found = 0;
-		ROM_UARTCharPut(UART0_BASE, '[');
+		UARTputc('[');
 		char str[8];
 		u8tohex(str, i2c2.scan_addr);
 		UARTsend(str);
-		ROM_UARTCharPut(UART0_BASE, ']');
+		UARTputc(']');
 
 		i2c2.ti2cit.user_cb = 0;
 		i2c2.talk_count = 0;
@@ -115,9 +116,16 @@ uint8_t read_buf[4];
 static void talk_to_device_read(libti2cit_int_st * st, uint32_t status);
 static void talk_to_device_cb(libti2cit_int_st * st, uint32_t status)
 {
-	/* TODO: to really be an interrupt example, set up a timer interrupt and run from the timer isr */
-	ROM_SysCtlDelay(i2c2.sysclock/300);
+	if (!(status & I2C_MIMR_STOPIM)) return;	// a NACK shows up again when the read is NACKed
 
+	// the device is measuring: Timer 0A interrupts in 10ms and timer0Int_isrnofifo() starts the read
+	ROM_TimerConfigure(TIMER0_BASE, TIMER_CFG_ONE_SHOT);
+	ROM_TimerLoadSet(TIMER0_BASE, TIMER_A, i2c2.sysclock/100);
+	ROM_TimerEnable(TIMER0_BASE, TIMER_A);
+}
+
+void timer0Int_isrnofifo()
+{
 	i2c2.ti2cit.buf = read_buf;
 	i2c2.ti2cit.user_cb = talk_to_device_read;
 	i2c2.ti2cit.len = sizeof(read_buf);
@@ -150,7 +158,7 @@ static void talk_to_device_read(libti2cit_int_st * st, uint32_t status)
 	}
 
 	i2c2.ti2cit.user_cb = 0;
-	ROM_UARTCharPut(UART0_BASE, ' ');
+	UARTputc(' ');
 	uint32_t v = 0;
 	char str[32];
 	uint32_t i;
@@ -196,6 +204,20 @@ static void talk_to_device_read(libti2cit_int_st * st, uint32_t status)
 	scan_next_addr(&i2c2.ti2cit, I2C_MIMR_STOPIM);
 }
 
+/* the I2C7 slave is two devices, each a bank of 4 registers holding a reading in the same format as the HIH6130
+ * libti2cit_s_isr_isr() answers the master by itself: nothing here may print, the master is waiting
+ */
+static uint8_t slave_regs[4] = { 0x1a, 0x2b, 0x63, 0x90 };
+static uint8_t slave_regs2[4] = { 0x0c, 0x80, 0x5d, 0x40 };
+static libti2cit_s_regs_st slave_bank;
+static libti2cit_s_regs_st slave_bank2;
+static volatile uint32_t slave_nwritten;
+
+static void slave_written(libti2cit_int_st * st, uint32_t first, uint32_t n)
+{
+	slave_nwritten += n;	// main_isrnofifo() can look at slave_regs[first..] when it is not busy
+}
+
 void memzero(void * dst, uint32_t len)
 {
 	uint8_t * p = dst;
@@ -213,9 +235,20 @@ void main_isrnofifo(uint32_t sysclock)
 	i2c7.ti2cit.base = I2C7_BASE;
 	i2c7.sysclock = sysclock;
 
-	// initialize I2C7 slave and turn on loopback mode
+	// initialize I2C7 slave at two addresses and turn on loopback mode
 	uint8_t slave_addr = 0x7f;
 	ROM_I2CSlaveInit(i2c7.ti2cit.base, slave_addr);
+	ROM_I2CSlaveAddressSet(i2c7.ti2cit.base, 1, slave_addr - 1);
+	memzero(&slave_bank, sizeof(slave_bank));
+	slave_bank.regs = slave_regs;
+	slave_bank.nregs = sizeof(slave_regs);
+	slave_bank.wr_cb = slave_written;
+	i2c7.ti2cit.regs = &slave_bank;
+	memzero(&slave_bank2, sizeof(slave_bank2));
+	slave_bank2.regs = slave_regs2;
+	slave_bank2.nregs = sizeof(slave_regs2);
+	slave_bank2.wr_cb = slave_written;
+	i2c7.ti2cit.regs2 = &slave_bank2;
 
 	libti2cit_m_int_clear(&i2c2.ti2cit);
 	libti2cit_s_int_clear(&i2c7.ti2cit);
@@ -223,14 +256,18 @@ void main_isrnofifo(uint32_t sysclock)
 	ROM_IntMasterEnable();
 	ROM_IntEnable(INT_I2C2);
 	ROM_IntEnable(INT_I2C7);
+	ROM_IntPrioritySet(INT_TIMER0A, 0);	// the same priority as INT_I2C2: the two never interrupt each other
+	ROM_IntPrioritySet(INT_I2C2, 0);
+	ROM_TimerIntEnable(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+	ROM_IntEnable(INT_TIMER0A);
 	ROM_I2CMasterIntEnableEx(i2c2.ti2cit.base, I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM | I2C_MIMR_IM);
-	ROM_I2CSlaveIntEnableEx(i2c7.ti2cit.base, I2C_SIMR_STARTIM | I2C_SIMR_STOPIM | I2C_SIMR_DATAIM);
+	ROM_I2CSlaveIntEnableEx(i2c7.ti2cit.base, I2C_SIMR_STOPIM | I2C_SIMR_DATAIM);
 
 	scan_start();
 
 	uint32_t time_out = 500lu;
 	for (; i2c2.scan_addr <= 127 && time_out; ROM_SysCtlDelay(sysclock/10000), time_out--) {
-		ROM_UARTCharPut(UART0_BASE, '.');
+		UARTputc('.');
 	}
 
 	if (!time_out) {
@@ -238,12 +275,23 @@ void main_isrnofifo(uint32_t sysclock)
 	} else {
 		UARTsend("done\r\n");
 	}
+	char str[16];
+	UARTsend("slave: registers written=");
+	printf_int32(str, slave_nwritten);
+	UARTsend(str);
+	UARTsend(" read=");
+	printf_int32(str, slave_bank.nread + slave_bank2.nread);
+	UARTsend(str);
+	UARTsend("\r\n");
 
 	ROM_I2CMasterIntDisable(i2c2.ti2cit.base);
 	ROM_I2CSlaveDisable(i2c7.ti2cit.base);
 	ROM_I2CSlaveIntDisable(i2c7.ti2cit.base);
 	ROM_IntDisable(INT_I2C2);
 	ROM_IntDisable(INT_I2C7);
+	ROM_TimerDisable(TIMER0_BASE, TIMER_A);
+	ROM_TimerIntDisable(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+	ROM_IntDisable(INT_TIMER0A);
 	ROM_IntMasterDisable();
 
 	libti2cit_m_int_clear(&i2c2.ti2cit);
@@ -265,102 +313,7 @@ void i2c2Int_isrnofifo()
 	}
 }
 
-static void i2cInt_simr_dump(uint32_t status)
-{
-	static char buf[] = "status=0000";
-	u16tohex(&buf[7], status);
-	buf[11] = 0;
-	UARTsend(buf);
-
-	if (status & I2C_SIMR_DATAIM) UARTsend(" RIS");
-	if (status & I2C_SIMR_STARTIM) UARTsend(" start");
-	if (status & I2C_SIMR_STOPIM) UARTsend(" stop");
-	if (status & I2C_SIMR_DMARXIM) UARTsend(" dmaRX");
-	if (status & I2C_SIMR_DMATXIM) UARTsend(" dmaTX");
-	if (status & I2C_SIMR_TXIM) UARTsend(" tx");
-	if (status & I2C_SIMR_RXIM) UARTsend(" rx");
-	if (status & I2C_SIMR_TXFEIM) UARTsend(" txFE");
-	if (status & I2C_SIMR_RXFFIM) UARTsend(" rxFF");
-
-	UARTsend("\r\n");
-}
-
-uint8_t slave_buf[4];
-uint32_t slave_buf_pos = 0;
-uint8_t master_buf[4];
-uint32_t master_buf_pos = 0;
 void i2c7Int_isrnofifo()
 {
-	uint32_t status = libti2cit_s_isr_isr(&i2c7.ti2cit);
-	if (status == LIBTI2CIT_ISR_S_START) {
-		UARTsend("starting\r\n");
-		master_buf_pos = 0;
-		slave_buf_pos = 0;
-		return;
-	}
-	if (status == LIBTI2CIT_ISR_S_STOP) {
-		UARTsend("stopped\r\n");
-		master_buf_pos = 0;
-		slave_buf_pos = 0;
-		return;
-	}
-	if (status & LIBTI2CIT_ISR_S_START) {
-		UARTsend("ign S_START ");
-	}
-	if (status & LIBTI2CIT_ISR_S_STOP) {
-		UARTsend("ign S_STOP ");
-	}
-	if (status & I2C_SCSR_QCMDST) {
-		master_buf_pos = 0;
-		slave_buf_pos = 0;
-
-		if (status & I2C_SCSR_QCMDRW) {
-			// master is requesting to read bytes
-			UARTsend("s_QUICK read\r\n");
-		} else {
-			UARTsend("s_QUICK read\r\n");
-		}
-
-		// is it possible to NAK a QCMD?
-		uint32_t sack = (HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) | I2C_SACKCTL_ACKOEN) & (~I2C_SACKCTL_ACKOVAL);
-		HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) = sack | I2C_SACKCTL_ACKOVAL;	// send NACK
-		HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) = (sack | I2C_SACKCTL_ACKOVAL) & (~I2C_SACKCTL_ACKOEN);
-	} else if (status & I2C_SCSR_QCMDRW) {
-		UARTsend("s_QUICK read outside s_QUICK ");
-	}
-
-	if (status & I2C_SCSR_RREQ) {
-		if (status & I2C_SCSR_FBR) {
-			// start of a buf from master
-			master_buf_pos = 0;
-			slave_buf_pos = 0;
-			UARTsend("s_1st ");
-		}
-		// read the byte in the buf
-		uint32_t sack = (HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) | I2C_SACKCTL_ACKOEN) & (~I2C_SACKCTL_ACKOVAL);
-		if (master_buf_pos >= sizeof(master_buf)) {
-			(void) HWREG(i2c7.ti2cit.base + I2C_O_SDR);
-			HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) = sack | I2C_SACKCTL_ACKOVAL;	// send NACK
-			UARTsend("s_NACK\r\n");
-		} else {
-			master_buf[master_buf_pos++] = HWREG(i2c7.ti2cit.base + I2C_O_SDR);
-			HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) = sack;	// send ACK
-			HWREG(i2c7.ti2cit.base + I2C_O_SACKCTL) = sack & (~I2C_SACKCTL_ACKOEN);
-			UARTsend("s_ACK\r\n");
-		}
-		// signal the non-isr code to look at the buf
-	}
-	if (status & I2C_SCSR_TREQ) {
-		UARTsend("s_TREQ ");
-		i2cInt_simr_dump(HWREG(i2c7.ti2cit.base + I2C_O_SIMR));
-
-		/* NOTE: it is a bad idea to do anything more complicated than copying data out of a buffer here
-		 * the i2c master can time out if you delay long enough before responding to a _TREQ
-		 */
-		HWREG(i2c7.ti2cit.base + I2C_O_SDR) = (slave_buf_pos >= sizeof(slave_buf)) ? 0xff : (/*slave_buf[*/slave_buf_pos++);
-		// TODO: master can NACK
-	}
-	if (status & LIBTI2CIT_ISR_UNEXPECTED) {
-		UARTsend("isr_s unexpected\r\n");
-	}
+	libti2cit_s_isr_isr(&i2c7.ti2cit);
 }
@@ -11,13 +11,17 @@
  * set IPATH in Makefile to point to the directory where the tivaware directory can be found
  */
 #include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
+#include "inc/hw_uart.h"
+#include "driverlib/interrupt.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/rom.h"
 #include "driverlib/i2c.h"
 #include "driverlib/uart.h"
 #include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
 #include "driverlib/gpio.h"
 
 #include "inc/hw_i2c.h"
@@ -55,11 +59,97 @@ void printf_int32(char * out, int32_t n)
 	*out = 0;
 }
 
-void UARTsend(char * str)
+/* UARTsend() does not wait for the UART: the text goes in log_ring and the UART0 TX interrupt sends it
+ * it is called from the i2c interrupt handlers, where ROM_UARTCharPut() would spin for 87us per character at 115200
+ *
+ * any number of writers, at any interrupt priority, reserve room with a compare-and-swap on log_reserve and copy
+ * their text in. The outermost writer (log_writers drops to 0) then publishes everything reserved so far by moving
+ * log_commit: interrupts nest, so every writer that interrupted it has finished copying by then. The UART0 handler
+ * is the only reader, it sends from log_tail up to log_commit
+ *
+ * when log_ring is full the whole message is dropped and counted in log_dropped and log_dropped_bytes
+ * the indices run freely and wrap at 2^32, LOG_RING_LEN must be a power of 2
+ */
+#define LOG_RING_LEN (1024)
+static char log_ring[LOG_RING_LEN];
+static volatile uint32_t log_reserve;
+static volatile uint32_t log_commit;
+static volatile uint32_t log_tail;
+static volatile uint32_t log_writers;
+volatile uint32_t log_dropped;
+volatile uint32_t log_dropped_bytes;
+
+/* move bytes from log_ring into the UART TX FIFO until one of them runs out
+ * only one caller at a time: uart0IntHandler(), or UARTflush() with INT_UART0 disabled
+ */
+static void log_drain()
 {
-	while (*str) {
-		ROM_UARTCharPut(UART0_BASE, *str++);
+	uint32_t tail = log_tail;
+	uint32_t commit = __atomic_load_n(&log_commit, __ATOMIC_ACQUIRE);
+	while (tail != commit && !(HWREG(UART0_BASE + UART_O_FR) & UART_FR_TXFF)) {
+		HWREG(UART0_BASE + UART_O_DR) = log_ring[tail & (LOG_RING_LEN - 1)];	// a.k.a. ROM_UARTCharPutNonBlocking()
+		tail++;
 	}
+	__atomic_store_n(&log_tail, tail, __ATOMIC_RELEASE);
+}
+
+static void log_publish()
+{
+	if (__atomic_sub_fetch(&log_writers, 1, __ATOMIC_ACQ_REL)) return;	// an outer writer will publish this
+
+	// an interrupt after the decrement may have published more already: never move log_commit backwards
+	uint32_t r = __atomic_load_n(&log_reserve, __ATOMIC_ACQUIRE);
+	uint32_t c = __atomic_load_n(&log_commit, __ATOMIC_RELAXED);
+	while ((int32_t) (r - c) > 0 &&
+		!__atomic_compare_exchange_n(&log_commit, &c, r, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) ;
+
+	// the TX interrupt only fires when the FIFO drains past its trigger level: start it by hand in case the UART is idle
+	ROM_IntPendSet(INT_UART0);
+}
+
+static void log_write(const char * str, uint32_t len)
+{
+	__atomic_add_fetch(&log_writers, 1, __ATOMIC_ACQ_REL);
+	uint32_t r = __atomic_load_n(&log_reserve, __ATOMIC_RELAXED);
+	do {
+		if (r + len - __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE) > LOG_RING_LEN) {
+			__atomic_add_fetch(&log_dropped, 1, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&log_dropped_bytes, len, __ATOMIC_RELAXED);
+			log_publish();
+			return;
+		}
+	} while (!__atomic_compare_exchange_n(&log_reserve, &r, r + len, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	while (len--) log_ring[r++ & (LOG_RING_LEN - 1)] = *str++;
+	log_publish();
+}
+
+void UARTsend(char * str)
+{
+	uint32_t len = 0;
+	while (str[len]) len++;
+	log_write(str, len);
+}
+
+void UARTputc(char c)
+{
+	log_write(&c, 1);
+}
+
+/* wait until everything published so far is in the UART TX FIFO
+ * the examples turn off interrupts when they finish: this works without them, call it before blocking on the UART
+ */
+void UARTflush()
+{
+	ROM_IntDisable(INT_UART0);
+	while (log_tail != log_commit) log_drain();
+	ROM_IntEnable(INT_UART0);
+}
+
+void uart0IntHandler()
+{
+	ROM_UARTIntClear(UART0_BASE, ROM_UARTIntStatus(UART0_BASE, true));
+	log_drain();
 }
 
 
@@ -71,6 +161,10 @@ extern void i2c7Int_isrnofifo();
 extern void main_isr(uint32_t sysclock);
 extern void i2c2Int_isr();
 extern void i2c7Int_isr();
+extern void main_isrdma(uint32_t sysclock);
+extern void i2c2Int_isrdma();
+extern void timer0Int_isrnofifo();
+extern void timer0Int_isr();
 
 // select who receives i2c interrupts. Note: The hardware can do this for you in the NVIC, much faster.
 uint32_t choice;
@@ -80,7 +174,7 @@ void i2c2IntHandler()
 	case '1': UARTsend("bad i2c2 int\r\n"); break;
 	case '2': i2c2Int_isrnofifo(); break;
 	case '3': i2c2Int_isr(); break;
-	case '4':
+	case '4': i2c2Int_isrdma(); break;
 	default: UARTsend("unhandled i2c2 int\r\n"); break;
 	}
 }
@@ -94,6 +188,15 @@ void i2c7IntHandler()
 	default: UARTsend("unhandled i2c7 int\r\n"); break;
 	}
 }
+void timer0AIntHandler()
+{
+	ROM_TimerIntClear(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+	switch (choice) {
+	case '2': timer0Int_isrnofifo(); break;
+	case '3': timer0Int_isr(); break;
+	default: UARTsend("unhandled timer0 int\r\n"); break;
+	}
+}
 
 
 int main(void) {
@@ -101,17 +204,20 @@ int main(void) {
 	do {
 		sysclock = ROM_SysCtlClockFreqSet(SYSCTL_XTAL_25MHZ | SYSCTL_OSC_MAIN | SYSCTL_USE_PLL | SYSCTL_CFG_VCO_480, 120*1000*1000);
 	} while (!sysclock);
+	libti2cit_trace_clear();
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_I2C2);
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_I2C7);
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOL);
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
 	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
+	ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
 	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_I2C2)) ;
 	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOL)) ;
 	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOD)) ;
 	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOA)) ;
 	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_UART0)) ;
+	while (!ROM_SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER0)) ;
 	ROM_GPIOPinConfigure(GPIO_PL0_I2C2SDA);
 	ROM_GPIOPinConfigure(GPIO_PL1_I2C2SCL);
 	ROM_GPIOPinConfigure(GPIO_PD1_I2C7SDA);
@@ -132,6 +238,10 @@ int main(void) {
 	ROM_GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
 	ROM_UARTConfigSetExpClk(UART0_BASE, sysclock, 115200,
 		UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE);
+	ROM_UARTFIFOLevelSet(UART0_BASE, UART_FIFO_TX2_8, UART_FIFO_RX4_8);
+	ROM_UARTIntEnable(UART0_BASE, UART_INT_TX);
+	ROM_IntPrioritySet(INT_UART0, 0xe0);	// below the i2c interrupts: logging never delays them
+	ROM_IntEnable(INT_UART0);
 
 	for (;;) {
 		UARTsend("\r\n"
@@ -142,26 +252,30 @@ int main(void) {
 			"  4. Interrupts+FIFO+uDMA\r\n"
 			"\r\n");
 
+		if (log_dropped) {
+			char str[16];
+			UARTsend("log: dropped ");
+			printf_int32(str, log_dropped);
+			UARTsend(str);
+			UARTsend(" messages, ");
+			printf_int32(str, log_dropped_bytes);
+			UARTsend(str);
+			UARTsend(" bytes\r\n");
+		}
+
 		uint32_t bad_key = 0;
 		do {
 			UARTsend("Choice: ");
+			UARTflush();
 			choice = ROM_UARTCharGet(UART0_BASE);
-			ROM_UARTCharPut(UART0_BASE, choice);
+			UARTputc(choice);
 			UARTsend("\r\n");
 
 			switch (choice) {
 			case '1': main_poll(sysclock); break;
 			case '2': main_isrnofifo(sysclock); break;
 			case '3': main_isr(sysclock); break;
-			case '4':
-				UARTsend("about to set MCR\r\n");
-				HWREG(I2C7_BASE + I2C_O_MCR) |= I2C_MCR_SFE;
-				UARTsend("about to set SCSR\r\n");
-				HWREG(I2C7_BASE + I2C_O_SCSR) = I2C_SCSR_DA;
-				UARTsend("about to set SOAR\r\n");
-				HWREG(I2C7_BASE + I2C_O_SOAR) = 0x7f;
-				UARTsend("done\r\n");
-				break;
+			case '4': main_isrdma(sysclock); break;
 
 			default:
 				UARTsend("Unknown key pressed.\r\n");
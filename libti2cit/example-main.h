@@ -2,3 +2,7 @@ void u8tohex(char * out, uint32_t n);
 void u16tohex(char * out, uint32_t n);
 void printf_int32(char * out, int32_t n);
 void UARTsend(char * str);
+void UARTputc(char c);
+void UARTflush();
+extern volatile uint32_t log_dropped;
+extern volatile uint32_t log_dropped_bytes;
@@ -46,6 +46,8 @@ eep read 1f r81 r00 r00 - custom ID 2
 total customizable eeprom: 19 bytes
 */
 
+static libti2cit_nvm_st hih_nvm;
+
 static uint8_t hih_command_mode_retry(uint32_t sysclock, uint32_t addr, char * str)
 {
 	static const uint8_t hih_cmd_mode[] = { 0xa0, 0, 0 };
@@ -58,56 +60,43 @@ static uint8_t hih_command_mode_retry(uint32_t sysclock, uint32_t addr, char * s
 		return 1;
 	}
 
-	uint8_t hih_eep_read[3] = { 0, 0, 0 };
-	uint8_t hih_eep_data[3] = { 0, 0, 0 };
+	// each eeprom command is followed by reads of the status byte until the sensor is done: no fixed delays
+	hih_nvm.st.base = I2C2_BASE;
+	hih_nvm.addr = addr;
+	hih_nvm.type = LIBTI2CIT_NVM_HIH;
+	hih_nvm.timeout = sysclock/50;	// give up after 20ms, the datasheet says a write takes 12ms
+	uint8_t hih_eep_data[0x20 * 2];
 	uint32_t eep;
 
 #if 0
-	hih_eep_read[0] = 0x17 | 0x40;
-	hih_eep_read[1] = 0x9a;
-	hih_eep_read[2] = 0xcb;
+	static const uint8_t hih_eep_write[2] = { 0x9a, 0xcb };
 	UARTsend("eep wr ");
-	if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1), sizeof(hih_eep_read)/sizeof(hih_eep_read[0]), hih_eep_read)) {
-		UARTsend("nack\r\n");
-		return 1;
-	}
-
-	hih_eep_read[1] = 0;
-	hih_eep_read[2] = 0;
-	ROM_SysCtlDelay(sysclock/832);	// wait 12ms for response
-	if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1) | 1, 0, 0)) {
-		UARTsend("status nack\r\n");
-		return 1;
-	}
-	if (libti2cit_m_sync_recv(I2C2_BASE, 1, hih_eep_data)) return 1;
-
-	UARTsend(" r");
-	u8tohex(str, hih_eep_data[0]);	// must be 0x81 for success, 0x80 means still busy, 0x82 is illegal operation, all else are device failure
+	r = libti2cit_nvm_sync_write(&hih_nvm, 0x17 * 2, sizeof(hih_eep_write)/sizeof(hih_eep_write[0]), hih_eep_write);
+	u8tohex(str, r);	// 0 for success, LIBTI2CIT_NVM_FAIL if the status byte was not 0x81 (0x82 is illegal operation)
 	UARTsend(str);
 	UARTsend("\r\n");
+	if (r) return 1;
 #endif
 
+	// all 32 words in one call
+	r = libti2cit_nvm_sync_read(&hih_nvm, 0, sizeof(hih_eep_data)/sizeof(hih_eep_data[0]), hih_eep_data);
+	if (r) {
+		UARTsend("eepread fail ");
+		u8tohex(str, r);
+		UARTsend(str);
+		UARTsend("\r\n");
+		return 1;
+	}
+
 	for (eep = 0; eep < 0x20; eep++) {
 		UARTsend("eep read ");
 		u8tohex(str, eep);
 		UARTsend(str);
 
-		hih_eep_read[0] = eep;
-		if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1), sizeof(hih_eep_read)/sizeof(hih_eep_read[0]), hih_eep_read)) {
-			UARTsend("eepread nack\r\n");
-			return 1;
-		}
-		ROM_SysCtlDelay(sysclock/10000);	// wait 100us for response
-		if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1) | 1, 0, 0)) {
-			UARTsend("eepread nack\r\n");
-			return 1;
-		}
-		if (libti2cit_m_sync_recv(I2C2_BASE, sizeof(hih_eep_data)/sizeof(hih_eep_data[0]), hih_eep_data)) return 1;
-
 		uint32_t j;
-		for (j = 0; j < 3; j++) {
+		for (j = 0; j < 2; j++) {
 			UARTsend(" r");
-			u8tohex(str, hih_eep_data[j]);
+			u8tohex(str, hih_eep_data[eep * 2 + j]);
 			UARTsend(str);
 		}
 		UARTsend("\r\n");
@@ -126,7 +115,8 @@ static void hih_command_mode_exit(uint32_t sysclock, uint32_t addr, char * str)
 		UARTsend("\r\n");
 	}
 
-	ROM_SysCtlDelay(sysclock/25);		// wait 40ms for device to exit command mode
+	// no need to wait for the device to leave command mode: main_poll() moves on to the next address, and a
+	// measurement read before the device is back would only come back stale
 }
 
 static uint8_t hih_command_mode(uint32_t sysclock, uint32_t addr, char * str)
@@ -154,11 +144,11 @@ void main_poll(uint32_t sysclock)
 	for (addr = 1; addr < 128; addr++) {
 		if (libti2cit_m_sync_send(I2C2_BASE, addr << 1, 0 /*len*/, 0 /*buf*/)) continue;
 
-		ROM_UARTCharPut(UART0_BASE, '[');
+		UARTputc('[');
 		char str[32];
 		u8tohex(str, addr);
 		UARTsend(str);
-		ROM_UARTCharPut(UART0_BASE, ']');
+		UARTputc(']');
 
 		uint32_t c, v = 0;
 		for (c = 0; c < 10; c++) {
@@ -168,7 +158,7 @@ void main_poll(uint32_t sysclock)
 			if (libti2cit_m_sync_send(I2C2_BASE, (addr << 1) | 1, 0 /*len*/, 0 /*buf*/)) break;
 			if (libti2cit_m_sync_recv(I2C2_BASE, sizeof(buf)/sizeof(buf[0]), buf)) break;
 
-			ROM_UARTCharPut(UART0_BASE, ' ');
+			UARTputc(' ');
 			uint32_t i;
 			for (i = 0; i < sizeof(buf)/sizeof(buf[0]); i++) {
 				v <<= 8;
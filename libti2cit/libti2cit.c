@@ -1,47 +1,388 @@
 #include <stdbool.h>
 #include <stdint.h>
+
+#ifdef LIBTI2CIT_PROF
+/* compile every public function as libti2cit_..._unprof(): the wrappers at the end of this file time them
+ */
+#define libti2cit_m_sync_send libti2cit_m_sync_send_unprof
+#define libti2cit_m_sync_recv libti2cit_m_sync_recv_unprof
+#define libti2cit_m_sync_recvpart libti2cit_m_sync_recvpart_unprof
+#define libti2cit_m_sync_send_to libti2cit_m_sync_send_to_unprof
+#define libti2cit_m_sync_recv_to libti2cit_m_sync_recv_to_unprof
+#define libti2cit_m_sync_recvpart_to libti2cit_m_sync_recvpart_to_unprof
+#define libti2cit_m_int_clear libti2cit_m_int_clear_unprof
+#define libti2cit_m_isr_isr libti2cit_m_isr_isr_unprof
+#define libti2cit_m_isr_nofifo_send libti2cit_m_isr_nofifo_send_unprof
+#define libti2cit_m_isr_nofifo_recv libti2cit_m_isr_nofifo_recv_unprof
+#define libti2cit_m_isr_nofifo_recvpart libti2cit_m_isr_nofifo_recvpart_unprof
+#define libti2cit_m_isr_send libti2cit_m_isr_send_unprof
+#define libti2cit_m_isr_recv libti2cit_m_isr_recv_unprof
+#define libti2cit_m_isr_recvpart libti2cit_m_isr_recvpart_unprof
+#define libti2cit_m_isrdma_send libti2cit_m_isrdma_send_unprof
+#define libti2cit_m_isrdma_recv libti2cit_m_isrdma_recv_unprof
+#define libti2cit_m_isrdma_recvpart libti2cit_m_isrdma_recvpart_unprof
+#define libti2cit_m_isr_queue libti2cit_m_isr_queue_unprof
+#define libti2cit_m_scan libti2cit_m_scan_unprof
+#define libti2cit_mgr_submit libti2cit_mgr_submit_unprof
+#define libti2cit_mgr_isr libti2cit_mgr_isr_unprof
+#define libti2cit_m_recover libti2cit_m_recover_unprof
+#define libti2cit_s_int_clear libti2cit_s_int_clear_unprof
+#define libti2cit_s_isr_isr libti2cit_s_isr_isr_unprof
+#define libti2cit_s_isr_send libti2cit_s_isr_send_unprof
+#define libti2cit_s_isr_recv libti2cit_s_isr_recv_unprof
+#define libti2cit_s_isrdma_send libti2cit_s_isrdma_send_unprof
+#define libti2cit_s_isrdma_recv libti2cit_s_isrdma_recv_unprof
+#define libti2cit_m_sync_hs libti2cit_m_sync_hs_unprof
+#define libti2cit_m_sync_hs_to libti2cit_m_sync_hs_to_unprof
+#define libti2cit_m_sync_send_pec libti2cit_m_sync_send_pec_unprof
+#define libti2cit_m_sync_recv_pec libti2cit_m_sync_recv_pec_unprof
+#define libti2cit_m_sync_recvpart_pec libti2cit_m_sync_recvpart_pec_unprof
+#define libti2cit_nvm_sync_read libti2cit_nvm_sync_read_unprof
+#define libti2cit_nvm_sync_write libti2cit_nvm_sync_write_unprof
+#define libti2cit_nvm_sync_wait libti2cit_nvm_sync_wait_unprof
+#define libti2cit_nvm_isr_read libti2cit_nvm_isr_read_unprof
+#define libti2cit_nvm_isr_write libti2cit_nvm_isr_write_unprof
+#define libti2cit_nvm_isr_wait libti2cit_nvm_isr_wait_unprof
+#define libti2cit_sched_tick libti2cit_sched_tick_unprof
+#define libti2cit_pt_xfer libti2cit_pt_xfer_unprof
+#define libti2cit_pt_tick libti2cit_pt_tick_unprof
+#define libti2cit_pt_resume libti2cit_pt_resume_unprof
+#define libti2cit_m_syncfifo_send libti2cit_m_syncfifo_send_unprof
+#define libti2cit_m_syncfifo_recv libti2cit_m_syncfifo_recv_unprof
+#define libti2cit_m_syncwfi_send libti2cit_m_syncwfi_send_unprof
+#define libti2cit_m_syncwfi_recv libti2cit_m_syncwfi_recv_unprof
+#define libti2cit_m_syncwfi_recvpart libti2cit_m_syncwfi_recvpart_unprof
+#define libti2cit_m_speed libti2cit_m_speed_unprof
+#define libti2cit_m_speed_table libti2cit_m_speed_table_unprof
+#define libti2cit_mgr_init libti2cit_mgr_init_unprof
+#define libti2cit_mgr_util libti2cit_mgr_util_unprof
+#define libti2cit_mgr_util_clear libti2cit_mgr_util_clear_unprof
+#define libti2cit_sched_start libti2cit_sched_start_unprof
+#define libti2cit_pt_start libti2cit_pt_start_unprof
+#define libti2cit_m_syncwfi_meter libti2cit_m_syncwfi_meter_unprof
+#define libti2cit_m_syncwfi_slept libti2cit_m_syncwfi_slept_unprof
+#endif
 #include "libti2cit.h"
 
 #include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
 #include "inc/hw_i2c.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_nvic.h"
+#include "driverlib/cpu.h"
 #include "driverlib/i2c.h"
 #include "driverlib/rom.h"
+#include "driverlib/udma.h"
+
+
+/* cpu cycle counter for the libti2cit_m_sync_..._to() timeouts: the Cortex-M4 DWT CYCCNT counts every system clock
+ * these are core registers (not in tivaware's inc/ headers) and are the same on every Cortex-M3/M4
+ */
+#define LIBTI2CIT_DEMCR (0xE000EDFC)
+#define LIBTI2CIT_DEMCR_TRCENA (0x01000000)
+#define LIBTI2CIT_DWT_CTRL (0xE0001000)
+#define LIBTI2CIT_DWT_CTRL_CYCCNTENA (0x00000001)
+#define LIBTI2CIT_DWT_CYCCNT (0xE0001004)
+
+#define LIBTI2CIT_MRIS_TIMEOUT (0x80000000)	// not an I2C_O_MRIS bit: libti2cit_mris_wait() ran out of time
+
+/* start the clock for a timeout: turn on CYCCNT if the debugger has not, and return the start time
+ * timeout == 0 means wait forever and does not touch the DWT
+ */
+static uint32_t libti2cit_cyccnt_start(uint32_t timeout) {
+	if (!timeout || timeout == LIBTI2CIT_WFI) return 0;
+	if (!(HWREG(LIBTI2CIT_DWT_CTRL) & LIBTI2CIT_DWT_CTRL_CYCCNTENA)) {
+		HWREG(LIBTI2CIT_DEMCR) |= LIBTI2CIT_DEMCR_TRCENA;
+		HWREG(LIBTI2CIT_DWT_CTRL) |= LIBTI2CIT_DWT_CTRL_CYCCNTENA;
+	}
+	return HWREG(LIBTI2CIT_DWT_CYCCNT);
+}
+
+/* unsigned subtraction, so CYCCNT wrapping around (every 35 seconds at 120 MHz) does not matter */
+static uint32_t libti2cit_expired(uint32_t t0, uint32_t timeout) {
+	return timeout && (HWREG(LIBTI2CIT_DWT_CYCCNT) - t0 > timeout);
+}
+
+#ifdef LIBTI2CIT_PROF
+static libti2cit_prof_st libti2cit_prof[LIBTI2CIT_PROF_N];
+
+/* count one call of id that started at CYCCNT t0 */
+static void libti2cit_prof_add(uint32_t id, uint32_t t0)
+{
+	uint32_t cycles = HWREG(LIBTI2CIT_DWT_CYCCNT) - t0;
+	libti2cit_prof_st * p = &libti2cit_prof[id];
+	uint32_t k = cycles ? 31 - __builtin_clz(cycles) : 0;	// log2, a single CLZ instruction
+	if (k >= LIBTI2CIT_PROF_NBIN) k = LIBTI2CIT_PROF_NBIN - 1;
+	p->bin[k]++;
+	if (!p->count || cycles < p->min) p->min = cycles;
+	if (cycles > p->max) p->max = cycles;
+	p->total += cycles;
+	p->count++;
+}
+#endif
+
+#ifndef LIBTI2CIT_NO_TRACE
+typedef char libti2cit_trace_len_check[(LIBTI2CIT_TRACE_LEN & (LIBTI2CIT_TRACE_LEN - 1)) ? -1 : 1];
+libti2cit_trace_st libti2cit_trace = { LIBTI2CIT_TRACE_MAGIC, LIBTI2CIT_TRACE_LEN, 0, 0 };
+
+/* add one event to libti2cit_trace, see libti2cit.h for what goes in status
+ * the slot is claimed with one atomic add (LDREX/STREX on the Cortex-M4), so an interrupt at a higher priority can
+ * add its own events in the middle of this one without either of them being lost
+ */
+static inline void libti2cit_trace_add(uint32_t what, libti2cit_int_st * st, uint32_t state, uint32_t status)
+{
+	if (libti2cit_trace.stop) return;
+	uint32_t i = __atomic_fetch_add(&libti2cit_trace.head, 1, __ATOMIC_RELAXED) & (LIBTI2CIT_TRACE_LEN - 1);
+	libti2cit_trace_ev * e = &libti2cit_trace.ev[i];
+	e->cyccnt = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	e->what = what;
+	e->base = st->base >> 12;
+	e->state = state;
+	e->addr = st->addr;
+	e->status = status;
+	e->count = st->nread;
+}
+#define LIBTI2CIT_TRACE(what, st, state, status) libti2cit_trace_add(LIBTI2CIT_TRACE_##what, st, state, status)
+#else
+#define LIBTI2CIT_TRACE(what, st, state, status) do { (void) (state); } while (0)
+#endif
+
+/* SMBus PEC: CRC-8, polynomial x^8 + x^2 + x + 1, over every address and data byte of the transaction
+ * the TM4C129 CRC module only has 16 and 32 bit polynomials, so this is the byte-at-a-time table (256 bytes of flash)
+ */
+static const uint8_t libti2cit_pec_table[256] = {
+	0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
+	0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
+	0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
+	0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
+	0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
+	0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
+	0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
+	0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
+	0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
+	0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
+	0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
+	0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
+	0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
+	0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
+	0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
+	0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3,
+};
+
+static inline uint8_t libti2cit_pec_add(uint8_t crc, uint8_t b)
+{
+	return libti2cit_pec_table[crc ^ b];
+}
+
+/* the NVIC interrupt number of the controller at base, 0 if base is not an i2c controller */
+static uint32_t libti2cit_int_num(uint32_t base) {
+	switch (base) {
+	case I2C0_BASE: return INT_I2C0;
+	case I2C1_BASE: return INT_I2C1;
+	case I2C2_BASE: return INT_I2C2;
+	case I2C3_BASE: return INT_I2C3;
+	case I2C4_BASE: return INT_I2C4;
+	case I2C5_BASE: return INT_I2C5;
+	case I2C6_BASE: return INT_I2C6;
+	case I2C7_BASE: return INT_I2C7;
+	case I2C8_BASE: return INT_I2C8;
+	case I2C9_BASE: return INT_I2C9;
+	}
+	return 0;
+}
+
+/* the libti2cit_m_syncwfi_meter() meters, one per base */
+static libti2cit_wfi_st * libti2cit_wfi_list;
+
+/* the meter of base, 0 for none */
+static libti2cit_wfi_st * libti2cit_wfi_find(uint32_t base) {
+	libti2cit_wfi_st * w = libti2cit_wfi_list;
+	while (w && w->private_base != base) w = w->private_next;
+	return w;
+}
 
+/* libti2cit_mris_wait() with timeout == LIBTI2CIT_WFI: sleep in WFI until the bits in mask are set, then ACK them
+ * only the bits still missing are unmasked in I2C_O_MIMR, and only for the WFI: the interrupt line goes up when the
+ * byte is done and wakes the core. PRIMASK is set around the I2C_O_MRIS check and the WFI, so no handler runs (WFI
+ * still wakes on a pending interrupt) and an interrupt that comes in between the two just makes WFI return at once.
+ * Before PRIMASK goes back the line is low again and the NVIC pending bit is cleared: the i2c handler never runs.
+ * Anything else that wakes the core gets its handler run after the WFI, then this goes back to sleep.
+ * If the NVIC interrupt of base is not enabled nothing would wake the core: this polls like the plain sync functions
+ * A libti2cit_m_syncwfi_meter() gets the CYCCNT ticks between just before and just after each WFI
+ */
+static uint32_t libti2cit_mris_sleep(uint32_t base, uint32_t mask, uint32_t match) {
+	uint32_t irq = libti2cit_int_num(base);
+	uint32_t nvic = 4 * ((irq - 16) / 32);	// NVIC_EN0 is interrupts 16 to 47, NVIC_EN1 48 to 79, ...
+	uint32_t bit = 1 << ((irq - 16) % 32);
+	uint32_t mris;
+	if (!irq || !(HWREG(NVIC_EN0 + nvic) & bit)) {	// a.k.a. ROM_IntIsEnabled()
+		while (((mris = HWREG(base + I2C_O_MRIS)) & mask) != match);
+		HWREG(base + I2C_O_MICR) = mris;
+		return mris;
+	}
+
+	uint32_t mimr = HWREG(base + I2C_O_MIMR);	// keep the I2C_MIMR_STARTIM flag of libti2cit_m_sync_recvpart()
+	libti2cit_wfi_st * w = libti2cit_wfi_find(base);
+	do {
+		uint32_t primask = CPUcpsid();
+		mris = HWREG(base + I2C_O_MRIS);
+		if ((mris & mask) != match) {
+			HWREG(base + I2C_O_MIMR) = mask & ~mris;	// a.k.a. ROM_I2CMasterIntEnableEx()
+			if (w) {
+				uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+				CPUwfi();
+				w->sleep += HWREG(LIBTI2CIT_DWT_CYCCNT) - t0;
+				w->nwfi++;
+			} else {
+				CPUwfi();
+			}
+			HWREG(base + I2C_O_MIMR) = mimr;
+			mris = HWREG(base + I2C_O_MRIS);	// this read also waits for the I2C_O_MIMR write to get there
+		}
+		if ((mris & mask) == match) HWREG(base + I2C_O_MICR) = mris;
+		HWREG(NVIC_UNPEND0 + nvic) = bit;	// a.k.a. ROM_IntPendClear()
+		if (!primask) CPUcpsie();
+	} while ((mris & mask) != match);
+	return mris;
+}
 
 /* wait for I2C_O_MRIS (Raw Interrupt Status)
  * when waiting for a bit to get set, ACK by writing 'mris' to I2C_O_MICR
+ * returns mris | LIBTI2CIT_MRIS_TIMEOUT if timeout cycles since t0 have passed
+ * timeout == LIBTI2CIT_WFI sleeps instead when waiting for a bit to get set (a bit clearing raises no interrupt)
  */
-static uint32_t libti2cit_mris_wait(uint32_t base, uint32_t mask, uint32_t match) {
+static uint32_t libti2cit_mris_wait(uint32_t base, uint32_t mask, uint32_t match, uint32_t t0, uint32_t timeout) {
 	uint32_t mris;
+	if (timeout == LIBTI2CIT_WFI) {
+		if (match) return libti2cit_mris_sleep(base, mask, match);
+		timeout = 0;
+	}
 	do {
 		mris = HWREG(base + I2C_O_MRIS);
-	} while ((mris & mask) != match);
+		if ((mris & mask) == match) break;
+		if (libti2cit_expired(t0, timeout)) return mris | LIBTI2CIT_MRIS_TIMEOUT;
+	} while (1);
 	if (match) HWREG(base + I2C_O_MICR) = mris;
 	return mris;
 }
 
 /* update i2c hardware state machine, then wait for I2C_MRIS_RIS
+ * there is no need to wait for I2C_MCS_BUSY to go up first (it is late, see
+ * http://e2e.ti.com/support/microcontrollers/tiva_arm/f/908/t/368493.aspx): RIS is latched, and the I2C_O_MICR
+ * write that ended the last wait cleared it, so only the command written here can set it again
+ * returns I2C_MRIS_NACKRIS or LIBTI2CIT_MRIS_TIMEOUT on failure
+ */
+static uint32_t libti2cit_m_continue(uint32_t base, uint32_t cmd, uint32_t t0, uint32_t timeout) {
+	HWREG(base + I2C_O_MCS) = cmd;	// a.k.a. ROM_I2CMasterControl()
+	return libti2cit_mris_wait(base, I2C_MRIS_RIS, I2C_MRIS_RIS, t0, timeout) & (I2C_MRIS_NACKRIS | LIBTI2CIT_MRIS_TIMEOUT);
+}
+
+/* give up on a libti2cit_m_sync_..._to() call
+ * if the master is still busy (a slave is stretching SCL or holding SDA) there is nothing to do but return: see
+ * libti2cit.h about recovering the bus. Otherwise send i2c STOP without waiting for it.
+ */
+static uint8_t libti2cit_m_sync_timeout(uint32_t base) {
+	HWREG(base + I2C_O_MIMR) &= ~I2C_MIMR_STARTIM;	// no libti2cit_m_sync_recvpart() after this
+	if (!(HWREG(base + I2C_O_MCS) & I2C_MCS_BUSY)) {
+		HWREG(base + I2C_O_MCS) = I2C_MASTER_CMD_BURST_SEND_ERROR_STOP;	// a.k.a. ROM_I2CMasterControl()
+	}
+	return LIBTI2CIT_TIMEOUT;
+}
+
+/* send the High-Speed master code: the NACK that follows it is expected
+ * returns 0, 2 for arbitration lost or LIBTI2CIT_TIMEOUT, as libti2cit_m_sync_hs_to() does
+ */
+static uint8_t libti2cit_m_hs_send(uint32_t base, uint8_t code, uint32_t t0, uint32_t timeout) {
+	HWREG(base + I2C_O_MSA) = code;	// a.k.a. ROM_I2CMasterSlaveAddrSet(): the master code is the whole byte
+	if (libti2cit_m_continue(base, I2C_MASTER_CMD_HS_MASTER_CODE_SEND, t0, timeout) & LIBTI2CIT_MRIS_TIMEOUT) {
+		return libti2cit_m_sync_timeout(base);
+	}
+	if (HWREG(base + I2C_O_MCS) & I2C_MCS_ARBLST) return 2;
+	return 0;
+}
+
+/* the libti2cit_m_speed_table() tables, one per base */
+static libti2cit_speed_st * libti2cit_speed_list;
+
+/* a transaction to addr (8-bit, bit 0 is ignored) is about to start on base: switch to the speed of that slave
+ * the last slave found is checked first, since most transactions go to the same slave as the one before
+ * returns the master code to send first, 0 for none
  */
-static uint32_t libti2cit_m_continue(uint32_t base, uint32_t cmd) {
-	ROM_I2CMasterControl(base, cmd);
-	while (!ROM_I2CMasterBusy(base));
-	return libti2cit_mris_wait(base, I2C_MRIS_RIS, I2C_MRIS_RIS) & I2C_MRIS_NACKRIS;
+static uint8_t libti2cit_speed_pick(uint32_t base, uint8_t addr) {
+	libti2cit_speed_st * sp = libti2cit_speed_list;
+	while (sp && sp->private_base != base) sp = sp->private_next;
+	if (!sp) return 0;
+	sp->ncheck++;
+
+	addr >>= 1;
+	const libti2cit_dev_st * d = sp->private_dev;
+	if (!d || d->addr != addr || d == &sp->other) {
+		uint32_t i;
+		for (i = 0, d = &sp->other; i < sp->ndev; i++) {
+			if (sp->dev[i].addr == addr) {
+				d = &sp->dev[i];
+				break;
+			}
+		}
+		sp->private_dev = d;
+	}
+
+	uint32_t sw = 0;
+	if (d->private_mtpr != sp->private_mtpr) {
+		HWREG(base + I2C_O_MTPR) = sp->private_mtpr = d->private_mtpr;
+		sw = 1;
+	}
+	if (d->private_mtpr_hs && d->private_mtpr_hs != sp->private_mtpr_hs) {
+		HWREG(base + I2C_O_MTPR) = sp->private_mtpr_hs = d->private_mtpr_hs;
+		sw = 1;
+	}
+	if (d->clkocnt != sp->private_clkocnt) {
+		HWREG(base + I2C_O_MCLKOCNT) = sp->private_clkocnt = d->clkocnt;
+		sw = 1;
+	}
+	sp->nswitch += sw;
+	return d->hs;
 }
 
 /* see description in libti2cit.h
  */
 uint8_t libti2cit_m_sync_send(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf) {
+	return libti2cit_m_sync_send_to(base, addr, len, buf, 0);
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_send_to(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf, uint32_t timeout) {
+	return libti2cit_m_sync_send_pec(base, addr, len, buf, timeout, 0);
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_send_pec(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf, uint32_t timeout,
+		uint8_t * pec) {
 	uint8_t cmd = I2C_MASTER_CMD_QUICK_COMMAND;
 	uint32_t mris_want = I2C_MRIS_RIS | I2C_MRIS_STOPRIS;	// case 1: len == 0 && (addr & 1) == 0
+	uint32_t t0 = libti2cit_cyccnt_start(timeout);
+	HWREG(base + I2C_O_MICR) = I2C_MRIS_RIS | I2C_MRIS_NACKRIS;	// in case an isr engine or a timeout left them set
+	uint8_t hs = libti2cit_speed_pick(base, addr);
+	if (hs && (hs = libti2cit_m_hs_send(base, hs, t0, timeout))) return hs;
+	uint8_t crc = 0;
+	uint32_t tail = pec && len && !(addr & 1);	// a write ends with the PEC byte, a quick command has none
 
 	// this do {} while () is only needed in the case where an i2c repeated start is sent
 	do {
+		uint8_t sa = len ? addr & ~1 : addr;	// data bytes are always written
+		crc = libti2cit_pec_add(crc, sa);
 		if (len) {
 			cmd = I2C_MASTER_CMD_BURST_SEND_START;
 			mris_want = I2C_MRIS_RIS;	// case 2: len != 0
 
 			// the tiva i2c hardware wants the first data byte before the i2c start condition is sent
-			if (buf) HWREG(base + I2C_O_MDR) = *(buf++); // a.k.a. ROM_I2CMasterDataPut()
+			if (buf) {
+				crc = libti2cit_pec_add(crc, *buf);
+				HWREG(base + I2C_O_MDR) = *(buf++); // a.k.a. ROM_I2CMasterDataPut()
+			}
 
 		} else if (addr & 1) {
 			cmd = I2C_MASTER_CMD_BURST_RECEIVE_START;
@@ -49,42 +390,79 @@ uint8_t libti2cit_m_sync_send(uint32_t base, uint8_t addr, uint32_t len, const u
 			mris_want = I2C_MRIS_RIS;	// case 3: len == 0 && (addr & 1) == 1
 		}
 
-		HWREG(base + I2C_O_MSA) = addr;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
-		ROM_I2CMasterControl(base, cmd);
-		while (!ROM_I2CMasterBusy(base));	// see http://e2e.ti.com/support/microcontrollers/tiva_arm/f/908/t/368493.aspx
-		if (libti2cit_mris_wait(base, mris_want, mris_want) & I2C_MRIS_NACKRIS) return 1;
+		HWREG(base + I2C_O_MSA) = sa;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
+		HWREG(base + I2C_O_MCS) = cmd;	// a.k.a. ROM_I2CMasterControl()
+		uint32_t mris = libti2cit_mris_wait(base, mris_want, mris_want, t0, timeout);
+		if (mris & LIBTI2CIT_MRIS_TIMEOUT) return libti2cit_m_sync_timeout(base);
+		if (mris & I2C_MRIS_NACKRIS) return 1;
 		if (HWREG(base + I2C_O_MCS) & I2C_MCS_ARBLST) return 2;
-		if (!len) return 0;
+		if (!len) {
+			if (pec) *pec = crc;
+			return 0;
+		}
 		len--;	// first byte was already sent
 		while (len) {
+			crc = libti2cit_pec_add(crc, *buf);
 			HWREG(base + I2C_O_MDR) = *(buf++); // a.k.a. ROM_I2CMasterDataPut()
-			uint32_t cmd = (--len | (addr & 1)) ? I2C_MASTER_CMD_BURST_SEND_CONT : I2C_MASTER_CMD_BURST_SEND_FINISH;
-			if (libti2cit_m_continue(base, cmd)) return 3 + len;
+			uint32_t cmd = (--len | (addr & 1) | tail) ? I2C_MASTER_CMD_BURST_SEND_CONT : I2C_MASTER_CMD_BURST_SEND_FINISH;
+			mris = libti2cit_m_continue(base, cmd, t0, timeout);
+			if (mris & LIBTI2CIT_MRIS_TIMEOUT) return libti2cit_m_sync_timeout(base);
+			if (mris) return (len < LIBTI2CIT_PEC_ERROR - 3) ? 3 + len : LIBTI2CIT_PEC_ERROR - 1;
+			if (HWREG(base + I2C_O_MCS) & I2C_MCS_ARBLST) return 2;
+		}
+		if (tail) {
+			HWREG(base + I2C_O_MDR) = crc; // a.k.a. ROM_I2CMasterDataPut()
+			mris = libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_SEND_FINISH, t0, timeout);
+			if (mris & LIBTI2CIT_MRIS_TIMEOUT) return libti2cit_m_sync_timeout(base);
+			if (mris) return LIBTI2CIT_PEC_ERROR;	// the slave got something else
 			if (HWREG(base + I2C_O_MCS) & I2C_MCS_ARBLST) return 2;
 		}
 	} while (addr & 1);	// this will do an i2c repeated start (no i2c stop) and then return from the function
 
-	libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0);
+	if (libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0, t0, timeout) & LIBTI2CIT_MRIS_TIMEOUT) {
+		return libti2cit_m_sync_timeout(base);
+	}
 	return 0;
 }
 
 /* see description in libti2cit.h
  */
 uint8_t libti2cit_m_sync_recv(uint32_t base, uint32_t len, uint8_t * buf) {
+	return libti2cit_m_sync_recv_to(base, len, buf, 0);
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_recv_to(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout) {
+	return libti2cit_m_sync_recv_pec(base, len, buf, timeout, 0);
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_recv_pec(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout, uint8_t * pec) {
 	HWREG(base + I2C_O_MIMR) &= ~I2C_MIMR_STARTIM;	// bit was set in case libti2cit_m_sync_recvpart() would be called, clear it now
 
 	// first byte was already received by i2c state machine
 	if (!len) {	// len cannot be zero. first byte was already received so len is at least 1!
-		ROM_I2CMasterControl(base, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP);
+		HWREG(base + I2C_O_MCS) = I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP;	// a.k.a. ROM_I2CMasterControl()
 		return 1;
 	}
+	uint32_t t0 = libti2cit_cyccnt_start(timeout);
+	uint8_t crc = pec ? *pec : 0;
 
 	// first byte already received by i2c hardware: read it, then check len
-	while (*(buf++) = HWREG(base + I2C_O_MDR) /* a.k.a. ROM_I2CMasterDataGet() */, len) {
-		len--;
-		libti2cit_m_continue(base, len ? I2C_MASTER_CMD_BURST_RECEIVE_CONT : I2C_MASTER_CMD_BURST_RECEIVE_FINISH);
+	while (*buf = HWREG(base + I2C_O_MDR) /* a.k.a. ROM_I2CMasterDataGet() */, crc = libti2cit_pec_add(crc, *(buf++)), --len) {
+		if (libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_CONT, t0, timeout) & LIBTI2CIT_MRIS_TIMEOUT) {
+			return libti2cit_m_sync_timeout(base);
+		}
 	}
-	libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0);
+	// the byte this receives is not stored in buf: it is the PEC byte if there is one
+	if ((libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_FINISH, t0, timeout) |
+			libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0, t0, timeout)) & LIBTI2CIT_MRIS_TIMEOUT) {
+		return libti2cit_m_sync_timeout(base);
+	}
+	// the CRC of the data and the right PEC byte together is 0
+	if (pec && libti2cit_pec_add(crc, HWREG(base + I2C_O_MDR))) return LIBTI2CIT_PEC_ERROR;
 	return 0;
 }
 
@@ -92,40 +470,200 @@ uint8_t libti2cit_m_sync_recv(uint32_t base, uint32_t len, uint8_t * buf) {
  */
 uint8_t libti2cit_m_sync_recvpart(uint32_t base, uint32_t len, uint8_t * buf)
 {
+	return libti2cit_m_sync_recvpart_to(base, len, buf, 0);
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_recvpart_to(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout)
+{
+	return libti2cit_m_sync_recvpart_pec(base, len, buf, timeout, 0);
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_recvpart_pec(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout, uint8_t * pec)
+{
+	uint32_t t0 = libti2cit_cyccnt_start(timeout);
+	uint8_t crc = pec ? *pec : 0;
 	uint32_t mimr = HWREG(base + I2C_O_MIMR);
 	if (mimr & I2C_MIMR_STARTIM) {	// if this is the first time calling libti2cit_m_sync_recvpart()
 		HWREG(base + I2C_O_MIMR) = mimr & ~I2C_MIMR_STARTIM;
 		if (!len) {	// first receive some bytes!
-			ROM_I2CMasterControl(base, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP);
+			HWREG(base + I2C_O_MCS) = I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP;	// a.k.a. ROM_I2CMasterControl()
 			return 1;
 		}
 
 		// first byte already received by i2c hardware
-		*(buf++) = HWREG(base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+		*buf = HWREG(base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+		crc = libti2cit_pec_add(crc, *(buf++));
 		len--;
 	} else if (!len) {
-		libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_FINISH);
-		libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0);
+		if ((libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_FINISH, t0, timeout) |
+				libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0, t0, timeout)) & LIBTI2CIT_MRIS_TIMEOUT) {
+			return libti2cit_m_sync_timeout(base);
+		}
+		if (pec && libti2cit_pec_add(crc, HWREG(base + I2C_O_MDR))) return LIBTI2CIT_PEC_ERROR;
 		return 0;
 	}
 
 	while (len) {
-		libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_CONT);
-		*(buf++) = HWREG(base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+		if (libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_CONT, t0, timeout) & LIBTI2CIT_MRIS_TIMEOUT) {
+			return libti2cit_m_sync_timeout(base);
+		}
+		*buf = HWREG(base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+		crc = libti2cit_pec_add(crc, *(buf++));
 		len--;
 	}
+	if (pec) *pec = crc;
 	return 0;
 }
 
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_syncwfi_send(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf)
+{
+	libti2cit_wfi_st * w = libti2cit_wfi_find(base);
+	if (!w) return libti2cit_m_sync_send_to(base, addr, len, buf, LIBTI2CIT_WFI);
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	uint8_t r = libti2cit_m_sync_send_to(base, addr, len, buf, LIBTI2CIT_WFI);
+	w->cycles += HWREG(LIBTI2CIT_DWT_CYCCNT) - t0;
+	return r;
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_syncwfi_recv(uint32_t base, uint32_t len, uint8_t * buf)
+{
+	libti2cit_wfi_st * w = libti2cit_wfi_find(base);
+	if (!w) return libti2cit_m_sync_recv_to(base, len, buf, LIBTI2CIT_WFI);
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	uint8_t r = libti2cit_m_sync_recv_to(base, len, buf, LIBTI2CIT_WFI);
+	w->cycles += HWREG(LIBTI2CIT_DWT_CYCCNT) - t0;
+	return r;
+}
 
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_syncwfi_recvpart(uint32_t base, uint32_t len, uint8_t * buf)
+{
+	libti2cit_wfi_st * w = libti2cit_wfi_find(base);
+	if (!w) return libti2cit_m_sync_recvpart_to(base, len, buf, LIBTI2CIT_WFI);
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	uint8_t r = libti2cit_m_sync_recvpart_to(base, len, buf, LIBTI2CIT_WFI);
+	w->cycles += HWREG(LIBTI2CIT_DWT_CYCCNT) - t0;
+	return r;
+}
 
+/* see description in libti2cit.h
+ */
+void libti2cit_m_syncwfi_meter(uint32_t base, libti2cit_wfi_st * w)
+{
+	libti2cit_wfi_st ** pp = &libti2cit_wfi_list;
+	while (*pp && (*pp)->private_base != base) pp = &(*pp)->private_next;
+	if (*pp) *pp = (*pp)->private_next;
+	if (!w) return;
+
+	libti2cit_cyccnt_start(1);
+	w->private_base = base;
+	w->private_cycles = w->cycles;
+	w->private_sleep = w->sleep;
+	w->private_next = libti2cit_wfi_list;
+	libti2cit_wfi_list = w;
+}
 
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_m_syncwfi_slept(uint32_t base, uint32_t * active)
+{
+	libti2cit_wfi_st * w = libti2cit_wfi_find(base);
+	uint32_t sleep = w ? w->sleep - w->private_sleep : 0;
+	if (active) *active = w ? w->cycles - w->private_cycles - sleep : 0;
+	if (w) {
+		w->private_cycles = w->cycles;
+		w->private_sleep = w->sleep;
+	}
+	return sleep;
+}
 
+/* SCL = sysclock / (2 * (SCL_LP + SCL_HP) * (TPR + 1)): SCL_LP + SCL_HP is 10 in Standard/Fast mode, 3 in High-Speed
+ * returns the I2C_O_MTPR TPR for the fastest speed at or below scl_hz, in the 7 bits the register has
+ */
+static uint32_t libti2cit_tpr(uint32_t sysclock, uint32_t div, uint32_t scl_hz)
+{
+	uint32_t tpr = (sysclock + div * scl_hz - 1) / (div * scl_hz) - 1;
+	if (!tpr) tpr = 1;	// TPR == 0 is reserved
+	return tpr > I2C_MTPR_TPR_M ? I2C_MTPR_TPR_M : tpr;
+}
 
+/* fill in the I2C_O_MTPR values for d->scl_hz: private_mtpr_hs is 0 unless it is High-Speed
+ * returns the actual speed
+ */
+static uint32_t libti2cit_dev_mtpr(uint32_t sysclock, libti2cit_dev_st * d)
+{
+	if (d->scl_hz <= 1000000) {
+		d->private_mtpr = libti2cit_tpr(sysclock, 2 * 10, d->scl_hz);
+		d->private_mtpr_hs = 0;
+		return sysclock / (2 * 10 * (d->private_mtpr + 1));
+	}
+	// the master code goes out at 400kHz, then the High-Speed period takes over until the STOP
+	d->private_mtpr = libti2cit_tpr(sysclock, 2 * 10, 400000);
+	uint32_t tpr = libti2cit_tpr(sysclock, 2 * 3, d->scl_hz);
+	d->private_mtpr_hs = I2C_MTPR_HS | tpr;
+	return sysclock / (2 * 3 * (tpr + 1));
+}
 
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_m_speed(uint32_t base, uint32_t sysclock, uint32_t scl_hz)
+{
+	libti2cit_dev_st d;
+	d.scl_hz = scl_hz;
+	uint32_t hz = libti2cit_dev_mtpr(sysclock, &d);
+	HWREG(base + I2C_O_MTPR) = d.private_mtpr;
+	if (d.private_mtpr_hs) HWREG(base + I2C_O_MTPR) = d.private_mtpr_hs;
+	return hz;
+}
 
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_hs(uint32_t base, uint8_t code)
+{
+	return libti2cit_m_sync_hs_to(base, code, 0);
+}
 
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_sync_hs_to(uint32_t base, uint8_t code, uint32_t timeout)
+{
+	return libti2cit_m_hs_send(base, code, libti2cit_cyccnt_start(timeout), timeout);
+}
 
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_m_speed_table(uint32_t base, libti2cit_speed_st * sp)
+{
+	libti2cit_speed_st ** pp = &libti2cit_speed_list;
+	while (*pp && (*pp)->private_base != base) pp = &(*pp)->private_next;
+	if (*pp) *pp = (*pp)->private_next;
+	if (!sp) return 0;
+
+	// work out every I2C_O_MTPR value now: libti2cit_speed_pick() only compares them
+	uint32_t i;
+	for (i = 0; i < sp->ndev; i++) libti2cit_dev_mtpr(sp->sysclock, &sp->dev[i]);
+	uint32_t hz = libti2cit_dev_mtpr(sp->sysclock, &sp->other);
+
+	// start out at the speed of other
+	sp->private_base = base;
+	sp->private_dev = &sp->other;
+	HWREG(base + I2C_O_MTPR) = sp->private_mtpr = sp->other.private_mtpr;
+	sp->private_mtpr_hs = sp->other.private_mtpr_hs;
+	if (sp->private_mtpr_hs) HWREG(base + I2C_O_MTPR) = sp->private_mtpr_hs;
+	HWREG(base + I2C_O_MCLKOCNT) = sp->private_clkocnt = sp->other.clkocnt;
+	sp->private_next = libti2cit_speed_list;
+	libti2cit_speed_list = sp;
+	return hz;
+}
 
 
 
@@ -137,23 +675,75 @@ uint8_t libti2cit_m_sync_recvpart(uint32_t base, uint32_t len, uint8_t * buf)
 
 
 
-static void libti2cit_m_isr_set_isr_cb(libti2cit_int_st * st, libti2cit_status_cb cb)
-{
-	union {
-		void * as_void;
-		libti2cit_status_cb as_cb;
-	} punned;
-	punned.as_cb = cb;
-	st->private_ = punned.as_void;
-}
-static void libti2cit_m_isr_call_isr_cb(libti2cit_int_st * st, uint32_t status)
+/* master isr states, kept in st->private_state
+ * libti2cit_m_isr_send() and the other start functions pick the state, libti2cit_m_isr_step() runs it on each
+ * interrupt, and libti2cit_m_isr_finish() puts it back to LIBTI2CIT_M_IDLE
+ */
+enum {
+	LIBTI2CIT_M_IDLE = 0,	// no transfer running: any interrupt but a NACK is UNEXPECTED
+	LIBTI2CIT_M_WAIT_STOP,	// the last command sent i2c STOP: wait for it
+	LIBTI2CIT_M_WAIT_RIS,	// a repeated start is receiving the first byte into I2C_O_MDR: wait for it
+	LIBTI2CIT_M_NOFIFO_SEND,
+	LIBTI2CIT_M_NOFIFO_RECV,
+	LIBTI2CIT_M_NOFIFO_RECVPART,
+	LIBTI2CIT_M_FIFO_SEND,
+	LIBTI2CIT_M_FIFO_RECV,
+	LIBTI2CIT_M_FIFO_RECVPART,
+	LIBTI2CIT_M_DMA_SEND,
+	LIBTI2CIT_M_DMA_RECV,
+	LIBTI2CIT_M_DMA_RECVPART,
+	LIBTI2CIT_M_HS_CODE,	// the High-Speed master code is on the bus, private_next is the send to start after it
+	LIBTI2CIT_M_NSTATE
+};
+typedef char libti2cit_prof_nstate_check[(LIBTI2CIT_PROF_N - LIBTI2CIT_PROF_M_STATE == LIBTI2CIT_M_NSTATE) ? 1 : -1];
+
+/* what each state does, so libti2cit_m_isr_step() does not have to work it out on every interrupt
+ *   wait is the interrupts the state acts on, all others are ignored
+ *   cmd_cont is the I2C_O_MCS command that keeps the transfer going
+ *   cmd_last is the I2C_O_MCS command for the last byte (nofifo) or the last burst (FIFO, uDMA)
+ *     a send with addr bit 0 == 1 uses cmd_cont instead, the repeated start comes after it
+ *   rx is nonzero if the data comes from the slave
+ *   stop is nonzero if cmd_last sends i2c STOP
+ */
+typedef struct libti2cit_m_action_ {
+	uint16_t wait;
+	uint8_t cmd_cont;
+	uint8_t cmd_last;
+	uint8_t rx;
+	uint8_t stop;
+} libti2cit_m_action;
+
+static const libti2cit_m_action libti2cit_m_isr_action[LIBTI2CIT_M_NSTATE] = {
+	[LIBTI2CIT_M_IDLE] = { 0, 0, 0, 0, 0 },
+	[LIBTI2CIT_M_WAIT_STOP] = { I2C_MIMR_STOPIM, 0, 0, 0, 0 },
+	[LIBTI2CIT_M_WAIT_RIS] = { I2C_MIMR_IM, 0, 0, 1, 0 },
+	[LIBTI2CIT_M_NOFIFO_SEND] = { I2C_MIMR_IM,
+		I2C_MASTER_CMD_BURST_SEND_CONT, I2C_MASTER_CMD_BURST_SEND_FINISH, 0, 1 },
+	[LIBTI2CIT_M_NOFIFO_RECV] = { I2C_MIMR_IM | I2C_MIMR_STOPIM,
+		I2C_MASTER_CMD_BURST_RECEIVE_CONT, I2C_MASTER_CMD_BURST_RECEIVE_FINISH, 1, 1 },
+	[LIBTI2CIT_M_NOFIFO_RECVPART] = { I2C_MIMR_IM,
+		I2C_MASTER_CMD_BURST_RECEIVE_CONT, I2C_MASTER_CMD_BURST_RECEIVE_CONT, 1, 0 },
+	[LIBTI2CIT_M_FIFO_SEND] = { I2C_MIMR_IM | I2C_MIMR_TXIM,
+		I2C_MASTER_CMD_FIFO_BURST_SEND_CONT, I2C_MASTER_CMD_FIFO_BURST_SEND_FINISH, 0, 1 },
+	[LIBTI2CIT_M_FIFO_RECV] = { I2C_MIMR_IM | I2C_MIMR_RXIM,
+		I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_FINISH, 1, 1 },
+	[LIBTI2CIT_M_FIFO_RECVPART] = { I2C_MIMR_IM | I2C_MIMR_RXIM,
+		I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, 1, 0 },
+	[LIBTI2CIT_M_DMA_SEND] = { I2C_MIMR_IM,
+		I2C_MASTER_CMD_FIFO_BURST_SEND_CONT, I2C_MASTER_CMD_FIFO_BURST_SEND_FINISH, 0, 1 },
+	[LIBTI2CIT_M_DMA_RECV] = { I2C_MIMR_IM | I2C_MIMR_STOPIM | I2C_MIMR_DMARXIM,
+		I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_FINISH, 1, 1 },
+	[LIBTI2CIT_M_DMA_RECVPART] = { I2C_MIMR_IM | I2C_MIMR_STOPIM | I2C_MIMR_DMARXIM,
+		I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, 1, 0 },
+	[LIBTI2CIT_M_HS_CODE] = { I2C_MIMR_IM, 0, 0, 0, 0 },
+};
+
+/* the command for the last byte or burst of the current state, see libti2cit_m_action
+ * a send followed by a repeated start or by the PEC byte uses cmd_cont too
+ */
+static uint32_t libti2cit_m_isr_cmd_last(libti2cit_int_st * st, const libti2cit_m_action * a)
 {
-	union {
-		void * as_void;
-		libti2cit_status_cb as_cb;
-	} punned;
-	punned.as_void = st->private_;
-	punned.as_cb(st, status);
+	return (!a->rx && ((st->addr & 1) || st->pec)) ? a->cmd_cont : a->cmd_last;
 }
 
 /* see description in libti2cit.h
@@ -175,11 +765,29 @@ uint32_t libti2cit_m_int_clear(libti2cit_int_st * st)
 	return status;
 }
 
+static void libti2cit_m_isr_queue_step(libti2cit_int_st * st, uint32_t status);
+static void libti2cit_m_scan_step(libti2cit_int_st * st, uint32_t status);
+
 static uint32_t libti2cit_m_isr_finish(libti2cit_int_st * st, uint32_t status)
 {
-	// this ends internal isr_cb action, unless this is a NACK
-	// if this is a NACK, the isr_cb is still needed for the next interrupt the hardware generates
-	if (!(status & I2C_MIMR_NACKIM)) libti2cit_m_isr_set_isr_cb(st, 0);
+	// this ends the transfer, unless this is a NACK
+	// if this is a NACK, the state is still needed for the next interrupt the hardware generates
+	if (!(status & I2C_MIMR_NACKIM)) {
+		st->private_state = LIBTI2CIT_M_IDLE;
+		st->private_nburst = 0;
+	}
+	LIBTI2CIT_TRACE(M_DONE, st, st->private_state, status);
+
+	if (st->xfer) {
+		// libti2cit_m_isr_queue(): start the next step from this same interrupt
+		libti2cit_m_isr_queue_step(st, status);
+		return status;
+	}
+	if (st->scan) {
+		// libti2cit_m_scan(): same for the next address
+		libti2cit_m_scan_step(st, status);
+		return status;
+	}
 
 	if (!st->user_cb) {
 		//UARTsend("!isr_user_cb\r\n");
@@ -190,14 +798,35 @@ static uint32_t libti2cit_m_isr_finish(libti2cit_int_st * st, uint32_t status)
 	return status;
 }
 
+static void libti2cit_m_isr_fifo_abort(libti2cit_int_st * st, uint32_t status);
+static uint32_t libti2cit_m_bus_stuck(uint32_t base, libti2cit_recover_st * r);
+static uint32_t libti2cit_m_isr_recover(libti2cit_int_st * st, uint32_t status);
+static void libti2cit_m_isr_step(libti2cit_int_st * st, uint32_t status);
+
 /* see description in libti2cit.h
  */
 uint32_t libti2cit_m_isr_isr(libti2cit_int_st * st)
 {
 	uint32_t status = libti2cit_m_int_clear(st);
 	if (!status) return 0;
+	st->nisr++;
+	LIBTI2CIT_TRACE(M_ISR, st, st->private_state, status);
 
-	if (status & I2C_MIMR_NACKIM) {
+	if (st->recover && ((status & I2C_MIMR_CLKIM) ||
+			((status & I2C_MIMR_ARBLOSTIM) && libti2cit_m_bus_stuck(st->base, st->recover)))) {
+		return libti2cit_m_isr_recover(st, status);
+	}
+
+	if (st->private_nburst && (status & (I2C_MIMR_NACKIM | I2C_MIMR_ARBLOSTIM))) {
+		// the FIFO and uDMA engines give up the rest of the transfer
+		libti2cit_m_isr_fifo_abort(st, status);
+		if (!(status & I2C_MIMR_NACKIM)) return libti2cit_m_isr_finish(st, status);	// arbitration lost: this master will not see a STOP
+	}
+	if ((st->xfer || st->scan) && (status & (I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM))) {
+		return libti2cit_m_isr_finish(st, status);	// libti2cit_m_isr_queue() or libti2cit_m_scan() gives up
+	}
+
+	if ((status & I2C_MIMR_NACKIM) && st->private_state != LIBTI2CIT_M_HS_CODE) {	// no slave ACKs the master code
 		if (!st->user_cb) {
 			//UARTsend("!isr_user_cb\r\n");
 			status |= LIBTI2CIT_ISR_UNEXPECTED;	// signal UNEXPECTED
@@ -205,97 +834,110 @@ uint32_t libti2cit_m_isr_isr(libti2cit_int_st * st)
 		return libti2cit_m_isr_finish(st, status);
 	}
 
-	if (!st->private_) {
-		// isr_cb was not set...UNEXPECTED
-		//UARTsend("!isr_cb\r\n");
+	if (st->private_state == LIBTI2CIT_M_IDLE) {
+		// no transfer is running...UNEXPECTED
+		//UARTsend("!private_state\r\n");
 		status |= LIBTI2CIT_ISR_UNEXPECTED;
 		return libti2cit_m_isr_finish(st, status);
 	}
 
-	// normal isr_cb
-	libti2cit_m_isr_call_isr_cb(st, status);
+	// normal transfer step
+#ifdef LIBTI2CIT_PROF
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	uint32_t id = LIBTI2CIT_PROF_M_STATE + st->private_state;
+	libti2cit_m_isr_step(st, status);
+	libti2cit_prof_add(id, t0);
+#else
+	libti2cit_m_isr_step(st, status);
+#endif
 	return status;
 }
 
 
 
 
-static void libti2cit_m_isr_nofifo_done_ris_stopris(libti2cit_int_st * st, uint32_t status)
-{
-	// gets called from 2 places:
-	// 1. finished writing 1+ bytes in libti2cit_m_isr_nofifo_send_ris(), now want to stop
-	// 2. finished writing 0 bytes, want to stop (came directly from libti2cit_m_isr_nofifo_send())
-	if (status & I2C_MIMR_STOPIM) libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
-}
-static void libti2cit_m_isr_nofifo_done_ris(libti2cit_int_st * st, uint32_t status)
-{
-	// gets called from 2 places:
-	// 1. finished writing 1+ bytes in libti2cit_m_isr_nofifo_send_ris(), now want to read
-	// 2. wrote zero bytes, want to read (came directly from libti2cit_m_isr_nofifo_send())
-	if (status & I2C_MIMR_IM) libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
-}
-
-static void libti2cit_m_isr_nofifo_send_ris(libti2cit_int_st * st, uint32_t status)
+/* the last byte or burst of libti2cit_m_isr_nofifo_send(), libti2cit_m_isr_send() or libti2cit_m_isrdma_send() is sent
+ */
+static void libti2cit_m_isr_send_done(libti2cit_int_st * st, uint32_t status)
 {
-	if (!status & I2C_MIMR_IM) return;
-	if (st->nread < st->len) {
-		HWREG(st->base + I2C_O_MDR) = st->buf[st->nread]; // a.k.a. ROM_I2CMasterDataPut()
+	if (st->pec && !(st->addr & 1) && st->nread == st->len) {
+		// the PEC byte goes out on its own through I2C_O_MDR, then this is called again
 		st->nread++;
-		ROM_I2CMasterControl(st->base,
-			((st->nread < st->len) || (st->addr & 1)) ? I2C_MASTER_CMD_BURST_SEND_CONT : I2C_MASTER_CMD_BURST_SEND_FINISH);
-	} else if (st->addr & 1) {
-		libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_done_ris);
+		st->private_nburst = 0;	// not a FIFO burst any more: a NACK now needs no libti2cit_m_isr_fifo_abort()
+		st->private_state = LIBTI2CIT_M_NOFIFO_SEND;
+		HWREG(st->base + I2C_O_MDR) = st->private_crc;	// a.k.a. ROM_I2CMasterDataPut()
+		HWREG(st->base + I2C_O_MCS) = I2C_MASTER_CMD_BURST_SEND_FINISH;	// a.k.a. ROM_I2CMasterControl()
+		return;
+	}
+	if (st->addr & 1) {
+		// all bytes are sent, do a repeated start and receive the first byte
+		if (st->pec) st->private_crc = libti2cit_pec_add(st->private_crc, st->addr);
+		st->private_state = LIBTI2CIT_M_WAIT_RIS;
+		HWREG(st->base + I2C_O_MSA) = st->addr;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
 		HWREG(st->base + I2C_O_MIMR) |= I2C_MIMR_STARTIM;	// a START actually will NOT happen, no interrupt will fire: abuse this bit to signal a repeated start for libti2cit_m_sync_recvpart()
-		ROM_I2CMasterControl(st->base, I2C_MASTER_CMD_BURST_RECEIVE_START);
+		HWREG(st->base + I2C_O_MCS) = I2C_MASTER_CMD_BURST_RECEIVE_START;	// a.k.a. ROM_I2CMasterControl()
 	} else {
-		libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_done_ris_stopris);
+		// the last command sent i2c STOP, it may be in this same interrupt
+		st->private_state = LIBTI2CIT_M_WAIT_STOP;
+		if (status & I2C_MIMR_STOPIM) libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
 	}
 }
 
+/* switch to the speed of the slave if there is a libti2cit_m_speed_table()
+ * then if it or st->hs needs one, send the master code first. libti2cit_m_isr_step() calls the send function again
+ * when it is done, and the transfer then runs in High-Speed mode until its i2c STOP
+ * returns 1 if the send function should return now
+ */
+static uint32_t libti2cit_m_hs_code(libti2cit_int_st * st, uint32_t next)
+{
+	if (st->private_state == LIBTI2CIT_M_HS_CODE) return 0;
+	uint8_t hs = libti2cit_speed_pick(st->base, st->addr);
+	if (!hs) hs = st->hs;
+	if (!hs) return 0;
+	st->nisr = 0;
+	st->private_nburst = 0;
+	st->private_next = next;
+	st->private_state = LIBTI2CIT_M_HS_CODE;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+	HWREG(st->base + I2C_O_MSA) = hs;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
+	HWREG(st->base + I2C_O_MCS) = I2C_MASTER_CMD_HS_MASTER_CODE_SEND;	// a.k.a. ROM_I2CMasterControl()
+	return 1;
+}
+
 /* see description in libti2cit.h
  */
 void libti2cit_m_isr_nofifo_send(libti2cit_int_st * st)
 {
+	if (libti2cit_m_hs_code(st, LIBTI2CIT_M_NOFIFO_SEND)) return;
 	uint8_t cmd = I2C_MASTER_CMD_QUICK_COMMAND;
-	libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_done_ris_stopris);	// case 1: len == 0 && (addr & 1) == 0
+	uint8_t sa = st->len ? st->addr & ~1 : st->addr;	// data bytes are always written
+	if (st->private_state != LIBTI2CIT_M_HS_CODE) st->nisr = 0;	// else libti2cit_m_hs_code() did, and counted the master code
+	st->private_state = LIBTI2CIT_M_WAIT_STOP;	// case 1: len == 0 && (addr & 1) == 0
 
 	st->nread = 0;
+	st->private_crc = libti2cit_pec_add(0, sa);
 	if (st->len) {
 		cmd = I2C_MASTER_CMD_BURST_SEND_START;
-		libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_send_ris);	// case 2: len != 0
+		st->private_state = LIBTI2CIT_M_NOFIFO_SEND;	// case 2: len != 0
 
 		// the tiva i2c hardware wants the first data byte before the i2c start condition is sent
-		if (st->buf) HWREG(st->base + I2C_O_MDR) = st->buf[0]; // a.k.a. ROM_I2CMasterDataPut()
+		if (st->buf) {
+			HWREG(st->base + I2C_O_MDR) = st->buf[0]; // a.k.a. ROM_I2CMasterDataPut()
+			st->private_crc = libti2cit_pec_add(st->private_crc, st->buf[0]);
+		}
 		st->nread++;
 
 	} else if (st->addr & 1) {
 		cmd = I2C_MASTER_CMD_BURST_RECEIVE_START;
 		HWREG(st->base + I2C_O_MIMR) |= I2C_MIMR_STARTIM;	// a START actually will NOT happen, no interrupt will fire: abuse this bit to signal a repeated start for libti2cit_m_sync_recvpart()
-		libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_done_ris);	// case 3: len == 0 && (addr & 1) == 1
+		st->private_state = LIBTI2CIT_M_WAIT_RIS;	// case 3: len == 0 && (addr & 1) == 1
 	}
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
 
-	HWREG(st->base + I2C_O_MSA) = st->addr;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
+	HWREG(st->base + I2C_O_MSA) = sa;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
 	ROM_I2CMasterControl(st->base, cmd);
 }
 
-static void libti2cit_m_isr_nofifo_recv_cb(libti2cit_int_st * st, uint32_t status)
-{
-	if (st->nread >= st->len) {
-		// wait for STOPIM
-		if (!(status & I2C_MIMR_STOPIM)) return;
-
-		libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
-		return;
-	}
-
-	// wait for RIS
-	if (!(status & I2C_MIMR_IM)) return;
-
-	st->buf[st->nread] = HWREG(st->base + I2C_O_MDR) /* a.k.a. ROM_I2CMasterDataGet() */;
-	st->nread++;
-	ROM_I2CMasterControl(st->base, (st->nread < st->len) ? I2C_MASTER_CMD_BURST_RECEIVE_CONT : I2C_MASTER_CMD_BURST_RECEIVE_FINISH);
-}
-
 /* see description in libti2cit.h
  */
 void libti2cit_m_isr_nofifo_recv(libti2cit_int_st * st)
@@ -308,35 +950,24 @@ void libti2cit_m_isr_nofifo_recv(libti2cit_int_st * st)
 		for (;;);	// deliberately freeze here to make it easy to debug
 		return;
 	}
+	st->nisr = 0;
 	st->nread = 0;
 
-	libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_recv_cb);
+	st->private_state = LIBTI2CIT_M_NOFIFO_RECV;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
 
 	// first byte already received by i2c hardware: read it, then check len
-	libti2cit_m_isr_nofifo_recv_cb(st, I2C_MIMR_IM);
-}
-
-static void libti2cit_m_isr_nofifo_recvpart_cb(libti2cit_int_st * st, uint32_t status)
-{
-	// wait for RIS
-	if (!(status & I2C_MIMR_IM)) return;
-
-	if (st->nread >= st->len) {
-		libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done (but no i2c STOP occurred)
-		return;
-	}
-
-	st->buf[st->nread] = HWREG(st->base + I2C_O_MDR) /* a.k.a. ROM_I2CMasterDataGet() */;
-	st->nread++;
-	ROM_I2CMasterControl(st->base, I2C_MASTER_CMD_BURST_RECEIVE_CONT);
+	libti2cit_m_isr_step(st, I2C_MIMR_IM);
 }
 
 /* see description in libti2cit.h
  */
 void libti2cit_m_isr_nofifo_recvpart(libti2cit_int_st * st)
 {
+	st->nisr = 0;
 	st->nread = 0;
-	libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_recvpart_cb);
+	st->private_state = LIBTI2CIT_M_NOFIFO_RECVPART;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
 
 	uint32_t mimr = HWREG(st->base + I2C_O_MIMR);
 	if (mimr & I2C_MIMR_STARTIM) {	// if this is the first time calling libti2cit_m_sync_recvpart()
@@ -349,9 +980,10 @@ void libti2cit_m_isr_nofifo_recvpart(libti2cit_int_st * st)
 		}
 
 		// first byte already received by i2c hardware
-		libti2cit_m_isr_nofifo_recv_cb(st, I2C_MIMR_IM);
+		libti2cit_m_isr_step(st, I2C_MIMR_IM);
+		return;
 	} else if (!st->len) {
-		libti2cit_m_isr_set_isr_cb(st, libti2cit_m_isr_nofifo_recv_cb);
+		st->private_state = LIBTI2CIT_M_NOFIFO_RECV;
 		ROM_I2CMasterControl(st->base, I2C_MASTER_CMD_BURST_RECEIVE_FINISH);
 		return;
 	}
@@ -363,62 +995,1974 @@ void libti2cit_m_isr_nofifo_recvpart(libti2cit_int_st * st)
 
 
 
-/* see description in libti2cit.h
+/* FIFO trigger levels for libti2cit_m_isr_send(), _recv() and _recvpart() -- the TM4C129 FIFOs are 8 bytes deep
+ * TX: refill when the TX FIFO holds LIBTI2CIT_FIFO_TXTRIG bytes or less
+ * RX: drain when the RX FIFO holds LIBTI2CIT_FIFO_RXTRIG bytes or more
+ * the byte in the shift register gives the isr one byte-time to respond before the bus is stalled
  */
-void libti2cit_m_isr_send(libti2cit_int_st * st)
+#ifndef LIBTI2CIT_FIFO_TXTRIG
+#define LIBTI2CIT_FIFO_TXTRIG (1)
+#endif
+#ifndef LIBTI2CIT_FIFO_RXTRIG
+#define LIBTI2CIT_FIFO_RXTRIG (7)
+#endif
+#define LIBTI2CIT_FIFO_LEN (8)
+#define LIBTI2CIT_BURST_MAX (255)	// I2C_O_MBLEN is only 8 bits: longer transfers are split into several bursts
+
+/* give the TX FIFO to the master, flush it and clear any stale TX FIFO request
+ *   fifoctl is the trigger level, and I2C_FIFOCTL_DMATXENA for the uDMA engine
+ */
+static void libti2cit_m_fifo_tx_init(uint32_t base, uint32_t fifoctl)
 {
+	HWREG(base + I2C_O_FIFOCTL) = (HWREG(base + I2C_O_FIFOCTL) &
+		~(I2C_FIFOCTL_TXASGNMT | I2C_FIFOCTL_DMATXENA | I2C_FIFOCTL_TXTRIG_M)) | I2C_FIFOCTL_TXFLUSH | fifoctl;
+	HWREG(base + I2C_O_MICR) = I2C_MICR_TXIC | I2C_MICR_DMATXIC;
 }
 
-/* see description in libti2cit.h
+/* give the RX FIFO to the master, flush it and clear any stale RX FIFO request
+ *   fifoctl is the trigger level, and I2C_FIFOCTL_DMARXENA for the uDMA engine
  */
-void libti2cit_m_isr_recv(libti2cit_int_st * st)
+static void libti2cit_m_fifo_rx_init(uint32_t base, uint32_t fifoctl)
 {
+	HWREG(base + I2C_O_FIFOCTL) = (HWREG(base + I2C_O_FIFOCTL) &
+		~(I2C_FIFOCTL_RXASGNMT | I2C_FIFOCTL_DMARXENA | I2C_FIFOCTL_RXTRIG_M)) | I2C_FIFOCTL_RXFLUSH | fifoctl;
+	HWREG(base + I2C_O_MICR) = I2C_MICR_RXIC | I2C_MICR_DMARXIC;
 }
 
-/* see description in libti2cit.h
+/* start the next burst of up to LIBTI2CIT_BURST_MAX bytes
+ *   private_nburst counts the bytes covered by the bursts started so far
+ *   cmd_last is used when this burst reaches st->len, cmd_cont otherwise
  */
-void libti2cit_m_isr_recvpart(libti2cit_int_st * st)
+static void libti2cit_m_isr_fifo_burst(libti2cit_int_st * st, uint32_t cmd_cont, uint32_t cmd_last)
 {
+	uint32_t n = st->len - st->private_nburst;
+	if (n > LIBTI2CIT_BURST_MAX) n = LIBTI2CIT_BURST_MAX;
+	st->private_nburst += n;
+	HWREG(st->base + I2C_O_MBLEN) = n;
+	HWREG(st->base + I2C_O_MCS) = (st->private_nburst < st->len) ? cmd_cont : cmd_last;	// a.k.a. ROM_I2CMasterControl()
 }
 
+/* push up to n bytes into the TX FIFO without checking I2C_O_FIFOSTATUS: the caller knows there is room
+ * the master and the slave both use it, whichever the TX FIFO is assigned to
+ */
+static void libti2cit_isr_fifo_fill(libti2cit_int_st * st, uint32_t n)
+{
+	if (n > st->len - st->nread) n = st->len - st->nread;
+	if (st->pec) {
+		while (n--) {
+			uint8_t b = st->buf[st->nread++];
+			st->private_crc = libti2cit_pec_add(st->private_crc, b);
+			HWREG(st->base + I2C_O_FIFODATA) = b;
+		}
+		return;
+	}
+	while (n--) HWREG(st->base + I2C_O_FIFODATA) = st->buf[st->nread++];
+}
 
+/* pop n bytes from the RX FIFO without checking I2C_O_FIFOSTATUS: the caller knows they are there
+ */
+static void libti2cit_m_isr_fifo_drain(libti2cit_int_st * st, uint32_t n)
+{
+	if (st->pec) {
+		while (n--) {
+			uint8_t b = HWREG(st->base + I2C_O_FIFODATA);
+			st->private_crc = libti2cit_pec_add(st->private_crc, b);
+			st->buf[st->nread++] = b;
+		}
+		return;
+	}
+	while (n--) st->buf[st->nread++] = HWREG(st->base + I2C_O_FIFODATA);
+}
 
+/* called from libti2cit_m_isr_isr() when a NACK or arbitration lost arrives during a FIFO or uDMA transfer
+ * the bursts are abandoned and the FIFOs flushed. After a NACK, send i2c STOP (unless the burst command already
+ * included one) so that user_cb gets I2C_MIMR_NACKIM now and I2C_MIMR_STOPIM after the STOP, just like a NACK from
+ * libti2cit_m_isr_nofifo_send()
+ */
+static void libti2cit_m_isr_fifo_abort(libti2cit_int_st * st, uint32_t status)
+{
+	st->private_nburst = 0;
+	HWREG(st->base + I2C_O_MIMR) &= ~(I2C_MIMR_TXIM | I2C_MIMR_RXIM | I2C_MIMR_DMARXIM);
+	HWREG(st->base + I2C_O_FIFOCTL) = (HWREG(st->base + I2C_O_FIFOCTL) & ~(I2C_FIFOCTL_DMATXENA | I2C_FIFOCTL_DMARXENA)) |
+		I2C_FIFOCTL_TXFLUSH | I2C_FIFOCTL_RXFLUSH;
+	if (!(status & I2C_MIMR_NACKIM)) return;
+
+	st->private_state = LIBTI2CIT_M_WAIT_STOP;
+	if (!(HWREG(st->base + I2C_O_MCS) & I2C_MCS_BUSY)) ROM_I2CMasterControl(st->base, I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+}
 
 /* see description in libti2cit.h
  */
-uint32_t libti2cit_s_int_clear(libti2cit_int_st * st)
+void libti2cit_m_isr_send(libti2cit_int_st * st)
 {
-	uint32_t status = HWREG(st->base + I2C_O_SMIS);
-	if (!status) return 0;
-	HWREG(st->base + I2C_O_SICR) = status;
-	return status;
+	if (!st->len) {
+		// nothing to put in the FIFO: quick_command or repeated start only
+		libti2cit_m_isr_nofifo_send(st);
+		return;
+	}
+	if (libti2cit_m_hs_code(st, LIBTI2CIT_M_FIFO_SEND)) return;
+
+	if (st->private_state != LIBTI2CIT_M_HS_CODE) st->nisr = 0;	// else libti2cit_m_hs_code() did, and counted the master code
+	st->nread = 0;	// counts bytes pushed into the TX FIFO
+	st->private_nburst = 0;
+	st->private_state = LIBTI2CIT_M_FIFO_SEND;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+
+	// the tiva i2c hardware wants the first data bytes before the i2c start condition is sent
+	st->private_crc = libti2cit_pec_add(0, st->addr & ~1);
+	libti2cit_m_fifo_tx_init(st->base, LIBTI2CIT_FIFO_TXTRIG << I2C_FIFOCTL_TXTRIG_S);
+	libti2cit_isr_fifo_fill(st, LIBTI2CIT_FIFO_LEN);
+	if (st->nread < st->len) HWREG(st->base + I2C_O_MIMR) |= I2C_MIMR_TXIM;
+
+	HWREG(st->base + I2C_O_MSA) = st->addr & ~1;	// data bytes are written; if addr bit 0 == 1 the repeated start comes after them
+	libti2cit_m_isr_fifo_burst(st, I2C_MASTER_CMD_FIFO_BURST_SEND_START,
+		((st->addr & 1) || st->pec) ? I2C_MASTER_CMD_FIFO_BURST_SEND_START : I2C_MASTER_CMD_FIFO_SINGLE_SEND);
 }
 
 /* see description in libti2cit.h
  */
-uint32_t libti2cit_s_isr_isr(libti2cit_int_st * st)
+void libti2cit_m_isr_recv(libti2cit_int_st * st)
 {
-	uint32_t status = libti2cit_s_int_clear(st);
-	if (!status) return 0;
-	if (status & (I2C_SIMR_STARTIM | I2C_SIMR_STOPIM)) {
-		UARTsend("s");
-		if (status & I2C_SIMR_STARTIM) UARTsend("_START");
-		if (status & I2C_SIMR_STOPIM) UARTsend("_STOP");
-		if (status & I2C_SIMR_DATAIM) {
-			UARTsend("_DATA: ");
-			return HWREG(st->base + I2C_O_SCSR);
-		}
+	if (st->len < 2) {
+		// the only byte is already in I2C_O_MDR, nothing to put in the FIFO (and len == 0 is an error)
+		libti2cit_m_isr_nofifo_recv(st);
+		return;
+	}
+
+	uint32_t mimr = HWREG(st->base + I2C_O_MIMR) & ~I2C_MIMR_STARTIM;	// bit was set in case libti2cit_m_isr_recvpart() would be called, clear it now
+	st->nisr = 0;
+
+	// first byte already received by i2c hardware
+	st->buf[0] = HWREG(st->base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+	st->private_crc = libti2cit_pec_add(st->private_crc, st->buf[0]);
+	st->nread = 1;
+	st->private_nburst = 1;
+	st->private_state = LIBTI2CIT_M_FIFO_RECV;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+
+	// with st->pec the last burst does not NACK: the PEC byte after it does, see libti2cit_m_isr_step()
+	libti2cit_m_fifo_rx_init(st->base, LIBTI2CIT_FIFO_RXTRIG << I2C_FIFOCTL_RXTRIG_S);
+	HWREG(st->base + I2C_O_MIMR) = mimr | I2C_MIMR_RXIM;
+	libti2cit_m_isr_fifo_burst(st, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT,
+		st->pec ? I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT : I2C_MASTER_CMD_FIFO_BURST_RECEIVE_FINISH);
+}
 
-		UARTsend(": ");
-		uint32_t r = 0;
-		if (status & I2C_SIMR_STARTIM) r |= LIBTI2CIT_ISR_S_START;
-		if (status & I2C_SIMR_STOPIM) r |= LIBTI2CIT_ISR_S_STOP;
-		return r;
+/* see description in libti2cit.h
+ */
+void libti2cit_m_isr_recvpart(libti2cit_int_st * st)
+{
+	if (!st->len) {
+		// I2C_MASTER_CMD_BURST_RECEIVE_FINISH: receive one more byte, NACK it and send i2c STOP
+		libti2cit_m_isr_nofifo_recvpart(st);
+		return;
 	}
 
-	if (!(status & I2C_SIMR_DATAIM)) {
-		UARTsend("s_isr_isr not DATAIM\r\n");
-		return 0;
+	uint32_t mimr = HWREG(st->base + I2C_O_MIMR);
+	st->nisr = 0;
+	st->nread = 0;
+	st->private_nburst = 0;
+	if (mimr & I2C_MIMR_STARTIM) {	// if this is the first time calling libti2cit_m_isr_recvpart()
+		mimr &= ~I2C_MIMR_STARTIM;
+
+		// first byte already received by i2c hardware
+		st->buf[0] = HWREG(st->base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+		st->private_crc = libti2cit_pec_add(st->private_crc, st->buf[0]);
+		st->nread = 1;
+		st->private_nburst = 1;
+		if (st->len == 1) {
+			HWREG(st->base + I2C_O_MIMR) = mimr;
+			libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// nothing left to receive
+			return;
+		}
 	}
-	return HWREG(st->base + I2C_O_SCSR);
+	st->private_state = LIBTI2CIT_M_FIFO_RECVPART;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+
+	libti2cit_m_fifo_rx_init(st->base, LIBTI2CIT_FIFO_RXTRIG << I2C_FIFOCTL_RXTRIG_S);
+	HWREG(st->base + I2C_O_MIMR) = mimr | I2C_MIMR_RXIM;
+	libti2cit_m_isr_fifo_burst(st, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT);
 }
+
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_syncfifo_send(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf)
+{
+	if (!len) return libti2cit_m_sync_send(base, addr, len, buf);	// quick command or repeated start only
+
+	HWREG(base + I2C_O_MICR) = I2C_MRIS_RIS | I2C_MRIS_NACKRIS;
+	uint8_t hs = libti2cit_speed_pick(base, addr);
+	if (hs && (hs = libti2cit_m_hs_send(base, hs, 0, 0))) return hs;
+
+	// the tiva i2c hardware wants the first data bytes before the i2c start condition is sent
+	uint32_t nput = 0, nburst = 0;
+	libti2cit_m_fifo_tx_init(base, LIBTI2CIT_FIFO_TXTRIG << I2C_FIFOCTL_TXTRIG_S);
+	while (nput < len && nput < LIBTI2CIT_FIFO_LEN) HWREG(base + I2C_O_FIFODATA) = buf[nput++];
+	HWREG(base + I2C_O_MSA) = addr & ~1;	// a.k.a. ROM_I2CMasterSlaveAddrSet(): if addr bit 0 == 1 the repeated start comes after the data
+
+	uint32_t cmd_cont = I2C_MASTER_CMD_FIFO_BURST_SEND_START;
+	uint32_t cmd_last = (addr & 1) ? I2C_MASTER_CMD_FIFO_BURST_SEND_START : I2C_MASTER_CMD_FIFO_SINGLE_SEND;
+	do {
+		uint32_t n = len - nburst;
+		if (n > LIBTI2CIT_BURST_MAX) n = LIBTI2CIT_BURST_MAX;
+		nburst += n;
+		HWREG(base + I2C_O_MBLEN) = n;
+		HWREG(base + I2C_O_MCS) = (nburst < len) ? cmd_cont : cmd_last;	// a.k.a. ROM_I2CMasterControl()
+
+		// the master runs the whole burst by itself: only keep the TX FIFO from running dry
+		uint32_t mris;
+		while (!((mris = HWREG(base + I2C_O_MRIS)) & I2C_MRIS_RIS)) {
+			if (nput >= len || !(HWREG(base + I2C_O_FIFOSTATUS) & I2C_FIFOSTATUS_TXBLWTRIG)) continue;
+			uint32_t k = LIBTI2CIT_FIFO_LEN - LIBTI2CIT_FIFO_TXTRIG;
+			while (k-- && nput < len) HWREG(base + I2C_O_FIFODATA) = buf[nput++];
+		}
+		HWREG(base + I2C_O_MICR) = mris;
+		if (mris & I2C_MRIS_NACKRIS) {
+			HWREG(base + I2C_O_FIFOCTL) |= I2C_FIFOCTL_TXFLUSH;
+			// I2C_O_MBCNT counted the NACKed byte too: what is left of the burst was not sent
+			n = nburst - HWREG(base + I2C_O_MBCNT);
+			if ((HWREG(base + I2C_O_MCS) & I2C_MCS_ADRACK) || n == 1) return 1;	// libti2cit_m_sync_send() sends the first byte with the address
+			n = len - n;
+			return (n < LIBTI2CIT_PEC_ERROR - 3) ? 3 + n : LIBTI2CIT_PEC_ERROR - 1;
+		}
+		if (HWREG(base + I2C_O_MCS) & I2C_MCS_ARBLST) {
+			HWREG(base + I2C_O_FIFOCTL) |= I2C_FIFOCTL_TXFLUSH;
+			return 2;
+		}
+		cmd_cont = I2C_MASTER_CMD_FIFO_BURST_SEND_CONT;
+		cmd_last = (addr & 1) ? I2C_MASTER_CMD_FIFO_BURST_SEND_CONT : I2C_MASTER_CMD_FIFO_BURST_SEND_FINISH;
+	} while (nburst < len);
+
+	if (addr & 1) {
+		// the repeated start, as libti2cit_m_sync_send() does it but without a second libti2cit_speed_pick(): the
+		// transaction is already at the speed of addr, and in High-Speed mode a master code now would break it
+		HWREG(base + I2C_O_MIMR) |= I2C_MIMR_STARTIM;	// signal a repeated start for libti2cit_m_sync_recvpart()
+		HWREG(base + I2C_O_MSA) = addr;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
+		if (libti2cit_m_continue(base, I2C_MASTER_CMD_BURST_RECEIVE_START, 0, 0)) return 1;
+		if (HWREG(base + I2C_O_MCS) & I2C_MCS_ARBLST) return 2;
+		return 0;
+	}
+	libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0, 0, 0);
+	return 0;
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_m_syncfifo_recv(uint32_t base, uint32_t len, uint8_t * buf)
+{
+	if (len < 2) return libti2cit_m_sync_recv(base, len, buf);	// the only byte is already in I2C_O_MDR
+
+	HWREG(base + I2C_O_MIMR) &= ~I2C_MIMR_STARTIM;	// bit was set in case libti2cit_m_sync_recvpart() would be called, clear it now
+	buf[0] = HWREG(base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+	uint32_t nread = 1, nburst = 1;
+	libti2cit_m_fifo_rx_init(base, LIBTI2CIT_FIFO_RXTRIG << I2C_FIFOCTL_RXTRIG_S);
+	do {
+		uint32_t n = len - nburst;
+		if (n > LIBTI2CIT_BURST_MAX) n = LIBTI2CIT_BURST_MAX;
+		nburst += n;
+		HWREG(base + I2C_O_MBLEN) = n;
+		HWREG(base + I2C_O_MCS) = (nburst < len) ? I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT :
+			I2C_MASTER_CMD_FIFO_BURST_RECEIVE_FINISH;	// a.k.a. ROM_I2CMasterControl()
+
+		// empty the RX FIFO before it fills up and the master has to hold SCL
+		uint32_t mris, k;
+		while (!((mris = HWREG(base + I2C_O_MRIS)) & I2C_MRIS_RIS)) {
+			if (!(HWREG(base + I2C_O_FIFOSTATUS) & I2C_FIFOSTATUS_RXABVTRIG)) continue;
+			for (k = LIBTI2CIT_FIFO_RXTRIG; k; k--) buf[nread++] = HWREG(base + I2C_O_FIFODATA);
+		}
+		HWREG(base + I2C_O_MICR) = mris;
+		while (nread < nburst) buf[nread++] = HWREG(base + I2C_O_FIFODATA);
+	} while (nburst < len);
+
+	libti2cit_mris_wait(base, I2C_MRIS_STOPRIS | I2C_MRIS_RIS, 0, 0, 0);
+	return 0;
+}
+
+
+
+/* uDMA settings for libti2cit_m_isrdma_...(): the uDMA keeps the FIFO topped up (TX) or empty (RX)
+ * TX: the FIFO requests the uDMA when it holds LIBTI2CIT_DMA_TXTRIG bytes or less, the uDMA then moves 4 bytes
+ * RX: the FIFO requests the uDMA when it holds 1 byte or more, the uDMA then moves 1 byte
+ */
+#define LIBTI2CIT_DMA_TXTRIG (4)
+#define LIBTI2CIT_DMA_CTL_TX (UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4)
+#define LIBTI2CIT_DMA_CTL_RX (UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_1)
+
+/* program the uDMA for the next burst, then start the burst
+ *   a burst is at most LIBTI2CIT_BURST_MAX bytes, well under the 1024 transfers of one uDMA basic mode transfer
+ */
+static void libti2cit_m_isrdma_burst(libti2cit_int_st * st, uint32_t rx, uint32_t cmd_cont, uint32_t cmd_last)
+{
+	void * fifo = (void *) (st->base + I2C_O_FIFODATA);
+	uint8_t * mem = st->buf + st->private_nburst;
+	uint32_t n = st->len - st->private_nburst;
+	if (n > LIBTI2CIT_BURST_MAX) n = LIBTI2CIT_BURST_MAX;
+
+	uint32_t ch = rx ? st->dma_rx : st->dma_tx;
+	ROM_uDMAChannelTransferSet(ch | UDMA_PRI_SELECT, UDMA_MODE_BASIC, rx ? fifo : mem, rx ? mem : fifo, n);
+	ROM_uDMAChannelEnable(ch);
+	libti2cit_m_isr_fifo_burst(st, cmd_cont, cmd_last);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_m_isrdma_send(libti2cit_int_st * st)
+{
+	if (!st->len) {
+		// nothing for the uDMA to do: quick_command or repeated start only
+		libti2cit_m_isr_nofifo_send(st);
+		return;
+	}
+	if (st->pec) {
+		// the uDMA bypasses the cpu, but every byte has to go into the PEC
+		libti2cit_m_isr_send(st);
+		return;
+	}
+	if (libti2cit_m_hs_code(st, LIBTI2CIT_M_DMA_SEND)) return;
+
+	if (st->private_state != LIBTI2CIT_M_HS_CODE) st->nisr = 0;	// else libti2cit_m_hs_code() did, and counted the master code
+	st->nread = 0;
+	st->private_nburst = 0;
+	st->private_state = LIBTI2CIT_M_DMA_SEND;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+
+	ROM_uDMAChannelControlSet(st->dma_tx | UDMA_PRI_SELECT, LIBTI2CIT_DMA_CTL_TX);
+	libti2cit_m_fifo_tx_init(st->base, I2C_FIFOCTL_DMATXENA | (LIBTI2CIT_DMA_TXTRIG << I2C_FIFOCTL_TXTRIG_S));
+
+	HWREG(st->base + I2C_O_MSA) = st->addr & ~1;	// data bytes are written; if addr bit 0 == 1 the repeated start comes after them
+	libti2cit_m_isrdma_burst(st, 0, I2C_MASTER_CMD_FIFO_BURST_SEND_START,
+		(st->addr & 1) ? I2C_MASTER_CMD_FIFO_BURST_SEND_START : I2C_MASTER_CMD_FIFO_SINGLE_SEND);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_m_isrdma_recv(libti2cit_int_st * st)
+{
+	if (st->len < 2) {
+		// the only byte is already in I2C_O_MDR, nothing for the uDMA to do (and len == 0 is an error)
+		libti2cit_m_isr_nofifo_recv(st);
+		return;
+	}
+	if (st->pec) {
+		libti2cit_m_isr_recv(st);
+		return;
+	}
+
+	uint32_t mimr = HWREG(st->base + I2C_O_MIMR) & ~I2C_MIMR_STARTIM;	// bit was set in case libti2cit_m_isr_recvpart() would be called, clear it now
+	st->nisr = 0;
+
+	// first byte already received by i2c hardware
+	st->buf[0] = HWREG(st->base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+	st->nread = 1;
+	st->private_nburst = 1;
+	st->private_state = LIBTI2CIT_M_DMA_RECV;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+
+	ROM_uDMAChannelControlSet(st->dma_rx | UDMA_PRI_SELECT, LIBTI2CIT_DMA_CTL_RX);
+	libti2cit_m_fifo_rx_init(st->base, I2C_FIFOCTL_DMARXENA | (1 << I2C_FIFOCTL_RXTRIG_S));
+	HWREG(st->base + I2C_O_MIMR) = mimr | I2C_MIMR_DMARXIM;
+	libti2cit_m_isrdma_burst(st, 1, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_FINISH);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_m_isrdma_recvpart(libti2cit_int_st * st)
+{
+	if (!st->len) {
+		// I2C_MASTER_CMD_BURST_RECEIVE_FINISH: receive one more byte, NACK it and send i2c STOP
+		libti2cit_m_isr_nofifo_recvpart(st);
+		return;
+	}
+	if (st->pec) {
+		libti2cit_m_isr_recvpart(st);
+		return;
+	}
+
+	uint32_t mimr = HWREG(st->base + I2C_O_MIMR);
+	st->nisr = 0;
+	st->nread = 0;
+	st->private_nburst = 0;
+	if (mimr & I2C_MIMR_STARTIM) {	// if this is the first time calling libti2cit_m_isrdma_recvpart()
+		mimr &= ~I2C_MIMR_STARTIM;
+
+		// first byte already received by i2c hardware
+		st->buf[0] = HWREG(st->base + I2C_O_MDR); /* a.k.a. ROM_I2CMasterDataGet() */
+		st->nread = 1;
+		st->private_nburst = 1;
+		if (st->len == 1) {
+			HWREG(st->base + I2C_O_MIMR) = mimr;
+			libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// nothing left to receive
+			return;
+		}
+	}
+	st->private_state = LIBTI2CIT_M_DMA_RECVPART;
+	LIBTI2CIT_TRACE(M_START, st, st->private_state, st->len);
+
+	ROM_uDMAChannelControlSet(st->dma_rx | UDMA_PRI_SELECT, LIBTI2CIT_DMA_CTL_RX);
+	libti2cit_m_fifo_rx_init(st->base, I2C_FIFOCTL_DMARXENA | (1 << I2C_FIFOCTL_RXTRIG_S));
+	HWREG(st->base + I2C_O_MIMR) = mimr | I2C_MIMR_DMARXIM;
+	libti2cit_m_isrdma_burst(st, 1, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT, I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT);
+}
+
+
+
+
+/* run st->private_state for the interrupts in status
+ * one table lookup and one switch: libti2cit_m_isr_action[] already says which interrupts matter and which
+ * command comes next, so there is no function pointer to call and nothing to work out from nread, len and addr
+ */
+static void libti2cit_m_isr_step(libti2cit_int_st * st, uint32_t status)
+{
+	const libti2cit_m_action * a = &libti2cit_m_isr_action[st->private_state];
+	if (!(status & a->wait)) return;
+
+	switch (st->private_state) {
+	case LIBTI2CIT_M_WAIT_STOP:
+	case LIBTI2CIT_M_WAIT_RIS:
+		libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
+		return;
+
+	case LIBTI2CIT_M_NOFIFO_SEND:
+		if (st->nread >= st->len) {
+			libti2cit_m_isr_send_done(st, status);
+			return;
+		}
+		HWREG(st->base + I2C_O_MDR) = st->buf[st->nread]; // a.k.a. ROM_I2CMasterDataPut()
+		if (st->pec) st->private_crc = libti2cit_pec_add(st->private_crc, st->buf[st->nread]);
+		st->nread++;
+		HWREG(st->base + I2C_O_MCS) = (st->nread < st->len) ? a->cmd_cont : libti2cit_m_isr_cmd_last(st, a);	// a.k.a. ROM_I2CMasterControl()
+		return;
+
+	case LIBTI2CIT_M_NOFIFO_RECV:
+		if (st->nread >= st->len) {
+			// wait for STOPIM. I2C_O_MDR has the byte after the last one, the PEC byte if there is one
+			if (!(status & I2C_MIMR_STOPIM)) return;
+			if (st->pec && libti2cit_pec_add(st->private_crc, HWREG(st->base + I2C_O_MDR))) {
+				libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM | LIBTI2CIT_ISR_PEC);	// signal all done, but the data is bad
+				return;
+			}
+			libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
+			return;
+		}
+		if (!(status & I2C_MIMR_IM)) return;
+		// fall through
+	case LIBTI2CIT_M_NOFIFO_RECVPART:
+		st->buf[st->nread] = HWREG(st->base + I2C_O_MDR) /* a.k.a. ROM_I2CMasterDataGet() */;
+		if (st->pec) st->private_crc = libti2cit_pec_add(st->private_crc, st->buf[st->nread]);
+		st->nread++;
+		if (st->nread >= st->len && !a->stop) {
+			libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done (but no i2c STOP occurred)
+			return;
+		}
+		HWREG(st->base + I2C_O_MCS) = (st->nread < st->len) ? a->cmd_cont : a->cmd_last;	// a.k.a. ROM_I2CMasterControl()
+		return;
+
+	case LIBTI2CIT_M_FIFO_SEND:
+		if (status & I2C_MIMR_TXIM) {
+			// TX FIFO is at or below LIBTI2CIT_FIFO_TXTRIG
+			libti2cit_isr_fifo_fill(st, LIBTI2CIT_FIFO_LEN - LIBTI2CIT_FIFO_TXTRIG);
+			if (st->nread >= st->len) HWREG(st->base + I2C_O_MIMR) &= ~I2C_MIMR_TXIM;	// everything is queued
+		}
+
+		// wait for RIS: the burst is complete
+		if (!(status & I2C_MIMR_IM)) return;
+		if (st->private_nburst < st->len) {
+			libti2cit_m_isr_fifo_burst(st, a->cmd_cont, libti2cit_m_isr_cmd_last(st, a));
+			return;
+		}
+		libti2cit_m_isr_send_done(st, status);
+		return;
+
+	case LIBTI2CIT_M_FIFO_RECV:
+	case LIBTI2CIT_M_FIFO_RECVPART:
+		// RX FIFO is at or above LIBTI2CIT_FIFO_RXTRIG
+		if (status & I2C_MIMR_RXIM) libti2cit_m_isr_fifo_drain(st, LIBTI2CIT_FIFO_RXTRIG);
+
+		// wait for RIS: the burst is complete and whatever is left of it is in the RX FIFO
+		if (!(status & I2C_MIMR_IM)) return;
+		libti2cit_m_isr_fifo_drain(st, st->private_nburst - st->nread);
+		if (st->private_nburst < st->len) {
+			libti2cit_m_isr_fifo_burst(st, a->cmd_cont, st->pec ? a->cmd_cont : a->cmd_last);
+			return;
+		}
+		HWREG(st->base + I2C_O_MIMR) &= ~I2C_MIMR_RXIM;
+		if (!a->stop) {
+			libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done (but no i2c STOP occurred)
+			return;
+		}
+		if (st->pec) {
+			// receive the PEC byte into I2C_O_MDR, NACK it and send i2c STOP: LIBTI2CIT_M_NOFIFO_RECV checks it
+			st->private_nburst = 0;
+			st->private_state = LIBTI2CIT_M_NOFIFO_RECV;
+			HWREG(st->base + I2C_O_MCS) = I2C_MASTER_CMD_BURST_RECEIVE_FINISH;	// a.k.a. ROM_I2CMasterControl()
+			return;
+		}
+
+		// the final burst sent i2c STOP, it may be in this same interrupt
+		st->private_state = LIBTI2CIT_M_WAIT_STOP;
+		if (status & I2C_MIMR_STOPIM) libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done
+		return;
+
+	case LIBTI2CIT_M_DMA_SEND:
+		// RIS: the burst is complete, which means the uDMA is done too
+		st->nread = st->private_nburst;
+		if (st->private_nburst < st->len) {
+			libti2cit_m_isrdma_burst(st, a->rx, a->cmd_cont, libti2cit_m_isr_cmd_last(st, a));
+			return;
+		}
+		libti2cit_m_isr_send_done(st, status);
+		return;
+
+	case LIBTI2CIT_M_DMA_RECV:
+	case LIBTI2CIT_M_DMA_RECVPART:
+		// a burst is complete when both the i2c master (RIS, or STOP after the final burst) and the uDMA (DMARX) are
+		// done, and they can finish in either order
+		if (HWREG(st->base + I2C_O_MCS) & I2C_MCS_BUSY) return;
+		if (ROM_uDMAChannelModeGet(st->dma_rx | UDMA_PRI_SELECT) != UDMA_MODE_STOP) return;
+
+		st->nread = st->private_nburst;
+		if (st->private_nburst < st->len) {
+			libti2cit_m_isrdma_burst(st, a->rx, a->cmd_cont, a->cmd_last);
+			return;
+		}
+		HWREG(st->base + I2C_O_MIMR) &= ~I2C_MIMR_DMARXIM;
+		libti2cit_m_isr_finish(st, I2C_MIMR_STOPIM);	// signal all done (after i2c STOP unless this is recvpart)
+		return;
+
+	case LIBTI2CIT_M_HS_CODE:
+		if (status & I2C_MIMR_ARBLOSTIM) {
+			libti2cit_m_isr_finish(st, status);	// another master won, there is no STOP to wait for
+			return;
+		}
+		// the master code was NACKed, as it always is: the repeated start of the send is in High-Speed mode
+		switch (st->private_next) {
+		case LIBTI2CIT_M_NOFIFO_SEND: libti2cit_m_isr_nofifo_send(st); return;
+		case LIBTI2CIT_M_FIFO_SEND: libti2cit_m_isr_send(st); return;
+		case LIBTI2CIT_M_DMA_SEND: libti2cit_m_isrdma_send(st); return;
+		}
+		return;
+	}
+}
+
+
+
+
+/* start xfer[ixfer] of a libti2cit_m_isr_queue() batch
+ *   st->addr bit 0 is set while the write (or the repeated start) of a transaction with rlen != 0 is running
+ */
+static void libti2cit_m_isr_queue_start(libti2cit_int_st * st)
+{
+	libti2cit_xfer_st * x = &st->xfer[st->ixfer];
+	x->status = 0;
+	st->addr = (x->addr & ~1) | (x->rlen ? 1 : 0);
+	st->buf = (uint8_t *) x->wbuf;
+	st->len = x->wlen;
+	libti2cit_m_isr_send(st);
+}
+
+/* called by libti2cit_m_isr_finish() in place of user_cb while a batch runs
+ */
+static void libti2cit_m_isr_queue_step(libti2cit_int_st * st, uint32_t status)
+{
+	libti2cit_xfer_st * x = &st->xfer[st->ixfer];
+	if (status & I2C_MIMR_NACKIM) {
+		x->status = I2C_MIMR_NACKIM;
+		// a FIFO write sends i2c STOP itself, a read with no write (I2C_MASTER_CMD_BURST_RECEIVE_START) does not
+		if (!x->wlen && x->rlen) libti2cit_m_isr_fifo_abort(st, status);
+		return;	// wait for STOPIM
+	}
+
+	if (status & (I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM)) {
+		x->status = status & (I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM);
+		st->xfer = 0;
+		if (st->user_cb) st->user_cb(st, status);
+		return;
+	}
+
+	if ((st->addr & 1) && !x->status) {
+		// the repeated start is done and the first byte is in I2C_O_MDR
+		st->addr &= ~1;
+		st->buf = x->rbuf;
+		st->len = x->rlen;
+		libti2cit_m_isr_recv(st);
+		return;
+	}
+
+	x->status |= status & LIBTI2CIT_ISR_PEC;
+	if (st->recover) st->recover->private_nretry = 0;
+	st->ixfer++;
+	if (st->ixfer < st->nxfer) {
+		libti2cit_m_isr_queue_start(st);
+		return;
+	}
+
+	// the batch is done: st->xfer = 0 first so user_cb can start another batch
+	uint32_t i;
+	status = I2C_MIMR_STOPIM;
+	for (i = 0; i < st->nxfer; i++) status |= st->xfer[i].status;
+	st->xfer = 0;
+	if (st->user_cb) st->user_cb(st, status);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_m_isr_queue(libti2cit_int_st * st)
+{
+	st->ixfer = 0;
+	if (st->recover) st->recover->private_nretry = 0;
+	if (!st->nxfer) {
+		st->xfer = 0;
+		if (st->user_cb) st->user_cb(st, I2C_MIMR_STOPIM);
+		return;
+	}
+	libti2cit_m_isr_queue_start(st);
+}
+
+
+
+
+/* send the quick command for the address in st->addr
+ *   st->addr bit 0 is set by libti2cit_m_scan_step() when the address got a NACK
+ */
+static void libti2cit_m_scan_start(libti2cit_int_st * st)
+{
+	st->addr &= ~1;
+	st->buf = 0;
+	st->len = 0;
+	libti2cit_m_isr_nofifo_send(st);
+}
+
+/* called by libti2cit_m_isr_finish() in place of user_cb while a scan runs
+ */
+static void libti2cit_m_scan_step(libti2cit_int_st * st, uint32_t status)
+{
+	if (status & I2C_MIMR_NACKIM) {
+		st->addr |= 1;	// no device: the quick command still sends i2c STOP
+		return;
+	}
+
+	if (status & (I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM)) {
+		st->scan = 0;
+		if (st->user_cb) st->user_cb(st, status);
+		return;
+	}
+
+	uint32_t a = st->addr >> 1;
+	if (!(st->addr & 1)) st->scan[a >> 5] |= 1u << (a & 31);
+	if (st->recover) st->recover->private_nretry = 0;
+	if (a < 127) {
+		st->addr = (a + 1) << 1;
+		libti2cit_m_scan_start(st);
+		return;
+	}
+
+	st->scan = 0;
+	if (st->user_cb) st->user_cb(st, I2C_MIMR_STOPIM);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_m_scan(libti2cit_int_st * st)
+{
+	st->scan[0] = st->scan[1] = st->scan[2] = st->scan[3] = 0;
+	if (st->recover) st->recover->private_nretry = 0;
+	st->addr = 1 << 1;
+	libti2cit_m_scan_start(st);
+}
+
+
+
+
+static const uint32_t libti2cit_mgr_base[LIBTI2CIT_MGR_NBUS] = {
+	I2C0_BASE, I2C1_BASE, I2C2_BASE, I2C3_BASE, I2C4_BASE, I2C5_BASE, I2C6_BASE, I2C7_BASE, I2C8_BASE, I2C9_BASE,
+};
+
+/* start q[rd] on an idle bus
+ */
+static void libti2cit_mgr_start(libti2cit_mgr_bus_st * b)
+{
+	b->st.xfer = b->q[b->rd % LIBTI2CIT_MGR_QLEN];
+	b->st.nxfer = 1;
+	libti2cit_m_isr_queue(&b->st);
+}
+
+/* user_cb of every bus: q[rd] is done, start the next one from this same interrupt
+ */
+static void libti2cit_mgr_done(libti2cit_int_st * st, uint32_t status)
+{
+	libti2cit_mgr_bus_st * b = (libti2cit_mgr_bus_st *) st;
+	libti2cit_xfer_st * x = b->q[b->rd % LIBTI2CIT_MGR_QLEN];
+	b->nxfer++;
+	b->nbytes += x->wlen + x->rlen;
+	b->rd++;
+	if (b->mgr->done) b->mgr->done(b->mgr, b->id, x);
+
+	if (b->rd != b->wr) {
+		libti2cit_mgr_start(b);
+		return;
+	}
+	b->busy += HWREG(LIBTI2CIT_DWT_CYCCNT) - b->t_start;
+	b->running = 0;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_mgr_init(libti2cit_mgr_st * mgr, libti2cit_mgr_cb done)
+{
+	char * p = (char *) mgr;
+	uint32_t len = sizeof(*mgr);
+	while (len) {
+		*(p++) = 0;
+		len--;
+	}
+
+	uint32_t i;
+	for (i = 0; i < LIBTI2CIT_MGR_NBUS; i++) {
+		libti2cit_mgr_bus_st * b = &mgr->bus[i];
+		b->st.base = libti2cit_mgr_base[i];
+		b->st.user_cb = libti2cit_mgr_done;
+		b->mgr = mgr;
+		b->id = i;
+	}
+	mgr->done = done;
+	mgr->t0 = libti2cit_cyccnt_start(1);
+}
+
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_mgr_submit(libti2cit_mgr_st * mgr, uint32_t id, libti2cit_xfer_st * x)
+{
+	libti2cit_mgr_bus_st * b = &mgr->bus[id];
+	if (b->wr - b->rd >= LIBTI2CIT_MGR_QLEN) return 1;
+	b->q[b->wr % LIBTI2CIT_MGR_QLEN] = x;
+	b->wr++;
+
+	// if the interrupt finishes the last transaction after this, it sees wr and starts x itself
+	if (!b->running) {
+		b->running = 1;
+		b->t_start = HWREG(LIBTI2CIT_DWT_CYCCNT);
+		libti2cit_mgr_start(b);
+	}
+	return 0;
+}
+
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_mgr_isr(libti2cit_mgr_st * mgr, uint32_t id)
+{
+	return libti2cit_m_isr_isr(&mgr->bus[id].st);
+}
+
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_mgr_util(libti2cit_mgr_st * mgr, uint32_t id)
+{
+	libti2cit_mgr_bus_st * b = &mgr->bus[id];
+	uint32_t now = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	uint32_t busy = b->busy;
+	if (b->running) busy += now - b->t_start;
+	uint32_t total = now - mgr->t0;
+	if (!total) return 0;
+	return (uint32_t) ((uint64_t) busy * 1000 / total);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_mgr_util_clear(libti2cit_mgr_st * mgr)
+{
+	uint32_t i;
+	mgr->t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	for (i = 0; i < LIBTI2CIT_MGR_NBUS; i++) {
+		libti2cit_mgr_bus_st * b = &mgr->bus[i];
+		b->busy = 0;
+		b->nxfer = 0;
+		b->nbytes = 0;
+		b->t_start = mgr->t0;	// a running bus counts from now
+	}
+}
+
+
+
+
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_m_recover(uint32_t base, libti2cit_recover_st * r)
+{
+	uint32_t port = r->gpio_base;
+	uint32_t pins = r->scl | r->sda;
+	uint32_t i;
+	r->nrecover++;
+
+	// take the pins from the i2c controller: inputs with the pull-ups, and a pin pulls its line low when it is an output
+	HWREG(port + GPIO_O_DATA + (pins << 2)) = 0;
+	HWREG(port + GPIO_O_DIR) &= ~pins;
+	HWREG(port + GPIO_O_AFSEL) &= ~pins;
+
+	// a slave in the middle of sending a byte lets go of SDA after at most 8 data bits and the ACK bit
+	for (i = 0; i < 9 && !HWREG(port + GPIO_O_DATA + (r->sda << 2)); i++) {
+		HWREG(port + GPIO_O_DIR) |= r->scl;
+		ROM_SysCtlDelay(r->half_bit);
+		HWREG(port + GPIO_O_DIR) &= ~r->scl;
+		ROM_SysCtlDelay(r->half_bit);
+	}
+
+	// i2c STOP: SDA goes low while SCL is low, then SCL goes high, then SDA goes high
+	HWREG(port + GPIO_O_DIR) |= r->scl;
+	ROM_SysCtlDelay(r->half_bit);
+	HWREG(port + GPIO_O_DIR) |= r->sda;
+	ROM_SysCtlDelay(r->half_bit);
+	HWREG(port + GPIO_O_DIR) &= ~r->scl;
+	ROM_SysCtlDelay(r->half_bit);
+	HWREG(port + GPIO_O_DIR) &= ~r->sda;
+	ROM_SysCtlDelay(r->half_bit);
+	uint32_t lines = HWREG(port + GPIO_O_DATA + (pins << 2));
+
+	// give the pins back, then restart the master: clearing I2C_MCR_MFE resets its state machine
+	HWREG(port + GPIO_O_AFSEL) |= pins;
+	uint32_t mcr = HWREG(base + I2C_O_MCR);
+	HWREG(base + I2C_O_MCR) = mcr & ~I2C_MCR_MFE;
+	HWREG(base + I2C_O_MCR) = mcr;
+	HWREG(base + I2C_O_FIFOCTL) |= I2C_FIFOCTL_TXFLUSH | I2C_FIFOCTL_RXFLUSH;
+	uint32_t mris = HWREG(base + I2C_O_MRIS);
+	HWREG(base + I2C_O_MICR) = mris;
+
+	if (!(lines & r->scl)) return 2;
+	if (!(lines & r->sda)) return 1;
+	return 0;
+}
+
+/* after I2C_MIMR_ARBLOSTIM: is a slave holding the bus, or did another master win it?
+ * automatic recovery assumes this is the only master on the bus: this check keeps it from clocking SCL through the
+ * transfer of a master that just won arbitration. I2C_O_MBMON is read every quarter SCL period for one period: another
+ * master's transfer toggles SCL, a stuck bus does not move and has SDA or SCL low
+ * returns 1 if the bus is stuck
+ */
+static uint32_t libti2cit_m_bus_stuck(uint32_t base, libti2cit_recover_st * r)
+{
+	uint32_t lines = HWREG(base + I2C_O_MBMON) & (I2C_MBMON_SDA | I2C_MBMON_SCL);
+	uint32_t i;
+	if (lines == (I2C_MBMON_SDA | I2C_MBMON_SCL)) return 0;	// the bus is idle again, or between two bits
+	for (i = 0; i < 4; i++) {
+		ROM_SysCtlDelay(r->half_bit / 2 + 1);	// ROM_SysCtlDelay(0) would wait 2^32 loops
+		if ((HWREG(base + I2C_O_MBMON) & (I2C_MBMON_SDA | I2C_MBMON_SCL)) != lines) return 0;
+	}
+	return 1;
+}
+
+/* called from libti2cit_m_isr_isr() on I2C_MIMR_CLKIM, or I2C_MIMR_ARBLOSTIM on a stuck bus, when st->recover is set
+ */
+static uint32_t libti2cit_m_isr_recover(libti2cit_int_st * st, uint32_t status)
+{
+	libti2cit_m_isr_fifo_abort(st, status & ~I2C_MIMR_NACKIM);
+	HWREG(st->base + I2C_O_MIMR) &= ~I2C_MIMR_STARTIM;
+	uint32_t r = libti2cit_m_recover(st->base, st->recover);
+	if (!r && (st->xfer || st->scan) && st->recover->private_nretry < LIBTI2CIT_RECOVER_RETRY) {
+		// resume the batch at xfer[ixfer], or the scan at the same address
+		st->recover->private_nretry++;
+		st->private_state = LIBTI2CIT_M_IDLE;
+		if (st->xfer) libti2cit_m_isr_queue_start(st);
+		else libti2cit_m_scan_start(st);
+		return status;
+	}
+	return libti2cit_m_isr_finish(st, status);
+}
+
+
+
+
+/* libti2cit_nvm_...(): one state machine for both engines
+ *   libti2cit_nvm_plan() fills in private_xfer for the next step, the engine runs them, libti2cit_nvm_result() looks
+ *   at the outcome and picks the next step. The sync engine loops, the isr engine runs each step from the interrupt
+ */
+#define LIBTI2CIT_NVM_MORE (0x100)	// not a return code: libti2cit_nvm_result() wants another step
+// a page write NACKed at its first data byte returns 3 + LIBTI2CIT_NVM_PAGE: it must not look like LIBTI2CIT_NVM_FAIL
+typedef char libti2cit_nvm_page_check[(LIBTI2CIT_NVM_PAGE + 3 < LIBTI2CIT_NVM_FAIL) ? 1 : -1];
+enum {
+	LIBTI2CIT_NVM_POLL = 0,	// quick command, until the device ACKs
+	LIBTI2CIT_NVM_OP,	// the next block of a read, page of a write, or HIH command and status read
+	LIBTI2CIT_NVM_STATUS,	// HIH status read, until it is not busy
+};
+
+static uint32_t libti2cit_nvm_begin(libti2cit_nvm_st * nvm, uint32_t write, uint32_t mem, uint32_t len, uint8_t * buf)
+{
+	nvm->private_write = write;
+	nvm->private_mem = mem;
+	nvm->private_len = len;
+	nvm->private_buf = buf;
+	nvm->private_t0 = libti2cit_cyccnt_start(nvm->timeout);
+	nvm->private_phase = nvm->private_busy ? LIBTI2CIT_NVM_POLL : LIBTI2CIT_NVM_OP;
+	if (nvm->private_phase == LIBTI2CIT_NVM_OP && !len) return 0;
+	return LIBTI2CIT_NVM_MORE;
+}
+
+static uint32_t libti2cit_nvm_plan(libti2cit_nvm_st * nvm)
+{
+	libti2cit_xfer_st * x = nvm->private_xfer;
+	uint8_t * w = nvm->private_wbuf;
+	uint32_t mem = nvm->private_mem;
+	x[0].addr = nvm->addr << 1;
+	x[0].wbuf = w;
+	x[0].wlen = 0;
+	x[0].rbuf = 0;
+	x[0].rlen = 0;
+	x[1] = x[0];
+	x[1].wbuf = 0;
+	x[1].rbuf = w;
+	x[1].rlen = nvm->private_write ? 1 : 3;	// status, or status and the word
+
+	if (nvm->private_phase == LIBTI2CIT_NVM_POLL) return 1;
+	if (nvm->private_phase == LIBTI2CIT_NVM_STATUS) {
+		x[0] = x[1];
+		return 1;
+	}
+
+	if (nvm->type == LIBTI2CIT_NVM_HIH) {
+		w[0] = ((mem >> 1) & 0x1f) | (nvm->private_write ? 0x40 : 0);
+		w[1] = nvm->private_write ? nvm->private_buf[0] : 0;
+		w[2] = nvm->private_write ? nvm->private_buf[1] : 0;
+		x[0].wlen = 3;
+		return 2;
+	}
+
+	// 24Cxx: address bits above addr_bytes go in the device address, a read stops at the end of that block
+	uint32_t shift = 8 * nvm->addr_bytes;
+	uint32_t n = nvm->private_len, i;
+	x[0].addr |= (mem >> shift) << 1;
+	for (i = 0; i < nvm->addr_bytes; i++) w[i] = mem >> (shift - 8 * (i + 1));
+	x[0].wlen = nvm->addr_bytes;
+	if (!nvm->private_write) {
+		uint32_t block = (1 << shift) - (mem & ((1 << shift) - 1));
+		if (n > block) n = block;
+		x[0].rbuf = nvm->private_buf;
+		x[0].rlen = n;
+	} else {
+		uint32_t page = nvm->page - mem % nvm->page;
+		if (n > page) n = page;
+		if (n > LIBTI2CIT_NVM_PAGE) n = LIBTI2CIT_NVM_PAGE;
+		for (i = 0; i < n; i++) w[nvm->addr_bytes + i] = nvm->private_buf[i];
+		x[0].wlen += n;
+	}
+	nvm->private_n = n;
+	return 1;
+}
+
+/* r is the outcome of the step, as a libti2cit_m_sync_...() return code
+ * returns LIBTI2CIT_NVM_MORE, or the return code of the whole call
+ */
+static uint32_t libti2cit_nvm_result(libti2cit_nvm_st * nvm, uint32_t r)
+{
+	if (nvm->private_phase == LIBTI2CIT_NVM_POLL) {
+		if (r == 1) {
+			nvm->npoll++;
+			return libti2cit_expired(nvm->private_t0, nvm->timeout) ? LIBTI2CIT_TIMEOUT : LIBTI2CIT_NVM_MORE;
+		}
+		if (r) return r;
+		nvm->private_busy = 0;
+		nvm->private_phase = LIBTI2CIT_NVM_OP;
+		return nvm->private_len ? LIBTI2CIT_NVM_MORE : 0;
+	}
+	if (r) return r;
+
+	uint32_t n = nvm->private_n;
+	if (nvm->type == LIBTI2CIT_NVM_HIH) {
+		uint8_t * w = nvm->private_wbuf;
+		if (!(w[0] & 3)) {
+			// still busy: the timeout starts at the first status read
+			if (nvm->private_phase == LIBTI2CIT_NVM_OP) nvm->private_t0 = libti2cit_cyccnt_start(nvm->timeout);
+			else if (libti2cit_expired(nvm->private_t0, nvm->timeout)) return LIBTI2CIT_TIMEOUT;
+			nvm->npoll++;
+			nvm->private_phase = LIBTI2CIT_NVM_STATUS;
+			return LIBTI2CIT_NVM_MORE;
+		}
+		if ((w[0] & 3) != 1) return LIBTI2CIT_NVM_FAIL;
+		if (!nvm->private_write) {
+			nvm->private_buf[0] = w[1];
+			nvm->private_buf[1] = w[2];
+		}
+		n = 2;
+	} else if (nvm->private_write) {
+		nvm->private_busy = 1;
+	}
+
+	nvm->private_mem += n;
+	nvm->private_buf += n;
+	nvm->private_len = (nvm->private_len > n) ? nvm->private_len - n : 0;
+	if (!nvm->private_len) return 0;
+	nvm->private_phase = nvm->private_busy ? LIBTI2CIT_NVM_POLL : LIBTI2CIT_NVM_OP;
+	nvm->private_t0 = libti2cit_cyccnt_start(nvm->timeout);
+	return LIBTI2CIT_NVM_MORE;
+}
+
+static uint8_t libti2cit_nvm_sync_run(libti2cit_nvm_st * nvm, uint32_t r)
+{
+	uint32_t base = nvm->st.base;
+	while (r == LIBTI2CIT_NVM_MORE) {
+		uint32_t n = libti2cit_nvm_plan(nvm), i;
+		r = 0;
+		for (i = 0; i < n && !r; i++) {
+			libti2cit_xfer_st * x = &nvm->private_xfer[i];
+			r = libti2cit_m_sync_send(base, (x->addr & ~1) | (x->rlen ? 1 : 0), x->wlen, x->wbuf);
+			if (!r && x->rlen) r = libti2cit_m_sync_recv(base, x->rlen, x->rbuf);
+		}
+		r = libti2cit_nvm_result(nvm, r);
+	}
+	return r;
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_nvm_sync_read(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, uint8_t * buf)
+{
+	return libti2cit_nvm_sync_run(nvm, libti2cit_nvm_begin(nvm, 0, mem, len, buf));
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_nvm_sync_write(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, const uint8_t * buf)
+{
+	return libti2cit_nvm_sync_run(nvm, libti2cit_nvm_begin(nvm, 1, mem, len, (uint8_t *) buf));
+}
+
+/* see description in libti2cit.h
+ */
+uint8_t libti2cit_nvm_sync_wait(libti2cit_nvm_st * nvm)
+{
+	nvm->private_busy = 1;
+	return libti2cit_nvm_sync_run(nvm, libti2cit_nvm_begin(nvm, 0, nvm->private_mem, 0, 0));
+}
+
+static void libti2cit_nvm_isr_step(libti2cit_int_st * st, uint32_t status);
+
+/* start the next step from the interrupt (or from libti2cit_nvm_isr_...()), or call done
+ */
+static void libti2cit_nvm_isr_run(libti2cit_nvm_st * nvm, uint32_t r)
+{
+	if (r != LIBTI2CIT_NVM_MORE) {
+		if (nvm->done) nvm->done(nvm, r);
+		return;
+	}
+	nvm->st.user_cb = libti2cit_nvm_isr_step;
+	nvm->st.xfer = nvm->private_xfer;
+	nvm->st.nxfer = libti2cit_nvm_plan(nvm);
+	libti2cit_m_isr_queue(&nvm->st);
+}
+
+/* user_cb of nvm->st: a libti2cit_m_isr_queue() step is done
+ */
+static void libti2cit_nvm_isr_step(libti2cit_int_st * st, uint32_t status)
+{
+	libti2cit_nvm_st * nvm = (libti2cit_nvm_st *) st;
+	uint32_t r = 0;
+	if (status & I2C_MIMR_ARBLOSTIM) r = 2;
+	else if (status & I2C_MIMR_CLKIM) r = LIBTI2CIT_TIMEOUT;
+	else if (status & I2C_MIMR_NACKIM) r = 1;
+	libti2cit_nvm_isr_run(nvm, libti2cit_nvm_result(nvm, r));
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_nvm_isr_read(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, uint8_t * buf)
+{
+	libti2cit_nvm_isr_run(nvm, libti2cit_nvm_begin(nvm, 0, mem, len, buf));
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_nvm_isr_write(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, const uint8_t * buf)
+{
+	libti2cit_nvm_isr_run(nvm, libti2cit_nvm_begin(nvm, 1, mem, len, (uint8_t *) buf));
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_nvm_isr_wait(libti2cit_nvm_st * nvm)
+{
+	nvm->private_busy = 1;
+	libti2cit_nvm_isr_run(nvm, libti2cit_nvm_begin(nvm, 0, nvm->private_mem, 0, 0));
+}
+
+
+
+
+/* libti2cit_sched_dev_st private_phase: what private_due is for, and LIBTI2CIT_SCHED_QUEUED while it is in the batch
+ */
+#define LIBTI2CIT_SCHED_MEASURE (0)
+#define LIBTI2CIT_SCHED_FETCH   (1)
+#define LIBTI2CIT_SCHED_QUEUED  (2)
+
+static void libti2cit_sched_step(libti2cit_int_st * st, uint32_t status);
+
+/* start every transaction that is due, as one batch: the bus is idle
+ */
+static void libti2cit_sched_run(libti2cit_sched_st * sched)
+{
+	uint32_t i, n = 0, first = sched->private_next;
+	for (i = 0; i < sched->ndev && n < LIBTI2CIT_SCHED_BATCH; i++) {
+		uint32_t k = (first + i) % sched->ndev;
+		libti2cit_sched_dev_st * d = &sched->dev[k];
+		if ((int32_t) (sched->now - d->private_due) < 0) continue;
+		if (sched->now != d->private_due) sched->nlate++;
+		if (d->private_phase == LIBTI2CIT_SCHED_MEASURE) {
+			d->private_t = d->private_due;
+			sched->private_q[n] = d->measure;
+		} else {
+			sched->private_q[n] = d->fetch;
+		}
+		d->private_phase |= LIBTI2CIT_SCHED_QUEUED;
+		sched->private_qdev[n++] = d;
+		sched->private_next = k + 1;
+	}
+	if (!n) return;
+
+	sched->running = 1;
+	sched->st.user_cb = libti2cit_sched_step;
+	sched->st.xfer = sched->private_q;
+	sched->st.nxfer = n;
+	libti2cit_m_isr_queue(&sched->st);
+}
+
+/* d is done with this period: the next measure is one period after the last one was due
+ *   if the bus was so busy that it is already due, it starts now instead of catching up with a burst
+ */
+static void libti2cit_sched_next(libti2cit_sched_st * sched, libti2cit_sched_dev_st * d)
+{
+	d->private_phase = LIBTI2CIT_SCHED_MEASURE;
+	d->private_due = d->private_t + d->period;
+	if ((int32_t) (sched->now - d->private_due) > 0) d->private_due = sched->now;
+}
+
+/* user_cb of sched->st: the batch is done (or stopped at st->ixfer by I2C_MIMR_ARBLOSTIM or I2C_MIMR_CLKIM)
+ */
+static void libti2cit_sched_step(libti2cit_int_st * st, uint32_t status)
+{
+	libti2cit_sched_st * sched = (libti2cit_sched_st *) st;
+	uint32_t fail = status & (I2C_MIMR_ARBLOSTIM | I2C_MIMR_CLKIM);
+	uint32_t i, n = fail ? st->ixfer : st->nxfer;
+	for (i = 0; i < st->nxfer; i++) {
+		libti2cit_sched_dev_st * d = sched->private_qdev[i];
+		libti2cit_xfer_st * x = &sched->private_q[i];
+		d->private_phase &= ~LIBTI2CIT_SCHED_QUEUED;
+		if (i >= n) {
+			// not finished: it is still due, the next tick starts it again
+			if (i == n) d->nerr++;
+			d->private_due = sched->now;
+			continue;
+		}
+
+		if (d->private_phase == LIBTI2CIT_SCHED_MEASURE) {
+			d->measure.status = x->status;
+			if (!x->status) {
+				d->private_phase = LIBTI2CIT_SCHED_FETCH;
+				d->private_due = sched->now + d->conv + 1;	// the measure ended somewhere inside tick now
+				continue;
+			}
+			d->nerr++;
+			if (d->done) d->done(sched, d);
+			libti2cit_sched_next(sched, d);
+			continue;
+		}
+
+		d->fetch.status = x->status;
+		if (x->status) d->nerr++;
+		else d->nread++;
+		uint32_t again = d->done ? d->done(sched, d) : 0;
+		if (again) {
+			d->private_due = sched->now + again;
+			continue;
+		}
+		libti2cit_sched_next(sched, d);
+	}
+
+	sched->running = 0;
+	if (!fail) libti2cit_sched_run(sched);	// anything that came due while the batch ran
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_sched_start(libti2cit_sched_st * sched)
+{
+	uint32_t i;
+	for (i = 0; i < sched->ndev; i++) {
+		libti2cit_sched_dev_st * d = &sched->dev[i];
+		d->private_phase = LIBTI2CIT_SCHED_MEASURE;
+		d->private_due = sched->now + 1 + (uint32_t) ((uint64_t) d->period * i / sched->ndev);
+	}
+	sched->running = 0;
+	sched->private_next = 0;
+	sched->st.user_cb = libti2cit_sched_step;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_sched_tick(libti2cit_sched_st * sched)
+{
+	sched->now++;
+	if (!sched->running) libti2cit_sched_run(sched);
+}
+
+
+
+
+/* user_cb of pt->st: the LIBTI2CIT_PT_XFER() is done, carry on with fn
+ */
+static void libti2cit_pt_step(libti2cit_int_st * st, uint32_t status)
+{
+	libti2cit_pt_st * pt = (libti2cit_pt_st *) st;
+	pt->status = pt->private_x.status;
+	pt->fn(pt);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_pt_start(libti2cit_pt_st * pt, libti2cit_pt_fn fn)
+{
+	pt->fn = fn;
+	pt->status = 0;
+	pt->running = 1;
+	pt->private_lc = 0;
+	pt->private_sleep = 0;
+	fn(pt);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_pt_xfer(libti2cit_pt_st * pt, uint8_t addr, const uint8_t * wbuf, uint32_t wlen, uint8_t * rbuf,
+	uint32_t rlen)
+{
+	libti2cit_xfer_st * x = &pt->private_x;
+	x->addr = addr;
+	x->wbuf = wbuf;
+	x->wlen = wlen;
+	x->rbuf = rbuf;
+	x->rlen = rlen;
+	pt->st.user_cb = libti2cit_pt_step;
+	pt->st.xfer = x;
+	pt->st.nxfer = 1;
+	libti2cit_m_isr_queue(&pt->st);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_pt_tick(libti2cit_pt_st * pt)
+{
+	if (!pt->private_sleep || --pt->private_sleep) return;
+	pt->fn(pt);
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_pt_resume(libti2cit_pt_st * pt)
+{
+	pt->fn(pt);
+}
+
+
+
+
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_s_int_clear(libti2cit_int_st * st)
+{
+	uint32_t status = HWREG(st->base + I2C_O_SMIS);
+	if (!status) return 0;
+	HWREG(st->base + I2C_O_SICR) = status;
+	return status;
+}
+
+/* a write to bank r is over (i2c STOP, or a repeated start to either address): stop NACKing and tell wr_cb
+ */
+static void libti2cit_s_regs_end(libti2cit_int_st * st, libti2cit_s_regs_st * r)
+{
+	if (!r) return;
+	if (r->private_nack > 1) {
+		HWREG(st->base + I2C_O_SACKCTL) = 0;	// the write ended in a NACK: ACK the next one
+		r->private_nack = 1;
+	}
+	if (r->private_n) {
+		uint32_t n = r->private_n;
+		r->private_n = 0;
+		if (r->wr_cb) r->wr_cb(st, r->private_first, n);
+	}
+}
+
+/* serve one data interrupt from bank r: no printing, no loops, a handful of register accesses per byte
+ */
+static void libti2cit_s_regs_data(libti2cit_int_st * st, libti2cit_s_regs_st * r, uint32_t scsr)
+{
+	if (scsr & I2C_SCSR_RREQ) {
+		if (scsr & I2C_SCSR_FBR) {
+			// first byte after the address: the register pointer
+			libti2cit_s_regs_end(st, st->regs);
+			libti2cit_s_regs_end(st, st->regs2);
+			r->private_ptr = HWREG(st->base + I2C_O_SDR) & 0xff;
+			r->private_nack = (r->private_ptr >= r->nregs);
+			return;
+		}
+
+		if (r->private_nack) {
+			// the pointer is past the end of the bank
+			HWREG(st->base + I2C_O_SACKCTL) = I2C_SACKCTL_ACKOEN | I2C_SACKCTL_ACKOVAL;	// NACK this byte
+			r->private_nack = 2;
+			(void) HWREG(st->base + I2C_O_SDR);
+			return;
+		}
+		uint32_t p = r->private_ptr;
+		uint8_t data = HWREG(st->base + I2C_O_SDR);
+		uint8_t m = r->wmask ? r->wmask[p] : 0xff;
+		r->regs[p] = (r->regs[p] & ~m) | (data & m);
+		if (!r->private_n) r->private_first = p;
+		r->private_n++;
+		r->nwrite++;
+		r->private_ptr = (p + 1 < r->nregs) ? p + 1 : 0;
+		return;
+	}
+
+	if (scsr & I2C_SCSR_TREQ) {
+		uint32_t p = r->private_ptr;
+		if (r->private_nack) {
+			HWREG(st->base + I2C_O_SDR) = 0xff;
+			return;
+		}
+		HWREG(st->base + I2C_O_SDR) = r->regs[p];
+		r->nread++;
+		r->private_ptr = (p + 1 < r->nregs) ? p + 1 : 0;
+	}
+}
+
+/* slave FIFO and uDMA transfers: st->private_state of a slave libti2cit_int_st (it is never used for the master)
+ * I2C_SCSR_TXFIFO and I2C_SCSR_RXFIFO make the slave move bytes through the FIFO instead of I2C_O_SDR
+ * the trigger levels and uDMA settings are the same as for the master
+ */
+enum {
+	LIBTI2CIT_S_IDLE = 0,
+	LIBTI2CIT_S_FIFO_SEND,
+	LIBTI2CIT_S_FIFO_RECV,
+	LIBTI2CIT_S_DMA_SEND,
+	LIBTI2CIT_S_DMA_RECV,
+};
+
+/* give the TX FIFO to the slave, flush it and clear any stale TX FIFO request
+ *   fifoctl is the trigger level, and I2C_FIFOCTL_DMATXENA for the uDMA
+ */
+static void libti2cit_s_fifo_tx_init(uint32_t base, uint32_t fifoctl)
+{
+	HWREG(base + I2C_O_FIFOCTL) = (HWREG(base + I2C_O_FIFOCTL) & ~(I2C_FIFOCTL_DMATXENA | I2C_FIFOCTL_TXTRIG_M)) |
+		I2C_FIFOCTL_TXASGNMT | I2C_FIFOCTL_TXFLUSH | fifoctl;
+	HWREG(base + I2C_O_SICR) = I2C_SICR_TXIC | I2C_SICR_TXFEIC | I2C_SICR_DMATXIC;
+}
+
+/* give the RX FIFO to the slave, flush it and clear any stale RX FIFO request
+ *   fifoctl is the trigger level, and I2C_FIFOCTL_DMARXENA for the uDMA
+ */
+static void libti2cit_s_fifo_rx_init(uint32_t base, uint32_t fifoctl)
+{
+	HWREG(base + I2C_O_FIFOCTL) = (HWREG(base + I2C_O_FIFOCTL) & ~(I2C_FIFOCTL_DMARXENA | I2C_FIFOCTL_RXTRIG_M)) |
+		I2C_FIFOCTL_RXASGNMT | I2C_FIFOCTL_RXFLUSH | fifoctl;
+	HWREG(base + I2C_O_SICR) = I2C_SICR_RXIC | I2C_SICR_RXFFIC | I2C_SICR_DMARXIC;
+}
+
+/* buf is full: the rest of the bytes come through I2C_O_SDR and are NACKed
+ */
+static void libti2cit_s_recv_full(libti2cit_int_st * st)
+{
+	HWREG(st->base + I2C_O_SIMR) &= ~(I2C_SIMR_RXIM | I2C_SIMR_DMARXIM);
+	HWREG(st->base + I2C_O_SACKCTL) = I2C_SACKCTL_ACKOEN | I2C_SACKCTL_ACKOVAL;
+	HWREG(st->base + I2C_O_SCSR) = I2C_SCSR_DA;
+}
+
+/* the RX FIFO trigger level for the room left in buf: the interrupt for the last bytes comes as soon as buf is full,
+ * so the byte after them can still be NACKed
+ */
+static uint32_t libti2cit_s_rxtrig(libti2cit_int_st * st)
+{
+	uint32_t room = st->len - st->nread;
+	return (room < LIBTI2CIT_FIFO_RXTRIG) ? room : LIBTI2CIT_FIFO_RXTRIG;
+}
+
+/* pop n bytes from the RX FIFO without checking I2C_O_FIFOSTATUS: the caller knows they are there
+ * bytes that do not fit in buf are thrown away
+ */
+static void libti2cit_s_fifo_drain(libti2cit_int_st * st, uint32_t n)
+{
+	while (n--) {
+		uint8_t data = HWREG(st->base + I2C_O_FIFODATA);
+		if (st->nread < st->len) st->buf[st->nread++] = data;
+	}
+	if (st->nread >= st->len) {
+		libti2cit_s_recv_full(st);
+	} else if (st->private_state == LIBTI2CIT_S_FIFO_RECV && st->len - st->nread < LIBTI2CIT_FIFO_RXTRIG) {
+		HWREG(st->base + I2C_O_FIFOCTL) = (HWREG(st->base + I2C_O_FIFOCTL) & ~I2C_FIFOCTL_RXTRIG_M) |
+			(libti2cit_s_rxtrig(st) << I2C_FIFOCTL_RXTRIG_S);
+	}
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_s_isr_send(libti2cit_int_st * st)
+{
+	st->nisr = 0;
+	st->nread = 0;	// counts bytes pushed into the TX FIFO
+	st->private_state = LIBTI2CIT_S_FIFO_SEND;
+	LIBTI2CIT_TRACE(S_START, st, st->private_state, st->len);
+
+	libti2cit_s_fifo_tx_init(st->base, LIBTI2CIT_FIFO_TXTRIG << I2C_FIFOCTL_TXTRIG_S);
+	libti2cit_isr_fifo_fill(st, LIBTI2CIT_FIFO_LEN);
+	if (st->nread < st->len) HWREG(st->base + I2C_O_SIMR) |= I2C_SIMR_TXIM;
+	HWREG(st->base + I2C_O_SCSR) = I2C_SCSR_DA | I2C_SCSR_TXFIFO;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_s_isr_recv(libti2cit_int_st * st)
+{
+	st->nisr = 0;
+	st->nread = 0;
+	st->private_state = LIBTI2CIT_S_FIFO_RECV;
+	LIBTI2CIT_TRACE(S_START, st, st->private_state, st->len);
+	if (!st->len) {
+		libti2cit_s_recv_full(st);
+		return;
+	}
+
+	libti2cit_s_fifo_rx_init(st->base, libti2cit_s_rxtrig(st) << I2C_FIFOCTL_RXTRIG_S);
+	HWREG(st->base + I2C_O_SIMR) |= I2C_SIMR_RXIM;
+	HWREG(st->base + I2C_O_SCSR) = I2C_SCSR_DA | I2C_SCSR_RXFIFO;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_s_isrdma_send(libti2cit_int_st * st)
+{
+	if (!st->len) {
+		// nothing for the uDMA to do: every byte the master reads is 0xff
+		libti2cit_s_isr_send(st);
+		return;
+	}
+
+	st->nisr = 0;
+	st->nread = 0;	// set to len when the uDMA is done
+	st->private_state = LIBTI2CIT_S_DMA_SEND;
+	LIBTI2CIT_TRACE(S_START, st, st->private_state, st->len);
+
+	ROM_uDMAChannelControlSet(st->dma_tx | UDMA_PRI_SELECT, LIBTI2CIT_DMA_CTL_TX);
+	libti2cit_s_fifo_tx_init(st->base, I2C_FIFOCTL_DMATXENA | (LIBTI2CIT_DMA_TXTRIG << I2C_FIFOCTL_TXTRIG_S));
+	ROM_uDMAChannelTransferSet(st->dma_tx | UDMA_PRI_SELECT, UDMA_MODE_BASIC, st->buf,
+		(void *) (st->base + I2C_O_FIFODATA), st->len);
+	ROM_uDMAChannelEnable(st->dma_tx);
+	HWREG(st->base + I2C_O_SIMR) |= I2C_SIMR_DMATXIM;
+	HWREG(st->base + I2C_O_SCSR) = I2C_SCSR_DA | I2C_SCSR_TXFIFO;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_s_isrdma_recv(libti2cit_int_st * st)
+{
+	if (!st->len) {
+		// nothing for the uDMA to do: every byte is NACKed
+		libti2cit_s_isr_recv(st);
+		return;
+	}
+
+	st->nisr = 0;
+	st->nread = 0;	// worked out from the uDMA at the STOP, or set to len when the uDMA is done
+	st->private_state = LIBTI2CIT_S_DMA_RECV;
+	LIBTI2CIT_TRACE(S_START, st, st->private_state, st->len);
+
+	ROM_uDMAChannelControlSet(st->dma_rx | UDMA_PRI_SELECT, LIBTI2CIT_DMA_CTL_RX);
+	libti2cit_s_fifo_rx_init(st->base, I2C_FIFOCTL_DMARXENA | (1 << I2C_FIFOCTL_RXTRIG_S));
+	ROM_uDMAChannelTransferSet(st->dma_rx | UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+		(void *) (st->base + I2C_O_FIFODATA), st->buf, st->len);
+	ROM_uDMAChannelEnable(st->dma_rx);
+	HWREG(st->base + I2C_O_SIMR) |= I2C_SIMR_DMARXIM;
+	HWREG(st->base + I2C_O_SCSR) = I2C_SCSR_DA | I2C_SCSR_RXFIFO;
+}
+
+/* FIFO and uDMA interrupts of libti2cit_s_isr_send(), _recv() and libti2cit_s_isrdma_...()
+ */
+static void libti2cit_s_isr_fifo(libti2cit_int_st * st, uint32_t status)
+{
+	if (status & I2C_SIMR_TXIM) {
+		libti2cit_isr_fifo_fill(st, LIBTI2CIT_FIFO_LEN - LIBTI2CIT_FIFO_TXTRIG);
+		if (st->nread >= st->len) HWREG(st->base + I2C_O_SIMR) &= ~I2C_SIMR_TXIM;
+	}
+	if (status & I2C_SIMR_RXIM) libti2cit_s_fifo_drain(st, libti2cit_s_rxtrig(st));	// the trigger level, see libti2cit_s_fifo_drain()
+	if (status & I2C_SIMR_DMATXIM) {
+		st->nread = st->len;	// the rest of buf is in the TX FIFO
+		HWREG(st->base + I2C_O_SIMR) &= ~I2C_SIMR_DMATXIM;
+	}
+	if (status & I2C_SIMR_DMARXIM) {
+		st->nread = st->len;
+		libti2cit_s_recv_full(st);
+	}
+}
+
+/* I2C_SCSR_TREQ or I2C_SCSR_RREQ while a FIFO or uDMA transfer is armed: the FIFO ran dry (send) or buf is full (recv)
+ * returns the I2C_O_SCSR bits that were taken care of
+ */
+static uint32_t libti2cit_s_isr_data(libti2cit_int_st * st, uint32_t scsr)
+{
+	uint32_t send = (st->private_state == LIBTI2CIT_S_FIFO_SEND || st->private_state == LIBTI2CIT_S_DMA_SEND);
+	if (send && (scsr & I2C_SCSR_TREQ)) {
+		if (st->nread >= st->len) HWREG(st->base + I2C_O_SDR) = 0xff;	// the master read past the end of buf
+		else if (st->private_state == LIBTI2CIT_S_FIFO_SEND) libti2cit_isr_fifo_fill(st, LIBTI2CIT_FIFO_LEN);
+		return I2C_SCSR_TREQ;
+	}
+	if (!send && (scsr & I2C_SCSR_RREQ)) {
+		(void) HWREG(st->base + I2C_O_SDR);	// NACKed, see libti2cit_s_recv_full()
+		return I2C_SCSR_RREQ | I2C_SCSR_FBR;
+	}
+	return 0;
+}
+
+/* the i2c STOP ends a FIFO or uDMA transfer: count what was moved, give I2C_O_SDR back and call user_cb
+ */
+static void libti2cit_s_isr_stop(libti2cit_int_st * st)
+{
+	uint32_t base = st->base;
+	switch (st->private_state) {
+	case LIBTI2CIT_S_DMA_SEND:
+		if (st->nread < st->len) {
+			ROM_uDMAChannelDisable(st->dma_tx);
+			st->nread = st->len - ROM_uDMAChannelSizeGet(st->dma_tx | UDMA_PRI_SELECT);
+		}
+		break;
+
+	case LIBTI2CIT_S_DMA_RECV:
+		if (st->nread < st->len) {
+			ROM_uDMAChannelDisable(st->dma_rx);
+			st->nread = st->len - ROM_uDMAChannelSizeGet(st->dma_rx | UDMA_PRI_SELECT);
+		}
+		// fall through: the last bytes may still be in the RX FIFO
+	case LIBTI2CIT_S_FIFO_RECV:
+		while (st->nread < st->len && !(HWREG(base + I2C_O_FIFOSTATUS) & I2C_FIFOSTATUS_RXFE)) {
+			libti2cit_s_fifo_drain(st, 1);
+		}
+		break;
+	}
+
+	HWREG(base + I2C_O_SIMR) &= ~(I2C_SIMR_TXIM | I2C_SIMR_RXIM | I2C_SIMR_DMATXIM | I2C_SIMR_DMARXIM);
+	HWREG(base + I2C_O_SCSR) = I2C_SCSR_DA;
+	HWREG(base + I2C_O_SACKCTL) = 0;
+	HWREG(base + I2C_O_FIFOCTL) = (HWREG(base + I2C_O_FIFOCTL) & ~(I2C_FIFOCTL_DMATXENA | I2C_FIFOCTL_DMARXENA)) |
+		I2C_FIFOCTL_TXFLUSH | I2C_FIFOCTL_RXFLUSH;
+	st->private_state = LIBTI2CIT_S_IDLE;
+	if (st->user_cb) st->user_cb(st, I2C_SIMR_STOPIM);
+}
+
+/* see description in libti2cit.h
+ */
+uint32_t libti2cit_s_isr_isr(libti2cit_int_st * st)
+{
+	uint32_t status = libti2cit_s_int_clear(st);
+	if (!status) return 0;
+
+	uint32_t state = st->private_state;
+	uint32_t armed = (state != LIBTI2CIT_S_IDLE);
+	if (armed) {
+		st->nisr++;
+		libti2cit_s_isr_fifo(st, status);
+	}
+
+	uint32_t r = 0;
+	if (status & I2C_SIMR_STARTIM) r |= LIBTI2CIT_ISR_S_START;
+	if (status & I2C_SIMR_DATAIM) {
+		r |= HWREG(st->base + I2C_O_SCSR);
+		if (armed) r &= ~libti2cit_s_isr_data(st, r);
+		libti2cit_s_regs_st * regs = (st->regs2 && (r & I2C_SCSR_OAR2SEL)) ? st->regs2 : st->regs;
+		if (regs) libti2cit_s_regs_data(st, regs, r);
+	}
+	if (status & I2C_SIMR_STOPIM) {
+		r |= LIBTI2CIT_ISR_S_STOP;
+		libti2cit_s_regs_end(st, st->regs);
+		libti2cit_s_regs_end(st, st->regs2);
+		if (armed) libti2cit_s_isr_stop(st);
+	}
+	LIBTI2CIT_TRACE(S_ISR, st, state, (status << 16) | (r & 0xffff));
+	return r;
+}
+
+
+
+
+
+#ifdef LIBTI2CIT_NO_TRACE
+
+/* see description in libti2cit.h
+ */
+const libti2cit_trace_st * libti2cit_trace_get(void)
+{
+	return 0;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_trace_clear(void)
+{
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_trace_stop(void)
+{
+}
+
+#else
+
+/* see description in libti2cit.h
+ */
+const libti2cit_trace_st * libti2cit_trace_get(void)
+{
+	return &libti2cit_trace;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_trace_clear(void)
+{
+	libti2cit_trace.stop = 1;
+	uint8_t * p = (uint8_t *) libti2cit_trace.ev;
+	uint32_t len = sizeof(libti2cit_trace.ev);
+	while (len--) *(p++) = 0;
+	libti2cit_trace.head = 0;
+	libti2cit_cyccnt_start(1);
+	libti2cit_trace.stop = 0;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_trace_stop(void)
+{
+	libti2cit_trace.stop = 1;
+}
+
+#endif
+
+
+
+
+/* names for libti2cit_prof_name(), in LIBTI2CIT_PROF_... order */
+static const char * const libti2cit_prof_names[] = {
+	"m_sync_send",
+	"m_sync_recv",
+	"m_sync_recvpart",
+	"m_sync_send_to",
+	"m_sync_recv_to",
+	"m_sync_recvpart_to",
+	"m_int_clear",
+	"m_isr_isr",
+	"m_isr_nofifo_send",
+	"m_isr_nofifo_recv",
+	"m_isr_nofifo_recvpart",
+	"m_isr_send",
+	"m_isr_recv",
+	"m_isr_recvpart",
+	"m_isrdma_send",
+	"m_isrdma_recv",
+	"m_isrdma_recvpart",
+	"m_isr_queue",
+	"m_scan",
+	"mgr_submit",
+	"mgr_isr",
+	"m_recover",
+	"s_int_clear",
+	"s_isr_isr",
+	"s_isr_send",
+	"s_isr_recv",
+	"s_isrdma_send",
+	"s_isrdma_recv",
+	"m_sync_hs",
+	"m_sync_hs_to",
+	"m_sync_send_pec",
+	"m_sync_recv_pec",
+	"m_sync_recvpart_pec",
+	"nvm_sync_read",
+	"nvm_sync_write",
+	"nvm_sync_wait",
+	"nvm_isr_read",
+	"nvm_isr_write",
+	"nvm_isr_wait",
+	"sched_tick",
+	"pt_xfer",
+	"pt_tick",
+	"pt_resume",
+	"m_syncfifo_send",
+	"m_syncfifo_recv",
+	"m_syncwfi_send",
+	"m_syncwfi_recv",
+	"m_syncwfi_recvpart",
+	"m_speed",
+	"m_speed_table",
+	"mgr_init",
+	"mgr_util",
+	"mgr_util_clear",
+	"sched_start",
+	"pt_start",
+	"m_syncwfi_meter",
+	"m_syncwfi_slept",
+	"m_isr_state IDLE",
+	"m_isr_state WAIT_STOP",
+	"m_isr_state WAIT_RIS",
+	"m_isr_state NOFIFO_SEND",
+	"m_isr_state NOFIFO_RECV",
+	"m_isr_state NOFIFO_RECVPART",
+	"m_isr_state FIFO_SEND",
+	"m_isr_state FIFO_RECV",
+	"m_isr_state FIFO_RECVPART",
+	"m_isr_state DMA_SEND",
+	"m_isr_state DMA_RECV",
+	"m_isr_state DMA_RECVPART",
+	"m_isr_state HS_CODE",
+};
+
+/* see description in libti2cit.h
+ */
+typedef char libti2cit_prof_names_check[(sizeof(libti2cit_prof_names) / sizeof(libti2cit_prof_names[0]) ==
+	LIBTI2CIT_PROF_N) ? 1 : -1];
+
+const char * libti2cit_prof_name(uint32_t id)
+{
+	return (id < LIBTI2CIT_PROF_N) ? libti2cit_prof_names[id] : 0;
+}
+
+#ifndef LIBTI2CIT_PROF
+
+/* see description in libti2cit.h
+ */
+const libti2cit_prof_st * libti2cit_prof_get(uint32_t id)
+{
+	return 0;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_prof_clear(void)
+{
+}
+
+#else
+
+/* see description in libti2cit.h
+ */
+const libti2cit_prof_st * libti2cit_prof_get(uint32_t id)
+{
+	return (id < LIBTI2CIT_PROF_N) ? &libti2cit_prof[id] : 0;
+}
+
+/* see description in libti2cit.h
+ */
+void libti2cit_prof_clear(void)
+{
+	uint8_t * p = (uint8_t *) libti2cit_prof;
+	uint32_t len = sizeof(libti2cit_prof);
+	while (len--) *(p++) = 0;
+	libti2cit_cyccnt_start(1);
+}
+
+#undef libti2cit_m_sync_send
+#undef libti2cit_m_sync_recv
+#undef libti2cit_m_sync_recvpart
+#undef libti2cit_m_sync_send_to
+#undef libti2cit_m_sync_recv_to
+#undef libti2cit_m_sync_recvpart_to
+#undef libti2cit_m_int_clear
+#undef libti2cit_m_isr_isr
+#undef libti2cit_m_isr_nofifo_send
+#undef libti2cit_m_isr_nofifo_recv
+#undef libti2cit_m_isr_nofifo_recvpart
+#undef libti2cit_m_isr_send
+#undef libti2cit_m_isr_recv
+#undef libti2cit_m_isr_recvpart
+#undef libti2cit_m_isrdma_send
+#undef libti2cit_m_isrdma_recv
+#undef libti2cit_m_isrdma_recvpart
+#undef libti2cit_m_isr_queue
+#undef libti2cit_m_scan
+#undef libti2cit_mgr_submit
+#undef libti2cit_mgr_isr
+#undef libti2cit_m_recover
+#undef libti2cit_s_int_clear
+#undef libti2cit_s_isr_isr
+#undef libti2cit_s_isr_send
+#undef libti2cit_s_isr_recv
+#undef libti2cit_s_isrdma_send
+#undef libti2cit_s_isrdma_recv
+#undef libti2cit_m_sync_hs
+#undef libti2cit_m_sync_hs_to
+#undef libti2cit_m_sync_send_pec
+#undef libti2cit_m_sync_recv_pec
+#undef libti2cit_m_sync_recvpart_pec
+#undef libti2cit_nvm_sync_read
+#undef libti2cit_nvm_sync_write
+#undef libti2cit_nvm_sync_wait
+#undef libti2cit_nvm_isr_read
+#undef libti2cit_nvm_isr_write
+#undef libti2cit_nvm_isr_wait
+#undef libti2cit_sched_tick
+#undef libti2cit_pt_xfer
+#undef libti2cit_pt_tick
+#undef libti2cit_pt_resume
+#undef libti2cit_m_syncfifo_send
+#undef libti2cit_m_syncfifo_recv
+#undef libti2cit_m_syncwfi_send
+#undef libti2cit_m_syncwfi_recv
+#undef libti2cit_m_syncwfi_recvpart
+#undef libti2cit_m_speed
+#undef libti2cit_m_speed_table
+#undef libti2cit_mgr_init
+#undef libti2cit_mgr_util
+#undef libti2cit_mgr_util_clear
+#undef libti2cit_sched_start
+#undef libti2cit_pt_start
+#undef libti2cit_m_syncwfi_meter
+#undef libti2cit_m_syncwfi_slept
+
+/* the wrappers: each one calls the libti2cit_..._unprof() function compiled above */
+#define LIBTI2CIT_PROF_WRAP(ret, fn, id, args, call) \
+	ret fn args { uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT); ret ret_ = fn##_unprof call; libti2cit_prof_add(id, t0); return ret_; }
+#define LIBTI2CIT_PROF_WRAP_ST(fn, id) \
+	void fn(libti2cit_int_st * st) { uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT); fn##_unprof(st); libti2cit_prof_add(id, t0); }
+
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_send, LIBTI2CIT_PROF_M_SYNC_SEND,
+	(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf), (base, addr, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_recv, LIBTI2CIT_PROF_M_SYNC_RECV,
+	(uint32_t base, uint32_t len, uint8_t * buf), (base, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_recvpart, LIBTI2CIT_PROF_M_SYNC_RECVPART,
+	(uint32_t base, uint32_t len, uint8_t * buf), (base, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_send_to, LIBTI2CIT_PROF_M_SYNC_SEND_TO,
+	(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf, uint32_t timeout), (base, addr, len, buf, timeout))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_recv_to, LIBTI2CIT_PROF_M_SYNC_RECV_TO,
+	(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout), (base, len, buf, timeout))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_recvpart_to, LIBTI2CIT_PROF_M_SYNC_RECVPART_TO,
+	(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout), (base, len, buf, timeout))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_m_int_clear, LIBTI2CIT_PROF_M_INT_CLEAR, (libti2cit_int_st * st), (st))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_m_isr_isr, LIBTI2CIT_PROF_M_ISR_ISR, (libti2cit_int_st * st), (st))
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_nofifo_send, LIBTI2CIT_PROF_M_ISR_NOFIFO_SEND)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_nofifo_recv, LIBTI2CIT_PROF_M_ISR_NOFIFO_RECV)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_nofifo_recvpart, LIBTI2CIT_PROF_M_ISR_NOFIFO_RECVPART)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_send, LIBTI2CIT_PROF_M_ISR_SEND)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_recv, LIBTI2CIT_PROF_M_ISR_RECV)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_recvpart, LIBTI2CIT_PROF_M_ISR_RECVPART)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isrdma_send, LIBTI2CIT_PROF_M_ISRDMA_SEND)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isrdma_recv, LIBTI2CIT_PROF_M_ISRDMA_RECV)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isrdma_recvpart, LIBTI2CIT_PROF_M_ISRDMA_RECVPART)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_isr_queue, LIBTI2CIT_PROF_M_ISR_QUEUE)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_m_scan, LIBTI2CIT_PROF_M_SCAN)
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_mgr_submit, LIBTI2CIT_PROF_MGR_SUBMIT,
+	(libti2cit_mgr_st * mgr, uint32_t id, libti2cit_xfer_st * x), (mgr, id, x))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_mgr_isr, LIBTI2CIT_PROF_MGR_ISR, (libti2cit_mgr_st * mgr, uint32_t id), (mgr, id))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_m_recover, LIBTI2CIT_PROF_M_RECOVER,
+	(uint32_t base, libti2cit_recover_st * r), (base, r))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_s_int_clear, LIBTI2CIT_PROF_S_INT_CLEAR, (libti2cit_int_st * st), (st))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_s_isr_isr, LIBTI2CIT_PROF_S_ISR_ISR, (libti2cit_int_st * st), (st))
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_s_isr_send, LIBTI2CIT_PROF_S_ISR_SEND)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_s_isr_recv, LIBTI2CIT_PROF_S_ISR_RECV)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_s_isrdma_send, LIBTI2CIT_PROF_S_ISRDMA_SEND)
+LIBTI2CIT_PROF_WRAP_ST(libti2cit_s_isrdma_recv, LIBTI2CIT_PROF_S_ISRDMA_RECV)
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_hs, LIBTI2CIT_PROF_M_SYNC_HS, (uint32_t base, uint8_t code), (base, code))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_hs_to, LIBTI2CIT_PROF_M_SYNC_HS_TO,
+	(uint32_t base, uint8_t code, uint32_t timeout), (base, code, timeout))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_send_pec, LIBTI2CIT_PROF_M_SYNC_SEND_PEC,
+	(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf, uint32_t timeout, uint8_t * pec),
+	(base, addr, len, buf, timeout, pec))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_recv_pec, LIBTI2CIT_PROF_M_SYNC_RECV_PEC,
+	(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout, uint8_t * pec), (base, len, buf, timeout, pec))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_sync_recvpart_pec, LIBTI2CIT_PROF_M_SYNC_RECVPART_PEC,
+	(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout, uint8_t * pec), (base, len, buf, timeout, pec))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_nvm_sync_read, LIBTI2CIT_PROF_NVM_SYNC_READ,
+	(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, uint8_t * buf), (nvm, mem, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_nvm_sync_write, LIBTI2CIT_PROF_NVM_SYNC_WRITE,
+	(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, const uint8_t * buf), (nvm, mem, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_nvm_sync_wait, LIBTI2CIT_PROF_NVM_SYNC_WAIT, (libti2cit_nvm_st * nvm), (nvm))
+void libti2cit_nvm_isr_read(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, uint8_t * buf)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_nvm_isr_read_unprof(nvm, mem, len, buf);
+	libti2cit_prof_add(LIBTI2CIT_PROF_NVM_ISR_READ, t0);
+}
+void libti2cit_nvm_isr_write(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, const uint8_t * buf)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_nvm_isr_write_unprof(nvm, mem, len, buf);
+	libti2cit_prof_add(LIBTI2CIT_PROF_NVM_ISR_WRITE, t0);
+}
+void libti2cit_nvm_isr_wait(libti2cit_nvm_st * nvm)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_nvm_isr_wait_unprof(nvm);
+	libti2cit_prof_add(LIBTI2CIT_PROF_NVM_ISR_WAIT, t0);
+}
+void libti2cit_sched_tick(libti2cit_sched_st * sched)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_sched_tick_unprof(sched);
+	libti2cit_prof_add(LIBTI2CIT_PROF_SCHED_TICK, t0);
+}
+void libti2cit_pt_xfer(libti2cit_pt_st * pt, uint8_t addr, const uint8_t * wbuf, uint32_t wlen, uint8_t * rbuf,
+	uint32_t rlen)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_pt_xfer_unprof(pt, addr, wbuf, wlen, rbuf, rlen);
+	libti2cit_prof_add(LIBTI2CIT_PROF_PT_XFER, t0);
+}
+void libti2cit_pt_tick(libti2cit_pt_st * pt)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_pt_tick_unprof(pt);
+	libti2cit_prof_add(LIBTI2CIT_PROF_PT_TICK, t0);
+}
+void libti2cit_pt_resume(libti2cit_pt_st * pt)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_pt_resume_unprof(pt);
+	libti2cit_prof_add(LIBTI2CIT_PROF_PT_RESUME, t0);
+}
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_syncfifo_send, LIBTI2CIT_PROF_M_SYNCFIFO_SEND,
+	(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf), (base, addr, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_syncfifo_recv, LIBTI2CIT_PROF_M_SYNCFIFO_RECV,
+	(uint32_t base, uint32_t len, uint8_t * buf), (base, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_syncwfi_send, LIBTI2CIT_PROF_M_SYNCWFI_SEND,
+	(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf), (base, addr, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_syncwfi_recv, LIBTI2CIT_PROF_M_SYNCWFI_RECV,
+	(uint32_t base, uint32_t len, uint8_t * buf), (base, len, buf))
+LIBTI2CIT_PROF_WRAP(uint8_t, libti2cit_m_syncwfi_recvpart, LIBTI2CIT_PROF_M_SYNCWFI_RECVPART,
+	(uint32_t base, uint32_t len, uint8_t * buf), (base, len, buf))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_m_speed, LIBTI2CIT_PROF_M_SPEED,
+	(uint32_t base, uint32_t sysclock, uint32_t scl_hz), (base, sysclock, scl_hz))
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_m_speed_table, LIBTI2CIT_PROF_M_SPEED_TABLE,
+	(uint32_t base, libti2cit_speed_st * sp), (base, sp))
+void libti2cit_mgr_init(libti2cit_mgr_st * mgr, libti2cit_mgr_cb done)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_mgr_init_unprof(mgr, done);
+	libti2cit_prof_add(LIBTI2CIT_PROF_MGR_INIT, t0);
+}
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_mgr_util, LIBTI2CIT_PROF_MGR_UTIL,
+	(libti2cit_mgr_st * mgr, uint32_t id), (mgr, id))
+void libti2cit_mgr_util_clear(libti2cit_mgr_st * mgr)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_mgr_util_clear_unprof(mgr);
+	libti2cit_prof_add(LIBTI2CIT_PROF_MGR_UTIL_CLEAR, t0);
+}
+void libti2cit_sched_start(libti2cit_sched_st * sched)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_sched_start_unprof(sched);
+	libti2cit_prof_add(LIBTI2CIT_PROF_SCHED_START, t0);
+}
+void libti2cit_pt_start(libti2cit_pt_st * pt, libti2cit_pt_fn fn)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_pt_start_unprof(pt, fn);
+	libti2cit_prof_add(LIBTI2CIT_PROF_PT_START, t0);
+}
+void libti2cit_m_syncwfi_meter(uint32_t base, libti2cit_wfi_st * w)
+{
+	uint32_t t0 = HWREG(LIBTI2CIT_DWT_CYCCNT);
+	libti2cit_m_syncwfi_meter_unprof(base, w);
+	libti2cit_prof_add(LIBTI2CIT_PROF_M_SYNCWFI_METER, t0);
+}
+LIBTI2CIT_PROF_WRAP(uint32_t, libti2cit_m_syncwfi_slept, LIBTI2CIT_PROF_M_SYNCWFI_SLEPT,
+	(uint32_t base, uint32_t * active), (base, active))
+
+#endif /* LIBTI2CIT_PROF */
@@ -2,8 +2,6 @@
  *
  * libti2cit: an improvement over the tiva i2c driverlib. Use driverlib to initialize hardware, then call these
  * functions for data I/O.
- *
- * TODO: slave mode, interrupt-driven instead of polled, i2c FIFO, and uDMA
  */
 
 /* libti2cit_m_sync_send(): i2c send a buffer and do not return until the send is complete.
@@ -15,7 +13,7 @@
  *      it is not possible to do a "quick_command" recv(), i.e. do NOT call recv(len == 0)
  *      the correct way: send(addr bit 0 == 1, len >= 0) followed by a recv(len > 0) -- does a start, send, repeated start, recv, stop
  *
- * returns 0=ack, or > 0 for error
+ * returns 0=ack, or > 0 for error: 1=address nack, 2=arbitration lost, 3 + (bytes not sent)=data nack (at most 0xfd)
  */
 extern uint8_t libti2cit_m_sync_send(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf);
 
@@ -37,6 +35,177 @@ extern uint8_t libti2cit_m_sync_recv(uint32_t base, uint32_t len, uint8_t * buf)
  */
 extern uint8_t libti2cit_m_sync_recvpart(uint32_t base, uint32_t len, uint8_t * buf);
 
+/* libti2cit_m_sync_send_to(), _recv_to(), _recvpart_to(): same as the functions above, but give up after timeout cpu cycles
+ *   timeout is for the whole call, counted with the Cortex-M4 DWT cycle counter (CYCCNT is turned on if it is off)
+ *   timeout == 0 waits forever, which is what libti2cit_m_sync_send(), _recv() and _recvpart() do
+ *   timeout == LIBTI2CIT_WFI waits forever asleep, see libti2cit_m_syncwfi_send()
+ *   e.g. timeout = sysclock / 1000 for 1ms: at 100kHz that is enough for about 8 bytes
+ *
+ * returns LIBTI2CIT_TIMEOUT if time ran out. The transaction is abandoned: libti2cit sends i2c STOP if it can
+ *   if a slave is holding SCL or SDA low the master stays busy and the STOP cannot be sent; the bus needs to be recovered
+ *   (I2C_MCS_BUSY and I2C_MCS_BUSBSY in I2C_O_MCS tell you which case it is)
+ */
+#define LIBTI2CIT_TIMEOUT (0xff)
+extern uint8_t libti2cit_m_sync_send_to(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf, uint32_t timeout);
+extern uint8_t libti2cit_m_sync_recv_to(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout);
+extern uint8_t libti2cit_m_sync_recvpart_to(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout);
+
+/* libti2cit_m_sync_send_pec(), _recv_pec(), _recvpart_pec(): the _to() functions with SMBus Packet Error Checking
+ *   pec carries the CRC-8 from one call to the next: send_pec() starts it, recv_pec() and recvpart_pec() continue it
+ *   a write (addr bit 0 == 0, len != 0) ends with the PEC byte, which the slave NACKs if the data arrived wrong
+ *   a read ends with the PEC byte from the slave: it is the byte after the last one in buf, and is not stored there
+ *   each address and data byte goes into the CRC as it passes through I2C_O_MDR: there is no second pass over buf
+ *
+ * returns the same as the _to() functions, or LIBTI2CIT_PEC_ERROR if the PEC byte was NACKed or did not match
+ */
+#define LIBTI2CIT_PEC_ERROR (0xfe)
+extern uint8_t libti2cit_m_sync_send_pec(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf, uint32_t timeout,
+	uint8_t * pec);
+extern uint8_t libti2cit_m_sync_recv_pec(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout, uint8_t * pec);
+extern uint8_t libti2cit_m_sync_recvpart_pec(uint32_t base, uint32_t len, uint8_t * buf, uint32_t timeout, uint8_t * pec);
+
+/* libti2cit_m_syncfifo_send(), libti2cit_m_syncfifo_recv(): libti2cit_m_sync_send() and libti2cit_m_sync_recv() through
+ * the 8-byte FIFOs, for moving kilobytes with interrupts off (a bootloader writing an i2c flash, a self-test)
+ *   each burst command moves up to 255 bytes without stopping for the cpu between bytes; the cpu only fills the TX
+ *   FIFO (or empties the RX FIFO) when I2C_O_FIFOSTATUS says it is below (above) the trigger level
+ *   the FIFOs are assigned to the master: do not use them for the on-chip slave of the same base
+ *
+ * same arguments and return values as libti2cit_m_sync_send() and libti2cit_m_sync_recv(), and they mix with the
+ *   other sync functions: e.g. libti2cit_m_syncfifo_send(addr bit 0 == 1) then libti2cit_m_sync_recvpart()
+ *   send with len == 0 and recv with len == 1 have nothing to put in a FIFO, the sync functions do them
+ *   libti2cit_m_syncfifo_recv() reads exactly len bytes, where libti2cit_m_sync_recv() reads one more and drops it
+ *   there are no _to() or _pec() versions: these wait forever
+ */
+extern uint8_t libti2cit_m_syncfifo_send(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf);
+extern uint8_t libti2cit_m_syncfifo_recv(uint32_t base, uint32_t len, uint8_t * buf);
+
+/* libti2cit_m_syncwfi_send(), _recv(), _recvpart(): libti2cit_m_sync_send(), _recv() and _recvpart() that sleep in WFI
+ * while each byte is on the bus, instead of spinning on I2C_O_MRIS: for battery-powered boards that keep the simple API
+ *   the master interrupt is unmasked only while the core sleeps and is taken with PRIMASK set, so the core wakes up
+ *   but the i2c handler never runs: the NVIC interrupt must be enabled (ROM_IntEnable(INT_I2C2)), and the vector can
+ *   be anything. If it is not enabled these poll like the sync functions
+ *   other interrupts still wake the core and their handlers run between bytes, a little later than they would have
+ *   the same as the _to() and _pec() functions with timeout == LIBTI2CIT_WFI: that is how to get PEC or a
+ *     High-Speed master code while sleeping. There is no timeout: the DWT cycle counter is not a wake-up source
+ *   waits for a bit of I2C_O_MRIS to clear (the i2c STOP at the end) raise no interrupt, and still poll
+ *
+ * same arguments and return values as the sync functions, and they mix with them on the same controller
+ * WFI is the Cortex-M4 sleep mode: SysCtlSleepPowerSet() and (with SysCtlPeripheralClockGating(true)) the
+ *   SysCtlPeripheralSleepEnable() of the i2c controller decide what stays powered and clocked. The core wakes in a few cycles, which is nothing next to a byte at 1MHz (1080 cycles)
+ */
+#define LIBTI2CIT_WFI (0xffffffff)
+extern uint8_t libti2cit_m_syncwfi_send(uint32_t base, uint8_t addr, uint32_t len, const uint8_t * buf);
+extern uint8_t libti2cit_m_syncwfi_recv(uint32_t base, uint32_t len, uint8_t * buf);
+extern uint8_t libti2cit_m_syncwfi_recvpart(uint32_t base, uint32_t len, uint8_t * buf);
+
+/* libti2cit_m_syncwfi_meter(): count where the libti2cit_m_syncwfi_...() calls on base spend their cycles, in w
+ *   cycles is the whole of each call, sleep the part of it spent in WFI (DWT CYCCNT read around each WFI), nwfi the
+ *   number of WFIs: cycles - sleep is the time the core was active, for an energy estimate on a battery-powered board
+ *   without a meter libti2cit does not read CYCCNT at all. This turns CYCCNT on if the debugger has not
+ *   the _to() and _pec() functions with timeout == LIBTI2CIT_WFI add to sleep and nwfi, but not to cycles
+ *
+ * call it with no transfer running, and not from an interrupt; w must stay in memory
+ * calling it again with the same base replaces the old meter, w == 0 turns the meter off for base
+ * the counters wrap like CYCCNT, every 35 seconds at 120MHz: read them more often than that
+ */
+typedef struct libti2cit_wfi_st_ libti2cit_wfi_st;
+struct libti2cit_wfi_st_ {
+	uint32_t cycles;
+	uint32_t sleep;
+	uint32_t nwfi;
+
+	uint32_t private_base;
+	uint32_t private_cycles;
+	uint32_t private_sleep;
+	libti2cit_wfi_st * private_next;
+};
+extern void libti2cit_m_syncwfi_meter(uint32_t base, libti2cit_wfi_st * w);
+
+/* libti2cit_m_syncwfi_slept(): the cycles the libti2cit_m_syncwfi_...() calls on base spent in WFI since the last call
+ *   of this, and in *active (if not 0) the cycles they were awake: call it after each transfer to get them per transfer
+ * returns 0 and sets *active to 0 if base has no libti2cit_m_syncwfi_meter()
+ */
+extern uint32_t libti2cit_m_syncwfi_slept(uint32_t base, uint32_t * active);
+
+/* libti2cit_m_speed(): set the SCL speed of the master, instead of ROM_I2CMasterInitExpClk() which only does 100k or 400k
+ *   sysclock is what ROM_SysCtlClockFreqSet() returned
+ *   scl_hz up to 1000000 is Standard (100kHz), Fast (400kHz) or Fast-mode Plus (1MHz): every transfer runs at it
+ *   scl_hz above 1000000 is High-Speed mode (up to 3400000). Only transfers that begin with a master code run at it:
+ *     see libti2cit_m_sync_hs() and the hs field of libti2cit_int_st. Everything else, and the master code, runs at 400kHz
+ *   the slaves must support the speed, and Fast-mode Plus and High-Speed need stronger pull-ups than 400kHz does
+ *
+ * returns the actual speed, the fastest one at or below scl_hz that sysclock can make
+ * I2C_O_MTPR keeps a Standard/Fast timer period and a separate High-Speed one (set with I2C_MTPR_HS), the way
+ * I2CMasterInitExpClk() programs it on the TM4C129
+ */
+extern uint32_t libti2cit_m_speed(uint32_t base, uint32_t sysclock, uint32_t scl_hz);
+
+/* libti2cit_m_sync_hs(): send the High-Speed master code (0x08 to 0x0f, a different one for each master on the bus)
+ *   call it just before libti2cit_m_sync_send(): that transaction then runs in High-Speed mode, through any repeated
+ *   start and libti2cit_m_sync_recv(), until its i2c STOP. The next one is back at the Standard/Fast speed
+ *   no slave ACKs a master code, so the NACK is not an error
+ *
+ * returns 0=ok, 2=arbitration lost (another master won: no STOP is needed), LIBTI2CIT_TIMEOUT for _to()
+ */
+extern uint8_t libti2cit_m_sync_hs(uint32_t base, uint8_t code);
+extern uint8_t libti2cit_m_sync_hs_to(uint32_t base, uint8_t code, uint32_t timeout);
+
+/* libti2cit_dev_st: one slave in a libti2cit_speed_st table
+ *   addr is the 7-bit slave address (not shifted)
+ *   scl_hz is the fastest the slave can go, as for libti2cit_m_speed(): above 1000000 needs a master code in hs
+ *   hs is the High-Speed master code for it (see libti2cit_m_sync_hs()), 0 if scl_hz is 1000000 or less
+ *   clkocnt is the I2C_O_MCLKOCNT value while talking to it: how long it may hold SCL low before I2C_MIMR_CLKIM,
+ *     0 turns the clock low timeout off for slaves that stretch the clock for a long time (EEPROMs, sensors)
+ */
+typedef struct libti2cit_dev_st_ {
+	uint8_t addr;
+	uint8_t hs;
+	uint8_t clkocnt;
+	uint32_t scl_hz;
+
+	uint32_t private_mtpr;
+	uint32_t private_mtpr_hs;
+} libti2cit_dev_st;
+
+/* libti2cit_speed_st: the speed of each slave on a bus, so a slow slave only slows down its own transactions
+ *   sysclock is what ROM_SysCtlClockFreqSet() returned, as for libti2cit_m_speed()
+ *   dev is the table, ndev the number of entries in it
+ *   other is used for every address not in dev: fill in its scl_hz and clkocnt (its addr is ignored)
+ *
+ * nswitch counts how many times I2C_O_MTPR or I2C_O_MCLKOCNT was changed, ncheck how many transactions looked up
+ * their slave: for your information, clear them whenever you like
+ */
+typedef struct libti2cit_speed_st_ libti2cit_speed_st;
+struct libti2cit_speed_st_ {
+	uint32_t sysclock;
+	libti2cit_dev_st * dev;
+	uint32_t ndev;
+	libti2cit_dev_st other;
+	uint32_t nswitch;
+	uint32_t ncheck;
+
+	libti2cit_speed_st * private_next;
+	uint32_t private_base;
+	const libti2cit_dev_st * private_dev;
+	uint32_t private_mtpr;
+	uint32_t private_mtpr_hs;
+	uint32_t private_clkocnt;
+};
+
+/* libti2cit_m_speed_table(): use sp for every transaction on base from now on, instead of one libti2cit_m_speed()
+ *   each libti2cit_m_sync_send() and libti2cit_m_..._send() finds its slave in the table before the i2c START and
+ *   reprograms I2C_O_MTPR and I2C_O_MCLKOCNT only if the speed is not what the last transaction used
+ *   a slave with hs set gets its master code sent first: do not call libti2cit_m_sync_hs() or set st->hs for it too
+ *   libti2cit_m_isr_queue() and libti2cit_mgr_submit() batches switch speed between their transactions the same way
+ *
+ * call it with no transfer running, and not from an interrupt; sp must stay in memory
+ * calling it again with the same base replaces the old table, sp == 0 turns the table off for base
+ * (libti2cit_m_speed() on a base with a table confuses it: change the table and call libti2cit_m_speed_table() again)
+ *
+ * returns the actual speed of other, see libti2cit_m_speed()
+ */
+extern uint32_t libti2cit_m_speed_table(uint32_t base, libti2cit_speed_st * sp);
+
 
 
 
@@ -49,9 +218,89 @@ extern uint8_t libti2cit_m_sync_recvpart(uint32_t base, uint32_t len, uint8_t *
  * you MUST fill in the fields required before calling the functions below
  * you MUST NOT read or write to fields in private_ (or your application will break badly because these fields will change)
  * except, you MUST initialize the entire libti2cit_int_st to 0 when it is first created
+ *
+ * nisr is only for your information: the number of interrupts libti2cit_m_isr_isr() (or libti2cit_s_isr_isr()) serviced since the send() or recv() started
+ * dma_tx and dma_rx are the uDMA channel numbers for libti2cit_m_isrdma_...() and libti2cit_s_isrdma_...(), leave them 0 if you do not use uDMA
+ * hs is a High-Speed master code (see libti2cit_m_sync_hs()): each libti2cit_m_..._send() sends it first, leave it 0 for Standard/Fast
+ *   (a libti2cit_m_speed_table() entry with its own hs wins over this one)
+ * pec turns on SMBus Packet Error Checking for the master functions, see libti2cit_m_sync_send_pec(): a write gets the PEC
+ *   byte appended, a read has it checked and user_cb gets LIBTI2CIT_ISR_PEC with I2C_MIMR_STOPIM if it was wrong
+ *   the uDMA functions hand a transfer with pec set to the FIFO functions, since the cpu has to see every byte
+ * xfer, nxfer and ixfer are for libti2cit_m_isr_queue(), leave them 0 otherwise
+ * recover turns on automatic bus recovery in libti2cit_m_isr_isr(), see libti2cit_m_recover(); leave it 0 to turn it off
+ * scan is for libti2cit_m_scan(), leave it 0 otherwise
+ * regs turns libti2cit_s_isr_isr() into a register bank slave, see libti2cit_s_regs_st; leave it 0 otherwise
+ * regs2 is a second bank for the second slave address in I2C_O_SOAR2; leave it 0 and that address uses regs too
  */
 typedef struct libti2cit_int_st_ libti2cit_int_st;
 typedef void (* libti2cit_status_cb)(libti2cit_int_st * st, uint32_t status);
+
+/* libti2cit_recover_st: the GPIO pins of an i2c controller, for libti2cit_m_recover()
+ *   gpio_base is the GPIO port of SCL and SDA, e.g. GPIO_PORTL_BASE for I2C2 on the Connected Launchpad
+ *   scl and sda are the pins, e.g. GPIO_PIN_1 and GPIO_PIN_0 for I2C2 on the Connected Launchpad
+ *   half_bit is the ROM_SysCtlDelay() count for half an SCL period: sysclock / 3 / (2 * 100000) for 100kHz
+ *
+ * nrecover counts the recoveries, for your information
+ */
+typedef struct libti2cit_recover_st_ {
+	uint32_t gpio_base;
+	uint8_t scl;
+	uint8_t sda;
+	uint32_t half_bit;
+	uint32_t nrecover;
+
+	uint32_t private_nretry;
+} libti2cit_recover_st;
+
+/* libti2cit_xfer_st: one transaction in a libti2cit_m_isr_queue() batch
+ *   addr is (slave address << 1) just like libti2cit_m_sync_send(); bit 0 is ignored, rlen decides if there is a read
+ *   wlen == 0 && rlen == 0: quick command (i2c START, address, i2c STOP)
+ *   wlen != 0 && rlen == 0: write wbuf
+ *   wlen != 0 && rlen != 0: write wbuf, i2c repeated start, read rbuf
+ *   wlen == 0 && rlen != 0: read rbuf
+ *
+ * status is filled in by libti2cit: 0 on success, I2C_MIMR_NACKIM or I2C_MIMR_ARBLOSTIM on failure
+ *   (or LIBTI2CIT_ISR_PEC if st->pec is set and the PEC of the read was wrong)
+ */
+typedef struct libti2cit_xfer_st_ {
+	uint8_t addr;
+	const uint8_t * wbuf;
+	uint32_t wlen;
+	uint8_t * rbuf;
+	uint32_t rlen;
+	uint32_t status;
+} libti2cit_xfer_st;
+
+/* libti2cit_s_regs_st: a bank of registers that an i2c master reads and writes through the on-chip slave
+ * the same protocol as most i2c sensors and eeproms:
+ *   the first byte the master writes after the address is the register pointer
+ *   more bytes are written to regs[pointer], regs[pointer + 1], ...
+ *   a read (usually after a repeated start) returns regs[pointer], regs[pointer + 1], ...
+ *   the pointer wraps from nregs - 1 to 0. If the master sets it to nregs or more, writes are NACKed and reads return 0xff
+ *
+ * regs and nregs are the bank, nregs is at most 256
+ * wmask[n] is the bits of regs[n] the master may change: 0x00 is a read-only register, wmask == 0 means all writable
+ * wr_cb is called from libti2cit_s_isr_isr() at the i2c STOP or repeated start after the master wrote n registers
+ *   starting at first (n can be more than nregs - first if the pointer wrapped). Leave it 0 if you do not need it
+ *
+ * nwrite and nread count the data bytes, for your information
+ */
+typedef struct libti2cit_s_regs_st_ libti2cit_s_regs_st;
+typedef void (* libti2cit_s_regs_cb)(libti2cit_int_st * st, uint32_t first, uint32_t n);
+struct libti2cit_s_regs_st_ {
+	uint8_t * regs;
+	uint32_t nregs;
+	const uint8_t * wmask;
+	libti2cit_s_regs_cb wr_cb;
+	uint32_t nwrite;
+	uint32_t nread;
+
+	uint32_t private_ptr;
+	uint32_t private_first;
+	uint32_t private_n;
+	uint32_t private_nack;
+};
+
 struct libti2cit_int_st_ {
 	uint32_t base;
 	uint8_t * buf;
@@ -59,8 +308,23 @@ struct libti2cit_int_st_ {
 	uint32_t nread;
 	uint32_t len;
 	uint8_t addr;
+	uint8_t dma_tx;
+	uint8_t dma_rx;
+	uint8_t hs;
+	uint8_t pec;
+	uint32_t nisr;
+	libti2cit_xfer_st * xfer;
+	uint32_t nxfer;
+	uint32_t ixfer;
+	libti2cit_recover_st * recover;
+	uint32_t * scan;
+	libti2cit_s_regs_st * regs;
+	libti2cit_s_regs_st * regs2;
 
-	void * private_;
+	uint32_t private_state;
+	uint32_t private_nburst;
+	uint32_t private_next;
+	uint32_t private_crc;
 };
 
 /* libti2cit_m_int_clear() reads I2C_O_MMIS then writes to I2C_O_MICR to acknowledge the interrupt
@@ -72,6 +336,7 @@ struct libti2cit_int_st_ {
  */
 extern uint32_t libti2cit_m_int_clear(libti2cit_int_st * st);
 
+#define LIBTI2CIT_ISR_PEC        (0x08000000)
 #define LIBTI2CIT_ISR_S_STOP     (0x10000000)
 #define LIBTI2CIT_ISR_S_START    (0x20000000)
 #define LIBTI2CIT_ISR_UNEXPECTED (0x40000000)
@@ -136,12 +401,20 @@ extern void libti2cit_m_isr_nofifo_recvpart(libti2cit_int_st * st);
 
 
 
-/* libti2cit_m_isr_send(): i2c send a buffer and call user_cb when complete
+/* libti2cit_m_isr_send(): i2c send a buffer using the i2c FIFO and call user_cb when complete
  *   fill in libti2cit_int_st exactly like libti2cit_m_sync_send() arguments:
  *   you MUST fill in base, addr, len, buf, and user_cb in libti2cit_int_st
  *
+ * libti2cit_m_isr_nofifo_send() takes an interrupt for every byte. This uses FIFO bursts (up to 255 bytes each) and
+ * only interrupts when the TX FIFO needs a refill: in make sim a 64 byte eeprom page write (66 bytes with the memory
+ * address) takes 11 interrupts, where libti2cit_m_isr_nofifo_send() takes 67
+ *   the TX FIFO is assigned to the master, you MUST NOT use it for the slave on the same base
+ *   you MUST enable I2C_MIMR_IM, I2C_MIMR_NACKIM and I2C_MIMR_STOPIM; libti2cit turns I2C_MIMR_TXIM on and off itself
+ *   send() with len == 0 has nothing to put in the FIFO and is the same as libti2cit_m_isr_nofifo_send()
+ *
  * on success: calls user_cb(status = I2C_MIMR_IM)
  * on failure: calls user_cb(status = I2C_MIMR_NACKIM)
+ *   or calls user_cb(status & I2C_MIMR_ARBLOSTIM) if another master won the bus (only if you enabled I2C_MIMR_ARBLOSTIM)
  *   len and nread will be corrupted and you should not read its contents
  *   base, addr, buf, and user_cb will be unchanged
  *
@@ -151,10 +424,15 @@ extern void libti2cit_m_isr_nofifo_recvpart(libti2cit_int_st * st);
  */
 extern void libti2cit_m_isr_send(libti2cit_int_st * st);
 
-/* libti2cit_m_isr_recv(): i2c receive a buffer and call user_cb when complete
+/* libti2cit_m_isr_recv(): i2c receive a buffer using the i2c FIFO and call user_cb when complete
  *   fill in libti2cit_int_st exactly like libti2cit_m_sync_recv() arguments:
  *   you MUST fill in base, addr, len, buf, and user_cb in libti2cit_int_st
  *
+ * interrupts only when the RX FIFO is nearly full and at the end of each burst, like libti2cit_m_isr_send()
+ *   the RX FIFO is assigned to the master, you MUST NOT use it for the slave on the same base
+ *   you MUST enable I2C_MIMR_IM, I2C_MIMR_NACKIM and I2C_MIMR_STOPIM; libti2cit turns I2C_MIMR_RXIM on and off itself
+ *   any libti2cit_m_..._send() can come before this, the first byte is always in I2C_O_MDR
+ *
  * on success: calls user_cb(status = I2C_MIMR_IM)
  * on failure: calls user_cb(status = I2C_MIMR_NACKIM)
  *   len will be corrupted and you should not read its contents
@@ -167,10 +445,14 @@ extern void libti2cit_m_isr_send(libti2cit_int_st * st);
  */
 extern void libti2cit_m_isr_recv(libti2cit_int_st * st);
 
-/* libti2cit_m_isr_recvpart(): i2c receive a buffer but do not send i2c STOP -- for when the length varies based on the data
+/* libti2cit_m_isr_recvpart(): i2c receive a buffer using the i2c FIFO but do not send i2c STOP -- for when the length varies based on the data
  *   fill in libti2cit_int_st exactly like libti2cit_m_sync_recvpart() arguments:
  *   you MUST fill in base, addr, len, buf, and user_cb in libti2cit_int_st
  *
+ * same FIFO and interrupt requirements as libti2cit_m_isr_recv()
+ *   if the first call has len == 1, the byte is already in I2C_O_MDR: user_cb is called before recvpart() returns
+ *   the final call with len == 0 is the same as libti2cit_m_isr_nofifo_recvpart()
+ *
  * on success: calls user_cb(status = I2C_MIMR_IM)
  * on failure: calls user_cb(status = I2C_MIMR_NACKIM)
  *   len will be corrupted and you should not read its contents
@@ -185,6 +467,388 @@ extern void libti2cit_m_isr_recvpart(libti2cit_int_st * st);
 
 
 
+/* libti2cit_m_isrdma_send(): i2c send a buffer using the uDMA and call user_cb when complete
+ *   fill in libti2cit_int_st exactly like libti2cit_m_sync_send() arguments:
+ *   you MUST fill in base, addr, len, buf, user_cb and dma_tx in libti2cit_int_st
+ *
+ * the uDMA feeds the TX FIFO, so the cpu only sees one interrupt per 255 byte burst (I2C_O_MBLEN is 8 bits) plus the STOP
+ *   before calling this, you MUST set up the uDMA: ROM_uDMAEnable(), ROM_uDMAControlBaseSet() and
+ *   ROM_uDMAChannelAssign() to connect dma_tx to the TX FIFO of this i2c base
+ *   buf MUST stay valid until user_cb is called, the uDMA reads it while the cpu does other things
+ *   the TX FIFO is assigned to the master, you MUST NOT use it for the slave on the same base
+ *   you MUST enable I2C_MIMR_IM, I2C_MIMR_NACKIM and I2C_MIMR_STOPIM, and SHOULD enable I2C_MIMR_ARBLOSTIM
+ *
+ * on success: calls user_cb(status = I2C_MIMR_STOPIM)
+ * on failure: calls user_cb(status & I2C_MIMR_NACKIM), then user_cb(status = I2C_MIMR_STOPIM) after the i2c STOP
+ *   or calls user_cb(status & I2C_MIMR_ARBLOSTIM) if another master won the bus
+ *   len and nread will be corrupted and you should not read its contents
+ *   base, addr, buf, and user_cb will be unchanged
+ *
+ * DO NOT use libti2cit_int_st for multiple send()s and recv()s at once and DO NOT use the same base address for multiple libti2cit_int_st
+ * DO reuse the same libti2cit_int_st when doing send()s and recv()s in sequence
+ *   only read or write to the libti2cit_int_st in user_cb and after user_cb has been called
+ */
+extern void libti2cit_m_isrdma_send(libti2cit_int_st * st);
+
+/* libti2cit_m_isrdma_recv(): i2c receive a buffer using the uDMA and call user_cb when complete
+ *   fill in libti2cit_int_st exactly like libti2cit_m_sync_recv() arguments:
+ *   you MUST fill in base, addr, len, buf, user_cb and dma_rx in libti2cit_int_st
+ *
+ * same uDMA and interrupt requirements as libti2cit_m_isrdma_send(), with dma_rx connected to the RX FIFO
+ *   libti2cit turns I2C_MIMR_DMARXIM on and off itself
+ *   any libti2cit_m_..._send() can come before this, the first byte is always in I2C_O_MDR
+ *
+ * on success: calls user_cb(status = I2C_MIMR_STOPIM) after the i2c STOP
+ * on failure: calls user_cb(status & I2C_MIMR_ARBLOSTIM) if another master won the bus
+ *   len will be corrupted and you should not read its contents
+ *   base, addr, buf, and user_cb will be unchanged
+ *   nread will contain the number of bytes received (counted at the end of each burst)
+ *
+ * DO NOT use libti2cit_int_st for multiple send()s and recv()s at once and DO NOT use the same base address for multiple libti2cit_int_st
+ * DO reuse the same libti2cit_int_st when doing send()s and recv()s in sequence
+ *   only read or write to the libti2cit_int_st in user_cb and after user_cb has been called
+ */
+extern void libti2cit_m_isrdma_recv(libti2cit_int_st * st);
+
+/* libti2cit_m_isrdma_recvpart(): i2c receive a buffer using the uDMA but do not send i2c STOP -- for when the length varies based on the data
+ *   fill in libti2cit_int_st exactly like libti2cit_m_sync_recvpart() arguments:
+ *   you MUST fill in base, addr, len, buf, user_cb and dma_rx in libti2cit_int_st
+ *
+ * same uDMA and interrupt requirements as libti2cit_m_isrdma_recv()
+ *   if the first call has len == 1, the byte is already in I2C_O_MDR: user_cb is called before recvpart() returns
+ *   the final call with len == 0 is the same as libti2cit_m_isr_nofifo_recvpart()
+ *
+ * on success: calls user_cb(status = I2C_MIMR_STOPIM) (but no i2c STOP occurred)
+ * on failure: calls user_cb(status & I2C_MIMR_ARBLOSTIM) if another master won the bus
+ *
+ * DO NOT use libti2cit_int_st for multiple send()s and recv()s at once and DO NOT use the same base address for multiple libti2cit_int_st
+ * DO reuse the same libti2cit_int_st when doing send()s and recv()s in sequence
+ *   only read or write to the libti2cit_int_st in user_cb and after user_cb has been called
+ */
+extern void libti2cit_m_isrdma_recvpart(libti2cit_int_st * st);
+
+/* libti2cit_m_isr_queue(): run a batch of transactions back-to-back and call user_cb once when all are done
+ *   you MUST fill in base, xfer, nxfer and user_cb in libti2cit_int_st
+ *   each transaction is started by libti2cit_m_isr_isr() in the same interrupt that finishes the one before it, so the bus
+ *   only idles for the i2c STOP -> START time between them
+ *
+ * the transactions use libti2cit_m_isr_send() and libti2cit_m_isr_recv(): same FIFO and interrupt requirements
+ *   xfer[] and the buffers in it MUST stay valid until user_cb is called
+ *   a NACK does not stop the batch: the i2c STOP is sent, xfer[i].status is set and the next transaction starts
+ *
+ * on success: calls user_cb(status = I2C_MIMR_STOPIM)
+ *   status also has I2C_MIMR_NACKIM if any transaction got a NACK: check xfer[i].status
+ * on failure: calls user_cb(status & I2C_MIMR_ARBLOSTIM) if another master won the bus
+ *   or calls user_cb(status & I2C_MIMR_CLKIM) on a clock low timeout
+ *   ixfer is the transaction that was interrupted, the ones after it were not started
+ *   with st->recover set, the bus is recovered and xfer[ixfer] is run again first: up to LIBTI2CIT_RECOVER_RETRY times
+ *
+ * while the batch runs, st belongs to libti2cit: addr, buf, len and nread change with every transaction
+ */
+extern void libti2cit_m_isr_queue(libti2cit_int_st * st);
+
+/* libti2cit_m_scan(): find every device on the bus and call user_cb once when done
+ *   you MUST fill in base, scan and user_cb in libti2cit_int_st
+ *   scan points to a uint32_t[4] bitmap, 1 bit per 7-bit address: the device at a is present if scan[a >> 5] & (1u << (a & 31))
+ *
+ * each address 1 - 127 gets a quick command (i2c START, address, i2c STOP), started by libti2cit_m_isr_isr() from
+ * the interrupt that finished the one before. Address 0 is the general call and is not scanned.
+ *   same interrupt requirements as libti2cit_m_isr_nofifo_send(); each libti2cit_int_st (each base) can scan at the same time
+ *   warning: some SMBus devices take a quick command as an on/off command
+ *
+ * on success: calls user_cb(status = I2C_MIMR_STOPIM), st->scan is complete
+ * on failure: calls user_cb(status & I2C_MIMR_ARBLOSTIM) or user_cb(status & I2C_MIMR_CLKIM), addr >> 1 is where it stopped
+ *   with st->recover set, the bus is recovered and the scan continues
+ */
+extern void libti2cit_m_scan(libti2cit_int_st * st);
+
+/* libti2cit_mgr_...(): run transactions on up to all ten i2c controllers at once
+ *   libti2cit_mgr_st holds one libti2cit_int_st per controller, indexed by bus id 0 - 9 for I2C0_BASE - I2C9_BASE
+ *   each bus has a queue of LIBTI2CIT_MGR_QLEN transactions and runs them back-to-back with libti2cit_m_isr_queue()
+ *   from its own interrupt, so every bus transfers in parallel and the cpu only sees the interrupts
+ *
+ * you MUST still initialize each controller you use with the Tivaware DriverLib, enable I2C_MIMR_IM, I2C_MIMR_NACKIM and
+ * I2C_MIMR_STOPIM, and call libti2cit_mgr_isr(mgr, id) from the I2C interrupt handler of that controller
+ * you MAY set mgr->bus[id].st.recover (and dma_tx, dma_rx) after libti2cit_mgr_init(); do not touch the rest of st
+ */
+#define LIBTI2CIT_MGR_NBUS (10)
+#define LIBTI2CIT_MGR_QLEN (8)
+typedef struct libti2cit_mgr_st_ libti2cit_mgr_st;
+typedef void (* libti2cit_mgr_cb)(libti2cit_mgr_st * mgr, uint32_t id, libti2cit_xfer_st * x);
+typedef struct libti2cit_mgr_bus_st_ {
+	libti2cit_int_st st;	// MUST be first: libti2cit_mgr_done() casts st back to libti2cit_mgr_bus_st
+	libti2cit_mgr_st * mgr;
+	uint32_t id;
+	libti2cit_xfer_st * volatile q[LIBTI2CIT_MGR_QLEN];	// volatile: the store to q[] must not move after wr++
+	volatile uint32_t wr;	// only written by libti2cit_mgr_submit()
+	volatile uint32_t rd;	// only written by the interrupt
+	volatile uint32_t running;
+
+	// utilisation, since libti2cit_mgr_util_clear()
+	uint32_t t_start;	// DWT CYCCNT when the bus went busy
+	uint32_t busy;		// cpu cycles the bus was busy
+	uint32_t nxfer;		// transactions done
+	uint32_t nbytes;	// bytes written and read
+} libti2cit_mgr_bus_st;
+struct libti2cit_mgr_st_ {
+	libti2cit_mgr_bus_st bus[LIBTI2CIT_MGR_NBUS];
+	libti2cit_mgr_cb done;
+	uint32_t t0;
+};
+
+/* libti2cit_mgr_init(): set up mgr, done is called from the interrupt after each transaction (x->status is the result)
+ */
+extern void libti2cit_mgr_init(libti2cit_mgr_st * mgr, libti2cit_mgr_cb done);
+
+/* libti2cit_mgr_submit(): add x to the queue of bus id, start it now if the bus is idle
+ *   x and its buffers MUST stay valid until done is called
+ *   call from thread mode or from done(): only one context may submit to the same bus
+ *   returns 0 on success, 1 if the queue is full
+ */
+extern uint32_t libti2cit_mgr_submit(libti2cit_mgr_st * mgr, uint32_t id, libti2cit_xfer_st * x);
+
+/* libti2cit_mgr_isr(): call from the interrupt handler of bus id, returns the same as libti2cit_m_isr_isr()
+ */
+extern uint32_t libti2cit_mgr_isr(libti2cit_mgr_st * mgr, uint32_t id);
+
+/* libti2cit_mgr_util(): how busy bus id has been since libti2cit_mgr_util_clear(), in 1/1000ths of the time
+ *   the DWT cycle counter wraps every 35 seconds at 120MHz: call libti2cit_mgr_util_clear() more often than that
+ */
+extern uint32_t libti2cit_mgr_util(libti2cit_mgr_st * mgr, uint32_t id);
+extern void libti2cit_mgr_util_clear(libti2cit_mgr_st * mgr);
+
+/* libti2cit_m_recover(): free a bus where a slave is holding SDA low
+ *   a slave that was reset (or saw a glitch) in the middle of sending a byte waits for SCL forever, holding SDA low,
+ *   so every START loses arbitration. libti2cit switches SCL and SDA to GPIO, clocks SCL up to 9 times until the
+ *   slave lets go of SDA, sends i2c STOP, gives the pins back to the i2c controller and restarts the master.
+ *   This takes about 11 SCL periods, done with ROM_SysCtlDelay(): about 110us at 100kHz.
+ *
+ * from the sync functions: call this when they return 2 (arbitration lost) or LIBTI2CIT_TIMEOUT, then try again
+ * from the isr functions: set st->recover and libti2cit_m_isr_isr() calls this on I2C_MIMR_CLKIM, and on
+ *   I2C_MIMR_ARBLOSTIM when I2C_O_MBMON shows SDA or SCL held low for a whole SCL period (enable them in I2C_O_MIMR,
+ *   and set I2C_O_MCLKOCNT for I2C_MIMR_CLKIM), then calls user_cb with that status, or resumes
+ *   libti2cit_m_isr_queue(). An arbitration loss to another master (the lines keep moving, or are idle again) is
+ *   reported to user_cb and the queue as I2C_MIMR_ARBLOSTIM without touching the pins
+ *   the recovery itself runs in the i2c interrupt: about 110us at 100kHz, plus one SCL period for the I2C_O_MBMON check
+ * from the sync functions on a bus with other masters, check I2C_O_MBMON the same way before calling this
+ *
+ * returns 0 if SCL and SDA are both high afterwards, 1 if SDA is still low, 2 if SCL is held low (nothing can fix that)
+ */
+#define LIBTI2CIT_RECOVER_RETRY (3)
+extern uint32_t libti2cit_m_recover(uint32_t base, libti2cit_recover_st * r);
+
+/* libti2cit_nvm_...(): read and write an eeprom without any fixed delays
+ * after a write the device is busy for its write cycle (up to 5 or 10ms); libti2cit finds out when it is done by
+ * ACK polling: quick commands until the device ACKs its address again, then the next transaction goes right away
+ *
+ * type LIBTI2CIT_NVM_24CXX: a 24Cxx-style eeprom of size bytes
+ *   addr_bytes is 1 (24C01 - 24C16) or 2 (24C32 and up). Address bits that do not fit go in the low bits of addr,
+ *   e.g. 24C16 block 5 is addr | 5. mem is the byte address, a read is one sequential read up to the end of the block
+ *   page is the page size from the datasheet: writes are split so no page write wraps around inside a page
+ * type LIBTI2CIT_NVM_HIH: the eeprom of a Honeywell HIH6130 in command mode (you send 0xa0 within 10ms of power up)
+ *   mem and len are in bytes and must be even: word n of the eeprom is mem = 2n, high byte first as the sensor sends it
+ *   each word is a command, then reads of the status byte until it is no longer busy (0x80): the status polling
+ *   replaces ACK polling, since the sensor ACKs while it works. page and addr_bytes are ignored
+ *
+ * you MUST initialize the entire libti2cit_nvm_st to 0, then fill in st.base, addr, type, addr_bytes, page and size
+ *   addr is the 7-bit address (not shifted), as in libti2cit_dev_st
+ *   timeout is how long to keep polling, in cpu cycles (see libti2cit_m_sync_send_to()): 0 polls forever
+ *   you MAY set st.recover (see libti2cit_m_recover()); do not touch the rest of st, libti2cit uses st.user_cb
+ * npoll counts the polls that found the device still busy, for your information
+ */
+#ifndef LIBTI2CIT_NVM_PAGE
+#define LIBTI2CIT_NVM_PAGE (64)	// the longest page write: libti2cit_nvm_st has a buffer of LIBTI2CIT_NVM_PAGE + 2 bytes
+// LIBTI2CIT_NVM_PAGE + 3 must stay below LIBTI2CIT_NVM_FAIL, libti2cit.c checks it when it compiles
+#endif
+#define LIBTI2CIT_NVM_24CXX (0)
+#define LIBTI2CIT_NVM_HIH   (1)
+#define LIBTI2CIT_NVM_FAIL  (0xfc)	// HIH status byte was not success: 0x82 is an illegal command
+typedef struct libti2cit_nvm_st_ libti2cit_nvm_st;
+typedef void (* libti2cit_nvm_cb)(libti2cit_nvm_st * nvm, uint8_t r);
+struct libti2cit_nvm_st_ {
+	libti2cit_int_st st;	// MUST be first: libti2cit casts st back to libti2cit_nvm_st
+	uint8_t addr;
+	uint8_t type;
+	uint8_t addr_bytes;
+	uint32_t page;
+	uint32_t size;
+	uint32_t timeout;
+	libti2cit_nvm_cb done;
+	uint32_t npoll;
+
+	uint8_t private_busy;
+	uint8_t private_write;
+	uint8_t private_phase;
+	uint32_t private_mem;
+	uint32_t private_len;
+	uint32_t private_n;
+	uint8_t * private_buf;
+	uint32_t private_t0;
+	libti2cit_xfer_st private_xfer[2];
+	uint8_t private_wbuf[LIBTI2CIT_NVM_PAGE + 2];
+};
+
+/* libti2cit_nvm_sync_read(), _write(): read or write len bytes at mem and do not return until done
+ *   write returns as soon as the last page is sent: the device is then busy, and the next call polls it first
+ *   libti2cit_nvm_sync_wait() polls until the device ACKs (call it before powering the device down)
+ *
+ * returns the same as libti2cit_m_sync_send(), LIBTI2CIT_TIMEOUT if the device was still busy after timeout cycles,
+ *   or LIBTI2CIT_NVM_FAIL (writes are at most LIBTI2CIT_NVM_PAGE + 2 bytes, so a data NACK never reaches 0xfc)
+ */
+extern uint8_t libti2cit_nvm_sync_read(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, uint8_t * buf);
+extern uint8_t libti2cit_nvm_sync_write(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, const uint8_t * buf);
+extern uint8_t libti2cit_nvm_sync_wait(libti2cit_nvm_st * nvm);
+
+/* libti2cit_nvm_isr_read(), _write(), _wait(): the same from the interrupt, then call done(nvm, r) from it
+ *   r is what libti2cit_nvm_sync_...() would have returned, except every NACK is 1
+ *   each transaction (and each poll) is started by libti2cit_m_isr_isr() from the interrupt that finished the one
+ *   before it, with libti2cit_m_isr_queue(): the same FIFO and interrupt requirements. Call libti2cit_m_isr_isr(&nvm->st)
+ *   from your interrupt handler. buf MUST stay valid until done is called
+ *   if there is nothing to send (len == 0 and the device is not busy) done is called before _isr_...() returns
+ */
+extern void libti2cit_nvm_isr_read(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, uint8_t * buf);
+extern void libti2cit_nvm_isr_write(libti2cit_nvm_st * nvm, uint32_t mem, uint32_t len, const uint8_t * buf);
+extern void libti2cit_nvm_isr_wait(libti2cit_nvm_st * nvm);
+
+/* libti2cit_sched_...(): read many sensors on one bus periodically, with no delays on the cpu or on the bus
+ * a sensor like the HIH6130 is read in two transactions: measure (a quick command or a write starts a conversion),
+ * then fetch (a read, conv later). libti2cit_sched_tick() is called from a general-purpose timer interrupt every tick;
+ * it starts every measure and fetch that is due as one libti2cit_m_isr_queue() batch, so the conversions of all
+ * sensors overlap and the bus only carries the short transactions between them
+ *
+ * libti2cit_sched_dev_st: one sensor
+ *   measure and fetch are the two transactions (see libti2cit_xfer_st): fill in addr, wbuf, wlen, rbuf and rlen
+ *   period is how often to measure, conv is the conversion time: both in ticks (conv is rounded up by up to one tick)
+ *   done(sched, dev) is called from the interrupt after the fetch, or after the measure if it failed:
+ *     measure.status and fetch.status say which. fetch.rbuf holds the reading until the next fetch starts
+ *     return 0, or n to fetch again n ticks later (e.g. the HIH6130 "stale" bit was set)
+ *   nread and nerr count the fetches and the failed transactions, for your information
+ *
+ * libti2cit_sched_st: fill in st.base, dev and ndev; you MAY set st.recover (see libti2cit_m_recover())
+ *   do not touch the rest of st, libti2cit uses st.user_cb, st.xfer and st.nxfer
+ *   now counts the ticks, nlate counts transactions that started a tick or more after they were due (the bus was busy)
+ *   running is 1 while a batch is on the bus: after stopping the timer, wait for 0 before using the base for anything else
+ *
+ * you MUST initialize the entire libti2cit_sched_st and every libti2cit_sched_dev_st to 0 before filling them in
+ * you MUST call libti2cit_m_isr_isr(&sched->st) from the I2C interrupt handler, with the same FIFO and interrupt
+ *   requirements as libti2cit_m_isr_queue()
+ * the timer interrupt MUST have the same priority as the I2C interrupt: libti2cit_sched_tick() and the I2C interrupt
+ *   both start batches, neither may interrupt the other
+ */
+#ifndef LIBTI2CIT_SCHED_BATCH
+#define LIBTI2CIT_SCHED_BATCH (8)	// the most transactions started by one tick: the rest wait for the batch to finish
+#endif
+typedef struct libti2cit_sched_st_ libti2cit_sched_st;
+typedef struct libti2cit_sched_dev_st_ libti2cit_sched_dev_st;
+typedef uint32_t (* libti2cit_sched_cb)(libti2cit_sched_st * sched, libti2cit_sched_dev_st * dev);
+struct libti2cit_sched_dev_st_ {
+	libti2cit_xfer_st measure;
+	libti2cit_xfer_st fetch;
+	uint32_t period;
+	uint32_t conv;
+	libti2cit_sched_cb done;
+	uint32_t nread;
+	uint32_t nerr;
+
+	uint32_t private_phase;
+	uint32_t private_due;	// the tick the next transaction is due
+	uint32_t private_t;	// the tick the last measure was due: the next one is private_t + period
+};
+struct libti2cit_sched_st_ {
+	libti2cit_int_st st;	// MUST be first: libti2cit casts st back to libti2cit_sched_st
+	libti2cit_sched_dev_st * dev;
+	uint32_t ndev;
+	volatile uint32_t now;
+	uint32_t nlate;
+	volatile uint32_t running;
+
+	uint32_t private_next;	// the sensor the next batch looks at first, so no sensor waits behind a full batch for long
+	libti2cit_xfer_st private_q[LIBTI2CIT_SCHED_BATCH];
+	libti2cit_sched_dev_st * private_qdev[LIBTI2CIT_SCHED_BATCH];
+};
+
+/* libti2cit_sched_start(): set up the sensors, call before the timer starts
+ *   the first measures are spread evenly over one period, so the sensors do not all convert at once
+ */
+extern void libti2cit_sched_start(libti2cit_sched_st * sched);
+
+/* libti2cit_sched_tick(): call from the timer interrupt every tick
+ *   if the bus is busy, the transactions that are due start from the I2C interrupt as soon as the batch finishes
+ */
+extern void libti2cit_sched_tick(libti2cit_sched_st * sched);
+
+/* libti2cit_pt_...(): write a conversation with a device as straight-line code that runs from the interrupt
+ * a protothread: fn is a plain C function between LIBTI2CIT_PT_BEGIN() and LIBTI2CIT_PT_END(). Each
+ * LIBTI2CIT_PT_XFER() starts a transaction and returns from fn; when it is done libti2cit_m_isr_isr() calls fn again
+ * and it carries on just after the LIBTI2CIT_PT_XFER(). No RTOS and no stack per thread: the whole thread is
+ * libti2cit_pt_st plus whatever you keep next to it
+ *
+ *   static void hih_read(libti2cit_pt_st * pt)
+ *   {
+ *   	my_hih * h = (my_hih *) pt;	// libti2cit_pt_st is the first member of my_hih
+ *   	LIBTI2CIT_PT_BEGIN(pt);
+ *   	LIBTI2CIT_PT_XFER(pt, h->addr << 1, 0, 0, 0, 0);	// quick command: start a measurement
+ *   	do {
+ *   		LIBTI2CIT_PT_SLEEP(pt, 37);			// 37 ticks of libti2cit_pt_tick()
+ *   		LIBTI2CIT_PT_XFER(pt, h->addr << 1, 0, 0, h->buf, 4);
+ *   	} while (!pt->status && (h->buf[0] & 0x40));	// stale: not done yet
+ *   	LIBTI2CIT_PT_END(pt);
+ *   }
+ *
+ * the rules of every protothread:
+ *   local variables do not survive LIBTI2CIT_PT_XFER(), _SLEEP() or _YIELD(): keep them in the struct around libti2cit_pt_st
+ *   fn must not use switch itself around any of them (LIBTI2CIT_PT_BEGIN() is a switch), and must not return before
+ *   LIBTI2CIT_PT_END() except through them
+ *
+ * LIBTI2CIT_PT_XFER(pt, addr, wbuf, wlen, rbuf, rlen): one libti2cit_xfer_st, run with libti2cit_m_isr_queue()
+ *   then pt->status is its result: 0, I2C_MIMR_NACKIM, I2C_MIMR_ARBLOSTIM, I2C_MIMR_CLKIM or LIBTI2CIT_ISR_PEC
+ *   wbuf and rbuf MUST stay valid until fn runs again
+ * LIBTI2CIT_PT_SLEEP(pt, ticks): carry on after ticks calls (at least 1) of libti2cit_pt_tick(), e.g. from a timer interrupt
+ * LIBTI2CIT_PT_YIELD(pt): carry on at the next libti2cit_pt_resume(), e.g. from the done of libti2cit_nvm_isr_read()
+ *   start whatever calls libti2cit_pt_resume() just before LIBTI2CIT_PT_YIELD(), and it MUST NOT call it before that returns
+ *
+ * you MUST initialize the entire libti2cit_pt_st to 0, then fill in st.base; you MAY set st.recover, st.pec and st.hs
+ * you MUST call libti2cit_m_isr_isr(&pt->st) from the I2C interrupt handler, with the same FIFO and interrupt
+ *   requirements as libti2cit_m_isr_queue(). libti2cit_pt_tick() and libti2cit_pt_resume() MUST be called at the
+ *   same priority as the I2C interrupt
+ * running is 1 from libti2cit_pt_start() until fn reaches LIBTI2CIT_PT_END()
+ */
+typedef struct libti2cit_pt_st_ libti2cit_pt_st;
+typedef void (* libti2cit_pt_fn)(libti2cit_pt_st * pt);
+struct libti2cit_pt_st_ {
+	libti2cit_int_st st;	// MUST be first: libti2cit casts st back to libti2cit_pt_st
+	libti2cit_pt_fn fn;
+	uint32_t status;
+	volatile uint32_t running;
+
+	uint32_t private_lc;	// the __LINE__ of the LIBTI2CIT_PT_...() that fn carries on from, 0 = the start
+	uint32_t private_sleep;
+	libti2cit_xfer_st private_x;
+};
+
+#define LIBTI2CIT_PT_BEGIN(pt) switch ((pt)->private_lc) { case 0:
+#define LIBTI2CIT_PT_END(pt) } (pt)->private_lc = 0; (pt)->running = 0; return
+#define LIBTI2CIT_PT_XFER(pt, addr, wbuf, wlen, rbuf, rlen) do { \
+		(pt)->private_lc = __LINE__; libti2cit_pt_xfer(pt, addr, wbuf, wlen, rbuf, rlen); return; case __LINE__: ; \
+	} while (0)
+#define LIBTI2CIT_PT_SLEEP(pt, ticks) do { \
+		(pt)->private_lc = __LINE__; (pt)->private_sleep = (ticks); return; case __LINE__: ; \
+	} while (0)
+#define LIBTI2CIT_PT_YIELD(pt) do { \
+		(pt)->private_lc = __LINE__; return; case __LINE__: ; \
+	} while (0)
+
+/* libti2cit_pt_start(): run fn from the top, until its first LIBTI2CIT_PT_XFER(), _SLEEP() or _YIELD()
+ */
+extern void libti2cit_pt_start(libti2cit_pt_st * pt, libti2cit_pt_fn fn);
+/* libti2cit_pt_xfer(): what LIBTI2CIT_PT_XFER() calls, do not call it yourself */
+extern void libti2cit_pt_xfer(libti2cit_pt_st * pt, uint8_t addr, const uint8_t * wbuf, uint32_t wlen, uint8_t * rbuf,
+	uint32_t rlen);
+extern void libti2cit_pt_tick(libti2cit_pt_st * pt);
+extern void libti2cit_pt_resume(libti2cit_pt_st * pt);
+
+
+
 
 
 
@@ -204,6 +868,216 @@ extern uint32_t libti2cit_s_int_clear(libti2cit_int_st * st);
  * you SHOULD call libti2cit_s_isr_isr() EACH time the interrupt fires; even if the interrupt lines is shared between multiple sources
  * libti2cit_s_isr_isr() can tell when no interrupt originated from the i2c slave mode and just return 0
  *
- * returns HWREG(st->base + I2C_O_SCSR)
+ * if st->regs is set, libti2cit_s_isr_isr() answers the master from the register bank by itself (see libti2cit_s_regs_st)
+ * enable I2C_SIMR_DATAIM and I2C_SIMR_STOPIM; there is nothing left for your handler to do
+ *   one controller can be two devices: turn on the second address with ROM_I2CSlaveAddressSet(base, 1, addr2) and
+ *   put its bank in st->regs2. I2C_SCSR_OAR2SEL picks the bank, each bank has its own pointer and wr_cb
+ * otherwise your handler reads I2C_O_SDR on I2C_SCSR_RREQ and writes it on I2C_SCSR_TREQ
+ *
+ * returns HWREG(st->base + I2C_O_SCSR) on a data interrupt, bitwise ORed with LIBTI2CIT_ISR_S_START and LIBTI2CIT_ISR_S_STOP
  */
 extern uint32_t libti2cit_s_isr_isr(libti2cit_int_st * st);
+
+/* libti2cit_s_isr_send(): the slave answers the next master read from buf using the TX FIFO
+ *   you MUST fill in base, len, buf, and user_cb in libti2cit_int_st
+ *
+ * the FIFO is topped up from libti2cit_s_isr_isr() when it runs low (I2C_SIMR_TXIM, turned on and off by libti2cit),
+ *   so a master reading len bytes costs about len / 7 interrupts and SCL is not stretched if the isr keeps up
+ *   the TX FIFO is assigned to the slave, you MUST NOT use it for the master on the same base
+ *   you MUST enable I2C_SIMR_DATAIM and I2C_SIMR_STOPIM
+ *   if the master reads more than len bytes it gets 0xff
+ *   if the master writes while this is armed, the bytes come to your handler through I2C_SCSR_RREQ as usual
+ *
+ * the next i2c STOP ends it: the TX FIFO is flushed and user_cb(status = I2C_SIMR_STOPIM) is called
+ *   nread is the number of bytes put in the TX FIFO; the bytes the master did not read were thrown away
+ *   if the master writes a command and sends i2c STOP before reading, call libti2cit_s_isr_send() again from user_cb
+ *
+ * DO NOT arm libti2cit_s_isr_send() and libti2cit_s_isr_recv() at the same time: they share buf, len and nread
+ */
+extern void libti2cit_s_isr_send(libti2cit_int_st * st);
+
+/* libti2cit_s_isr_recv(): the slave stores what the master writes in buf using the RX FIFO
+ *   you MUST fill in base, len, buf, and user_cb in libti2cit_int_st
+ *
+ * the FIFO is drained from libti2cit_s_isr_isr() when it fills up (I2C_SIMR_RXIM, turned on and off by libti2cit)
+ *   and at the i2c STOP. Same interrupt requirements as libti2cit_s_isr_send(), and the RX FIFO belongs to the slave
+ *   once buf is full the rest is NACKed
+ *
+ * the next i2c STOP ends it: user_cb(status = I2C_SIMR_STOPIM) is called with nread = the number of bytes in buf
+ */
+extern void libti2cit_s_isr_recv(libti2cit_int_st * st);
+
+/* libti2cit_s_isrdma_send(), libti2cit_s_isrdma_recv(): same as libti2cit_s_isr_send() and libti2cit_s_isr_recv(),
+ * but the uDMA moves the bytes: no interrupts at all until the i2c STOP
+ *   you MUST also fill in dma_tx (send) or dma_rx (recv), and set up the uDMA as for libti2cit_m_isrdma_send()
+ *   len is at most 1024, the size of one uDMA basic mode transfer
+ *   buf MUST stay valid until user_cb is called
+ *   libti2cit turns I2C_SIMR_DMATXIM and I2C_SIMR_DMARXIM on and off itself
+ *
+ * nread is worked out from what the uDMA has left when the STOP arrives
+ */
+extern void libti2cit_s_isrdma_send(libti2cit_int_st * st);
+extern void libti2cit_s_isrdma_recv(libti2cit_int_st * st);
+
+
+
+
+
+
+/* libti2cit_prof_...(): cycle counts of every libti2cit call, for sizing your interrupt budget
+ * compile libti2cit.c with -DLIBTI2CIT_PROF to turn this on. Without it the calls below still link but
+ * libti2cit_prof_get() returns 0, and libti2cit costs nothing extra
+ *
+ * each public function and each step of the libti2cit_m_isr_isr() state machine is timed with the Cortex-M4
+ * DWT CYCCNT from entry to return (that includes your user_cb when libti2cit calls it). The time of call n goes in
+ * bin[k] where 2^k <= cycles < 2^(k+1); bin[0] also counts 0 cycles and bin[LIBTI2CIT_PROF_NBIN - 1] counts anything
+ * longer. A libti2cit function called by another one, e.g. libti2cit_m_isr_isr() from libti2cit_mgr_isr(), is
+ * only counted in the outer one. Each measurement includes a few cycles for reading CYCCNT
+ *
+ * every function in this file is timed except libti2cit_prof_...() and libti2cit_trace_...() themselves; that
+ * includes the setup calls (libti2cit_m_speed(), libti2cit_mgr_init(), ...), which run once and are cheap to count
+ * adding a function: its #define and #undef at the top and bottom of libti2cit.c, its LIBTI2CIT_PROF_... below, its
+ * name in libti2cit_prof_names[] and its wrapper. The names are checked against LIBTI2CIT_PROF_N when libti2cit.c
+ * compiles, and make sim-prof checks that every extern function here has a name
+ *
+ * call libti2cit_prof_clear() once at startup: it also turns on CYCCNT if the debugger has not
+ * an interrupt can update a libti2cit_prof_st while you read it; copy it with interrupts disabled if that matters
+ */
+enum {
+	LIBTI2CIT_PROF_M_SYNC_SEND = 0,
+	LIBTI2CIT_PROF_M_SYNC_RECV,
+	LIBTI2CIT_PROF_M_SYNC_RECVPART,
+	LIBTI2CIT_PROF_M_SYNC_SEND_TO,
+	LIBTI2CIT_PROF_M_SYNC_RECV_TO,
+	LIBTI2CIT_PROF_M_SYNC_RECVPART_TO,
+	LIBTI2CIT_PROF_M_INT_CLEAR,
+	LIBTI2CIT_PROF_M_ISR_ISR,
+	LIBTI2CIT_PROF_M_ISR_NOFIFO_SEND,
+	LIBTI2CIT_PROF_M_ISR_NOFIFO_RECV,
+	LIBTI2CIT_PROF_M_ISR_NOFIFO_RECVPART,
+	LIBTI2CIT_PROF_M_ISR_SEND,
+	LIBTI2CIT_PROF_M_ISR_RECV,
+	LIBTI2CIT_PROF_M_ISR_RECVPART,
+	LIBTI2CIT_PROF_M_ISRDMA_SEND,
+	LIBTI2CIT_PROF_M_ISRDMA_RECV,
+	LIBTI2CIT_PROF_M_ISRDMA_RECVPART,
+	LIBTI2CIT_PROF_M_ISR_QUEUE,
+	LIBTI2CIT_PROF_M_SCAN,
+	LIBTI2CIT_PROF_MGR_SUBMIT,
+	LIBTI2CIT_PROF_MGR_ISR,
+	LIBTI2CIT_PROF_M_RECOVER,
+	LIBTI2CIT_PROF_S_INT_CLEAR,
+	LIBTI2CIT_PROF_S_ISR_ISR,
+	LIBTI2CIT_PROF_S_ISR_SEND,
+	LIBTI2CIT_PROF_S_ISR_RECV,
+	LIBTI2CIT_PROF_S_ISRDMA_SEND,
+	LIBTI2CIT_PROF_S_ISRDMA_RECV,
+	LIBTI2CIT_PROF_M_SYNC_HS,
+	LIBTI2CIT_PROF_M_SYNC_HS_TO,
+	LIBTI2CIT_PROF_M_SYNC_SEND_PEC,
+	LIBTI2CIT_PROF_M_SYNC_RECV_PEC,
+	LIBTI2CIT_PROF_M_SYNC_RECVPART_PEC,
+	LIBTI2CIT_PROF_NVM_SYNC_READ,
+	LIBTI2CIT_PROF_NVM_SYNC_WRITE,
+	LIBTI2CIT_PROF_NVM_SYNC_WAIT,
+	LIBTI2CIT_PROF_NVM_ISR_READ,
+	LIBTI2CIT_PROF_NVM_ISR_WRITE,
+	LIBTI2CIT_PROF_NVM_ISR_WAIT,
+	LIBTI2CIT_PROF_SCHED_TICK,
+	LIBTI2CIT_PROF_PT_XFER,
+	LIBTI2CIT_PROF_PT_TICK,
+	LIBTI2CIT_PROF_PT_RESUME,
+	LIBTI2CIT_PROF_M_SYNCFIFO_SEND,
+	LIBTI2CIT_PROF_M_SYNCFIFO_RECV,
+	LIBTI2CIT_PROF_M_SYNCWFI_SEND,
+	LIBTI2CIT_PROF_M_SYNCWFI_RECV,
+	LIBTI2CIT_PROF_M_SYNCWFI_RECVPART,
+	LIBTI2CIT_PROF_M_SPEED,
+	LIBTI2CIT_PROF_M_SPEED_TABLE,
+	LIBTI2CIT_PROF_MGR_INIT,
+	LIBTI2CIT_PROF_MGR_UTIL,
+	LIBTI2CIT_PROF_MGR_UTIL_CLEAR,
+	LIBTI2CIT_PROF_SCHED_START,
+	LIBTI2CIT_PROF_PT_START,
+	LIBTI2CIT_PROF_M_SYNCWFI_METER,
+	LIBTI2CIT_PROF_M_SYNCWFI_SLEPT,
+	LIBTI2CIT_PROF_M_STATE,	// LIBTI2CIT_PROF_M_STATE + n: state n of libti2cit_m_isr_isr(), see libti2cit_prof_name()
+	LIBTI2CIT_PROF_N = LIBTI2CIT_PROF_M_STATE + 13
+};
+#define LIBTI2CIT_PROF_NBIN (24)	// 2^24 cycles is 140 ms at 120 MHz
+
+typedef struct libti2cit_prof_st_ {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint32_t bin[LIBTI2CIT_PROF_NBIN];
+} libti2cit_prof_st;
+
+/* returns the counts for id (LIBTI2CIT_PROF_...), or 0 if id is out of range or libti2cit.c was built without LIBTI2CIT_PROF */
+extern const libti2cit_prof_st * libti2cit_prof_get(uint32_t id);
+/* returns the name of id, e.g. "m_isr_isr" or "m_isr_state FIFO_SEND", or 0 if id is out of range */
+extern const char * libti2cit_prof_name(uint32_t id);
+extern void libti2cit_prof_clear(void);
+
+/* libti2cit_trace: a ring of the last LIBTI2CIT_TRACE_LEN i2c events, cheap enough to leave on in production
+ * an event costs one DWT CYCCNT read and a dozen instructions. Compile libti2cit.c with -DLIBTI2CIT_NO_TRACE to
+ * leave it out: libti2cit_trace_get() then returns 0 and libti2cit_trace does not exist
+ *
+ * the ring is the global libti2cit_trace so it can be saved without any code on the target, e.g. from gdb:
+ *   dump binary value trace.bin libti2cit_trace
+ * then `make trace` builds tools/ti2cit-trace, which prints the file as a timeline of transactions. The tool also
+ * finds libti2cit_trace in a dump of all of RAM by LIBTI2CIT_TRACE_MAGIC
+ *
+ * what         status                                    count
+ * M_START      st->len                                   st->nread (0, or 1 for a recv after a repeated start)
+ * M_ISR        I2C_O_MMIS                                st->nread
+ * M_DONE       the status libti2cit passes to user_cb    st->nread
+ * S_START      st->len                                   st->nread
+ * S_ISR        (I2C_O_SMIS << 16) | SCSR bits returned   st->nread
+ * state is st->private_state after the event, except M_ISR and S_ISR which have it from before the interrupt
+ * base is bits 19:12 of st->base: 0x20 is I2C0_BASE ... 0x23 is I2C3_BASE, 0xc0 is I2C4_BASE, 0xb9 is I2C9_BASE
+ *
+ * call libti2cit_trace_stop() from your fault handler (or anywhere) to keep the events that led up to a failure
+ * call libti2cit_trace_clear() once at startup: it also turns on CYCCNT if the debugger has not
+ * an interrupt can add an event while you read the ring; the event at head - 1 may be half written
+ */
+#ifndef LIBTI2CIT_TRACE_LEN
+#define LIBTI2CIT_TRACE_LEN (64)	// a power of 2: 64 events is 1 KB of RAM
+#endif
+#define LIBTI2CIT_TRACE_MAGIC (0x74693274)	// "t2it" in a little-endian dump
+enum {
+	LIBTI2CIT_TRACE_M_START = 1,
+	LIBTI2CIT_TRACE_M_ISR,
+	LIBTI2CIT_TRACE_M_DONE,
+	LIBTI2CIT_TRACE_S_START,
+	LIBTI2CIT_TRACE_S_ISR,
+};
+
+typedef struct libti2cit_trace_ev_ {
+	uint32_t cyccnt;
+	uint8_t what;
+	uint8_t base;
+	uint8_t state;
+	uint8_t addr;
+	uint32_t status;
+	uint32_t count;
+} libti2cit_trace_ev;
+
+/* head counts every event ever added: the newest one is ev[(head - 1) % len] */
+typedef struct libti2cit_trace_st_ {
+	uint32_t magic;
+	uint32_t len;
+	volatile uint32_t head;
+	volatile uint32_t stop;
+	libti2cit_trace_ev ev[LIBTI2CIT_TRACE_LEN];
+} libti2cit_trace_st;
+
+extern libti2cit_trace_st libti2cit_trace;
+
+/* returns &libti2cit_trace, or 0 if libti2cit.c was built with LIBTI2CIT_NO_TRACE */
+extern const libti2cit_trace_st * libti2cit_trace_get(void);
+/* empty the ring and start recording */
+extern void libti2cit_trace_clear(void);
+/* stop recording: the ring keeps what it has until libti2cit_trace_clear() */
+extern void libti2cit_trace_stop(void);
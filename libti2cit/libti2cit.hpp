@@ -0,0 +1,207 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ *
+ * libti2cit.hpp: the same i2c engine for C++, with the controller base fixed at compile time.
+ * Header only: include it instead of libti2cit.h and link libti2cit.c (built as C) as usual.
+ *
+ * ti2cit::Master<I2C2_BASE>::sync_send() and friends are libti2cit_m_sync_send() and friends for one controller:
+ *   every register address is a constexpr, so each access is one load or store to a constant address
+ *   the functions are inlined down to the register accesses, where libti2cit.c is called with base and
+ *     goes through libti2cit_m_continue() and libti2cit_mris_wait() (with its timeout check) for each byte
+ *   the return codes and the i2c sequences are exactly those of the C functions. You can mix them on the same
+ *     controller: e.g. Master<I2C2_BASE>::sync_send(addr | 1, ...) then libti2cit_m_sync_recvpart(I2C2_BASE, ...)
+ *   they wait forever, do not send a High-Speed master code, do no SMBus PEC and do not look at the
+ *     libti2cit_m_speed_table(): use the libti2cit_m_sync_..._to() and libti2cit_m_sync_..._pec() functions for that
+ *
+ * the interrupt engines stay in libti2cit.c and keep using libti2cit_int_st. Master<>::attach() ties one
+ * libti2cit_int_st to the controller and Master<>::isr() is an interrupt handler for it, one function per
+ * controller, that you put straight in the vector table:
+ *
+ *   static libti2cit_int_st i2c2;
+ *   typedef ti2cit::Master<I2C2_BASE> m2;	// startup_gcc.c: m2::isr for the I2C2 vector
+ *   m2::attach(&i2c2);		// sets i2c2.base
+ *   i2c2.addr = ...; i2c2.user_cb = ...;
+ *   libti2cit_m_isr_send(&i2c2);
+ *
+ * ti2cit::Slave<I2C2_BASE> is the same for the on-chip slave: attach(), isr() calling libti2cit_s_isr_isr(), and
+ * the I2C_O_SCSR / I2C_O_SDR accesses your handler does when st->regs is not used
+ *
+ * make sim-hpp runs sim/sim-bench-hpp.cpp: it checks that Master<> returns and moves the same as the C sync
+ * functions. It does not measure what the template saves: the model only charges the register accesses, which are
+ * the same in both
+ */
+#ifndef LIBTI2CIT_HPP
+#define LIBTI2CIT_HPP
+
+#include <stdbool.h>
+#include <stdint.h>
+extern "C" {
+#include "libti2cit.h"
+}
+#include "inc/hw_types.h"
+#include "inc/hw_i2c.h"
+#include "driverlib/i2c.h"
+
+#define LIBTI2CIT_INLINE inline __attribute__((always_inline))
+
+namespace ti2cit {
+
+template <uint32_t Base> struct Master {
+	static constexpr uint32_t base = Base;
+	static constexpr uint32_t msa = Base + I2C_O_MSA;
+	static constexpr uint32_t mcs = Base + I2C_O_MCS;
+	static constexpr uint32_t mdr = Base + I2C_O_MDR;
+	static constexpr uint32_t mimr = Base + I2C_O_MIMR;
+	static constexpr uint32_t mris = Base + I2C_O_MRIS;
+	static constexpr uint32_t micr = Base + I2C_O_MICR;
+
+	/* write cmd to I2C_O_MCS and wait for I2C_MRIS_RIS, as libti2cit_m_continue() does
+	 * returns I2C_O_MRIS
+	 */
+	static LIBTI2CIT_INLINE uint32_t go(uint32_t cmd, uint32_t want) {
+		HWREG(mcs) = cmd;	// a.k.a. ROM_I2CMasterControl()
+		uint32_t r;
+		while (((r = HWREG(mris)) & want) != want);
+		HWREG(micr) = r;
+		return r;
+	}
+
+	/* wait for I2C_MRIS_STOPRIS and I2C_MRIS_RIS to clear after an i2c STOP */
+	static LIBTI2CIT_INLINE void stop_wait() {
+		while (HWREG(mris) & (I2C_MRIS_STOPRIS | I2C_MRIS_RIS));
+	}
+
+	/* libti2cit_m_sync_send() for this controller: same arguments (without base), same return values */
+	static uint8_t sync_send(uint8_t addr, uint32_t len, const uint8_t * buf) {
+		uint32_t cmd = I2C_MASTER_CMD_QUICK_COMMAND;
+		uint32_t want = I2C_MRIS_RIS | I2C_MRIS_STOPRIS;	// quick command: wait for the i2c STOP too
+		HWREG(micr) = I2C_MRIS_RIS | I2C_MRIS_NACKRIS;
+		if (len) {
+			cmd = I2C_MASTER_CMD_BURST_SEND_START;
+			want = I2C_MRIS_RIS;
+			if (buf) HWREG(mdr) = *(buf++);	// a.k.a. ROM_I2CMasterDataPut()
+		} else if (addr & 1) {
+			cmd = I2C_MASTER_CMD_BURST_RECEIVE_START;
+			HWREG(mimr) |= I2C_MIMR_STARTIM;	// the repeated start flag of libti2cit_m_sync_recvpart()
+			want = I2C_MRIS_RIS;
+		}
+		HWREG(msa) = len ? addr & ~1 : addr;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
+		uint32_t r = go(cmd, want);
+		if (r & I2C_MRIS_NACKRIS) return 1;
+		if (HWREG(mcs) & I2C_MCS_ARBLST) return 2;
+		if (!len) return 0;
+
+		len--;	// first byte was already sent
+		while (len) {
+			HWREG(mdr) = *(buf++);	// a.k.a. ROM_I2CMasterDataPut()
+			r = go((--len | (addr & 1)) ? I2C_MASTER_CMD_BURST_SEND_CONT : I2C_MASTER_CMD_BURST_SEND_FINISH,
+				I2C_MRIS_RIS);
+			if (r & I2C_MRIS_NACKRIS) return (len < LIBTI2CIT_PEC_ERROR - 3) ? 3 + len : LIBTI2CIT_PEC_ERROR - 1;
+			if (HWREG(mcs) & I2C_MCS_ARBLST) return 2;
+		}
+		if (addr & 1) {
+			// the tiva hardware wants a receive command for the repeated start, see libti2cit_m_sync_send_pec()
+			HWREG(mimr) |= I2C_MIMR_STARTIM;
+			HWREG(msa) = addr;	// a.k.a. ROM_I2CMasterSlaveAddrSet()
+			r = go(I2C_MASTER_CMD_BURST_RECEIVE_START, I2C_MRIS_RIS);
+			if (r & I2C_MRIS_NACKRIS) return 1;
+			if (HWREG(mcs) & I2C_MCS_ARBLST) return 2;
+			return 0;
+		}
+		stop_wait();
+		return 0;
+	}
+
+	/* libti2cit_m_sync_recv() for this controller */
+	static uint8_t sync_recv(uint32_t len, uint8_t * buf) {
+		HWREG(mimr) &= ~I2C_MIMR_STARTIM;
+		if (!len) {
+			HWREG(mcs) = I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP;	// a.k.a. ROM_I2CMasterControl()
+			return 1;
+		}
+		while (*(buf++) = HWREG(mdr) /* a.k.a. ROM_I2CMasterDataGet() */, --len) {
+			go(I2C_MASTER_CMD_BURST_RECEIVE_CONT, I2C_MRIS_RIS);
+		}
+		go(I2C_MASTER_CMD_BURST_RECEIVE_FINISH, I2C_MRIS_RIS);	// one more byte, not stored
+		stop_wait();
+		return 0;
+	}
+
+	/* libti2cit_m_sync_recvpart() for this controller */
+	static uint8_t sync_recvpart(uint32_t len, uint8_t * buf) {
+		uint32_t m = HWREG(mimr);
+		if (m & I2C_MIMR_STARTIM) {
+			HWREG(mimr) = m & ~I2C_MIMR_STARTIM;
+			if (!len) {
+				HWREG(mcs) = I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP;	// a.k.a. ROM_I2CMasterControl()
+				return 1;
+			}
+			*(buf++) = HWREG(mdr);	// a.k.a. ROM_I2CMasterDataGet()
+			len--;
+		} else if (!len) {
+			go(I2C_MASTER_CMD_BURST_RECEIVE_FINISH, I2C_MRIS_RIS);
+			stop_wait();
+			return 0;
+		}
+		while (len--) {
+			go(I2C_MASTER_CMD_BURST_RECEIVE_CONT, I2C_MRIS_RIS);
+			*(buf++) = HWREG(mdr);	// a.k.a. ROM_I2CMasterDataGet()
+		}
+		return 0;
+	}
+
+	/* the libti2cit_int_st of this controller for isr(): sets st->base */
+	static void attach(libti2cit_int_st * st) {
+		st->base = Base;
+		st_ = st;
+	}
+
+	/* interrupt handler for the vector table, calls libti2cit_m_isr_isr() with the attach()ed libti2cit_int_st */
+	static void isr() {
+		libti2cit_m_isr_isr(st_);
+	}
+
+	static libti2cit_int_st * st_;
+};
+
+template <uint32_t Base> libti2cit_int_st * Master<Base>::st_;
+
+template <uint32_t Base> struct Slave {
+	static constexpr uint32_t base = Base;
+	static constexpr uint32_t soar = Base + I2C_O_SOAR;
+	static constexpr uint32_t scsr = Base + I2C_O_SCSR;
+	static constexpr uint32_t sdr = Base + I2C_O_SDR;
+
+	/* set the slave address (7 bit), a.k.a. ROM_I2CSlaveAddressSet(base, 0, addr) */
+	static LIBTI2CIT_INLINE void address(uint8_t addr) {
+		HWREG(soar) = addr;
+	}
+	/* I2C_O_SCSR: I2C_SCSR_RREQ, I2C_SCSR_TREQ, ... */
+	static LIBTI2CIT_INLINE uint32_t status() {
+		return HWREG(scsr);	// a.k.a. ROM_I2CSlaveStatus()
+	}
+	static LIBTI2CIT_INLINE uint8_t get() {
+		return HWREG(sdr);	// a.k.a. ROM_I2CSlaveDataGet()
+	}
+	static LIBTI2CIT_INLINE void put(uint8_t b) {
+		HWREG(sdr) = b;	// a.k.a. ROM_I2CSlaveDataPut()
+	}
+
+	/* the libti2cit_int_st of the slave for isr(): sets st->base */
+	static void attach(libti2cit_int_st * st) {
+		st->base = Base;
+		st_ = st;
+	}
+
+	/* interrupt handler for the vector table, calls libti2cit_s_isr_isr() with the attach()ed libti2cit_int_st */
+	static void isr() {
+		libti2cit_s_isr_isr(st_);
+	}
+
+	static libti2cit_int_st * st_;
+};
+
+template <uint32_t Base> libti2cit_int_st * Slave<Base>::st_;
+
+}	// namespace ti2cit
+
+#endif /* LIBTI2CIT_HPP */
@@ -0,0 +1,16 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware driverlib/cpu.h
+ * PRIMASK holds off the sim_ctl_attach() isr, and CPUwfi() sleeps until an enabled controller interrupt is pending
+ */
+#ifndef __DRIVERLIB_CPU_H__
+#define __DRIVERLIB_CPU_H__
+
+#include "ti2cit-sim.h"
+
+#define CPUcpsid()	sim_cpu_cpsid()
+#define CPUcpsie()	sim_cpu_cpsie()
+#define CPUwfi()	sim_cpu_wfi()
+
+#endif /* __DRIVERLIB_CPU_H__ */
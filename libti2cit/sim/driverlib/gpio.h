@@ -0,0 +1,18 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware driverlib/gpio.h
+ */
+#ifndef __DRIVERLIB_GPIO_H__
+#define __DRIVERLIB_GPIO_H__
+
+#define GPIO_PIN_0		0x00000001
+#define GPIO_PIN_1		0x00000002
+#define GPIO_PIN_2		0x00000004
+#define GPIO_PIN_3		0x00000008
+#define GPIO_PIN_4		0x00000010
+#define GPIO_PIN_5		0x00000020
+#define GPIO_PIN_6		0x00000040
+#define GPIO_PIN_7		0x00000080
+
+#endif /* __DRIVERLIB_GPIO_H__ */
@@ -0,0 +1,34 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware driverlib/i2c.h
+ * only the I2CMasterControl() command values are needed by libti2cit
+ */
+#ifndef __DRIVERLIB_I2C_H__
+#define __DRIVERLIB_I2C_H__
+
+#define I2C_MASTER_CMD_SINGLE_SEND		0x00000007
+#define I2C_MASTER_CMD_SINGLE_RECEIVE		0x00000007
+#define I2C_MASTER_CMD_BURST_SEND_START		0x00000003
+#define I2C_MASTER_CMD_BURST_SEND_CONT		0x00000001
+#define I2C_MASTER_CMD_BURST_SEND_FINISH	0x00000005
+#define I2C_MASTER_CMD_BURST_SEND_STOP		0x00000004
+#define I2C_MASTER_CMD_BURST_SEND_ERROR_STOP	0x00000004
+#define I2C_MASTER_CMD_BURST_RECEIVE_START	0x0000000b
+#define I2C_MASTER_CMD_BURST_RECEIVE_CONT	0x00000009
+#define I2C_MASTER_CMD_BURST_RECEIVE_FINISH	0x00000005
+#define I2C_MASTER_CMD_BURST_RECEIVE_ERROR_STOP	0x00000004
+#define I2C_MASTER_CMD_QUICK_COMMAND		0x00000027
+#define I2C_MASTER_CMD_HS_MASTER_CODE_SEND	0x00000013
+#define I2C_MASTER_CMD_FIFO_SINGLE_SEND		0x00000046
+#define I2C_MASTER_CMD_FIFO_SINGLE_RECEIVE	0x00000046
+#define I2C_MASTER_CMD_FIFO_BURST_SEND_START	0x00000042
+#define I2C_MASTER_CMD_FIFO_BURST_SEND_CONT	0x00000040
+#define I2C_MASTER_CMD_FIFO_BURST_SEND_FINISH	0x00000044
+#define I2C_MASTER_CMD_FIFO_BURST_SEND_ERROR_STOP	0x00000044
+#define I2C_MASTER_CMD_FIFO_BURST_RECEIVE_START	0x0000004a
+#define I2C_MASTER_CMD_FIFO_BURST_RECEIVE_CONT	0x00000048
+#define I2C_MASTER_CMD_FIFO_BURST_RECEIVE_FINISH	0x00000044
+#define I2C_MASTER_CMD_FIFO_BURST_RECEIVE_ERROR_STOP	0x00000044
+
+#endif /* __DRIVERLIB_I2C_H__ */
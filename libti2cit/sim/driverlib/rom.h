@@ -0,0 +1,24 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware driverlib/rom.h
+ * the ROM_ functions libti2cit calls are routed to the register model, and charged the cost of a ROM call
+ */
+#ifndef __DRIVERLIB_ROM_H__
+#define __DRIVERLIB_ROM_H__
+
+#include "ti2cit-sim.h"
+
+#define ROM_I2CMasterControl(base, cmd)	sim_rom_I2CMasterControl(base, cmd)
+#define ROM_I2CMasterBusy(base)		sim_rom_I2CMasterBusy(base)
+
+#define ROM_uDMAChannelControlSet(ch, ctl)	sim_rom_uDMAChannelControlSet(ch, ctl)
+#define ROM_uDMAChannelTransferSet(ch, mode, src, dst, n)	sim_rom_uDMAChannelTransferSet(ch, mode, src, dst, n)
+#define ROM_uDMAChannelEnable(ch)	sim_rom_uDMAChannelEnable(ch)
+#define ROM_uDMAChannelDisable(ch)	sim_rom_uDMAChannelDisable(ch)
+#define ROM_uDMAChannelModeGet(ch)	sim_rom_uDMAChannelModeGet(ch)
+#define ROM_uDMAChannelSizeGet(ch)	sim_rom_uDMAChannelSizeGet(ch)
+
+#define ROM_SysCtlDelay(n)		sim_rom_SysCtlDelay(n)
+
+#endif /* __DRIVERLIB_ROM_H__ */
@@ -0,0 +1,24 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware driverlib/udma.h
+ * only the constants libti2cit uses, with the same values as tivaware
+ */
+#ifndef __DRIVERLIB_UDMA_H__
+#define __DRIVERLIB_UDMA_H__
+
+#define UDMA_PRI_SELECT		0x00000000
+#define UDMA_ALT_SELECT		0x00000020
+
+#define UDMA_MODE_STOP		0x00000000
+#define UDMA_MODE_BASIC		0x00000001
+
+#define UDMA_DST_INC_8		0x00000000
+#define UDMA_DST_INC_NONE	0xc0000000
+#define UDMA_SRC_INC_8		0x00000000
+#define UDMA_SRC_INC_NONE	0x0c000000
+#define UDMA_SIZE_8		0x00000000
+#define UDMA_ARB_1		0x00000000
+#define UDMA_ARB_4		0x00008000
+
+#endif /* __DRIVERLIB_UDMA_H__ */
@@ -0,0 +1,16 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware inc/hw_gpio.h (only the registers libti2cit uses)
+ */
+#ifndef __HW_GPIO_H__
+#define __HW_GPIO_H__
+
+#define GPIO_O_DATA		0x00000000	// GPIO Data, address bits 9:2 mask the pins
+#define GPIO_O_DIR		0x00000400	// GPIO Direction
+#define GPIO_O_AFSEL		0x00000420	// GPIO Alternate Function Select
+#define GPIO_O_ODR		0x0000050C	// GPIO Open Drain Select
+#define GPIO_O_PUR		0x00000510	// GPIO Pull-Up Select
+#define GPIO_O_DEN		0x0000051C	// GPIO Digital Enable
+
+#endif /* __HW_GPIO_H__ */
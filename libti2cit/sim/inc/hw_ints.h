@@ -0,0 +1,20 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware inc/hw_ints.h (TM4C129 vector numbers)
+ */
+#ifndef __HW_INTS_H__
+#define __HW_INTS_H__
+
+#define INT_I2C0		24
+#define INT_I2C1		53
+#define INT_I2C2		77
+#define INT_I2C3		78
+#define INT_I2C4		84
+#define INT_I2C5		85
+#define INT_I2C6		118
+#define INT_I2C7		119
+#define INT_I2C8		120
+#define INT_I2C9		121
+
+#endif /* __HW_INTS_H__ */
@@ -0,0 +1,30 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware inc/hw_memmap.h (TM4C129 addresses)
+ */
+#ifndef __HW_MEMMAP_H__
+#define __HW_MEMMAP_H__
+
+#define UART0_BASE		0x4000C000
+#define I2C0_BASE		0x40020000
+#define I2C1_BASE		0x40021000
+#define I2C2_BASE		0x40022000
+#define I2C3_BASE		0x40023000
+#define I2C4_BASE		0x400C0000
+#define I2C5_BASE		0x400C1000
+#define I2C6_BASE		0x400C2000
+#define I2C7_BASE		0x400C3000
+#define I2C8_BASE		0x400B8000
+#define I2C9_BASE		0x400B9000
+#define GPIO_PORTA_BASE		0x40058000
+#define GPIO_PORTB_BASE		0x40059000
+#define GPIO_PORTD_BASE		0x4005B000
+#define GPIO_PORTG_BASE		0x4005E000
+#define GPIO_PORTK_BASE		0x40061000
+#define GPIO_PORTL_BASE		0x40062000
+#define GPIO_PORTN_BASE		0x40064000
+#define GPIO_PORTP_BASE		0x40065000
+#define UDMA_BASE		0x400FF000
+
+#endif /* __HW_MEMMAP_H__ */
@@ -0,0 +1,16 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware inc/hw_nvic.h
+ * reads of NVIC_EN0.. return the sim_ctl_irq() state, stores to the NVIC are ignored
+ */
+#ifndef __HW_NVIC_H__
+#define __HW_NVIC_H__
+
+#define NVIC_EN0		0xE000E100	// Interrupt 16-47 Set Enable
+#define NVIC_EN3		0xE000E10C	// Interrupt 112-143 Set Enable
+#define NVIC_DIS0		0xE000E180	// Interrupt 16-47 Clear Enable
+#define NVIC_PEND0		0xE000E200	// Interrupt 16-47 Set Pending
+#define NVIC_UNPEND0		0xE000E280	// Interrupt 16-47 Clear Pending
+
+#endif /* __HW_NVIC_H__ */
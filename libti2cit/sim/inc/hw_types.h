@@ -0,0 +1,16 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * libti2cit host simulator: replaces tivaware inc/hw_types.h
+ * every HWREG() access is routed through the register model in ti2cit-sim.c
+ */
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include "ti2cit-sim.h"
+
+#define HWREG(x)	(*sim_hwreg(x))
+#define HWREGH(x)	(*(volatile uint16_t *) sim_hwreg(x))
+#define HWREGB(x)	(*(volatile uint8_t *) sim_hwreg(x))
+
+#endif /* __HW_TYPES_H__ */
@@ -0,0 +1,139 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * sim-bench-hpp: ti2cit::Master<I2C2_BASE> from libti2cit.hpp next to the C libti2cit_m_sync_...() functions
+ *
+ * both write then read back a 24Cxx-style eeprom, and the data is checked. A sync call polls the whole time, so
+ * cyc/byte is mostly the bus; gap is what the cpu adds to it per byte: the cycles the transfer took minus the
+ * bit-times on the wire. The model charges each register access and ROM call (see ti2cit-sim.h), but not the
+ * instructions around them: the constant addresses and the inlining, which are what the template saves on the
+ * chip, do not show here
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "ti2cit-sim.h"
+#include "../libti2cit.hpp"
+#include "inc/hw_memmap.h"
+
+#define EEPROM_ADDR	(0x50)
+#define EEPROM_SIZE	(4096)
+#define LEN		(256)
+
+typedef ti2cit::Master<I2C2_BASE> m2;
+
+static uint8_t eeprom_mem[EEPROM_SIZE];
+static sim_eeprom eeprom;
+static sim_bus * bus;
+static uint32_t fail;
+
+static libti2cit_int_st st;
+static volatile uint32_t st_done;
+
+static void bench_cb(libti2cit_int_st *, uint32_t status)
+{
+	if (status & I2C_MIMR_STOPIM) st_done = 1;
+}
+
+static void bench_setup(uint32_t scl_hz)
+{
+	sim_reset();
+	bus = sim_bus_new(scl_hz);
+	sim_eeprom_init(&eeprom, EEPROM_ADDR, eeprom_mem, sizeof(eeprom_mem), sizeof(eeprom_mem), 2, 0);
+	sim_bus_add(bus, &eeprom.dev);
+	sim_ctl_attach(I2C2_BASE, bus, m2::isr);
+	libti2cit_m_speed(I2C2_BASE, SIM_SYSCLOCK, scl_hz);
+}
+
+static void bench_print(const char * name, const char * what, uint32_t scl_hz)
+{
+	sim_stats s = sim_stats_get();
+	double bit = (double) SIM_SYSCLOCK / scl_hz;
+	printf("%-12s %-5s %3u bytes @%7u Hz: %8.1f us  %7.1f cyc/byte  gap %5.1f cyc/byte  %4.2f rom/byte\n",
+		name, what, LEN, scl_hz, s.cycles * 1e6 / SIM_SYSCLOCK, (double) s.cycles / LEN,
+		(s.cycles - s.bus_bits * bit) / LEN, (double) s.romcalls / LEN);
+}
+
+/* hpp == 0: libti2cit_m_sync_...(), hpp == 1: m2::sync_...() */
+static void bench_one(int hpp, uint32_t scl_hz)
+{
+	static uint8_t wbuf[2 + LEN];
+	static uint8_t rbuf[LEN];
+	const char * name = hpp ? "Master<>" : "sync";
+	uint32_t i;
+
+	bench_setup(scl_hz);
+	memset(eeprom_mem, 0xff, sizeof(eeprom_mem));
+	for (i = 0; i < LEN; i++) wbuf[2 + i] = (uint8_t) (i * 11 + scl_hz / 100000);
+
+	sim_stats_clear();
+	uint8_t r = hpp ? m2::sync_send(EEPROM_ADDR << 1, sizeof(wbuf), wbuf) :
+		libti2cit_m_sync_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(wbuf), wbuf);
+	if (r) fail++, printf("%s: write returned %u\n", name, r);
+	bench_print(name, "write", scl_hz);
+
+	memset(rbuf, 0, sizeof(rbuf));
+	sim_stats_clear();
+	r = hpp ? m2::sync_send((EEPROM_ADDR << 1) | 1, 2, wbuf) :
+		libti2cit_m_sync_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+	r |= hpp ? m2::sync_recv(sizeof(rbuf), rbuf) : libti2cit_m_sync_recv(I2C2_BASE, sizeof(rbuf), rbuf);
+	if (r) fail++, printf("%s: read returned %u\n", name, r);
+	bench_print(name, "read", scl_hz);
+
+	if (memcmp(eeprom_mem, wbuf + 2, LEN) || memcmp(rbuf, wbuf + 2, LEN)) fail++, printf("%s: data mismatch\n", name);
+}
+
+/* the two APIs on one controller: return codes, a read split between them, and the isr through m2::isr */
+static void bench_mix(void)
+{
+	static uint8_t w[2 + 4] = { 0, 0x10, 1, 2, 3, 4 };
+	static uint8_t r[4];
+
+	bench_setup(400000);
+	uint8_t nack = m2::sync_send(0x31 << 1, 0, 0);
+	uint8_t nack_c = libti2cit_m_sync_send(I2C2_BASE, 0x31 << 1, 0, 0);
+	if (nack != 1 || nack_c != 1) fail++, printf("Master<>: address nack returned %u, C %u\n", nack, nack_c);
+
+	uint8_t ret = m2::sync_send(EEPROM_ADDR << 1, sizeof(w), w);
+	ret |= m2::sync_send((EEPROM_ADDR << 1) | 1, 2, w);
+	ret |= libti2cit_m_sync_recvpart(I2C2_BASE, 1, r);
+	ret |= m2::sync_recvpart(2, r + 1);
+	ret |= libti2cit_m_sync_recvpart(I2C2_BASE, 1, r + 3);
+	ret |= m2::sync_recvpart(0, 0);
+	if (ret || memcmp(r, w + 2, sizeof(r))) fail++, printf("Master<>: mixed recvpart failed %u\n", ret);
+
+	memset(&st, 0, sizeof(st));
+	m2::attach(&st);
+	st.addr = (EEPROM_ADDR << 1) | 1;
+	st.len = 2;
+	st.buf = w;
+	st.user_cb = bench_cb;
+	HWREG(I2C2_BASE + I2C_O_MIMR) = I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_IM;
+	st_done = 0;
+	libti2cit_m_isr_send(&st);
+	while (!st_done) sim_idle(8);
+	memset(r, 0, sizeof(r));
+	st.len = sizeof(r);
+	st.buf = r;
+	st_done = 0;
+	libti2cit_m_isr_recv(&st);
+	while (!st_done) sim_idle(8);
+	if (st.base != I2C2_BASE || memcmp(r, w + 2, sizeof(r))) fail++, printf("Master<>::isr: read failed\n");
+	printf("%-12s return codes, recvpart mixed with the C functions, libti2cit_m_isr_...() through m2::isr: %s\n",
+		"Master<>", fail ? "FAILED" : "ok");
+}
+
+int main()
+{
+	static const uint32_t speeds[] = { 100000, 400000, 1000000 };
+	uint32_t i;
+	for (i = 0; i < sizeof(speeds)/sizeof(speeds[0]); i++) {
+		bench_one(0, speeds[i]);
+		bench_one(1, speeds[i]);
+	}
+	bench_mix();
+
+	printf("\n%s\n", fail ? "FAILED" : "ok");
+	return fail ? 1 : 0;
+}
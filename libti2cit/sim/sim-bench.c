@@ -0,0 +1,1559 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * sim-bench: run libti2cit.c against the ti2cit-sim register model and print what each transfer cost
+ *
+ * every scenario writes then reads back a 24Cxx-style eeprom and checks the data, so the numbers are only printed
+ * for transfers that actually worked
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ti2cit-sim.h"
+#include "inc/hw_types.h"
+#include "inc/hw_i2c.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/i2c.h"
+#include "driverlib/rom.h"
+#include "../libti2cit.h"
+
+#define EEPROM_ADDR	(0x50)
+#define EEPROM_SIZE	(4096)
+#define EEPROM_PAGE	(EEPROM_SIZE)	// no page wrap, so long writes can be read back
+
+static uint8_t eeprom_mem[EEPROM_SIZE];
+static sim_eeprom eeprom;
+static sim_bus * bus;
+
+static libti2cit_int_st m;
+static volatile uint32_t m_status;
+static volatile uint32_t m_done;
+
+static uint32_t fail;
+static uint8_t hs_code;	// the High-Speed master code, 0 below 3.4MHz
+
+static void bench_isr(void)
+{
+	libti2cit_m_isr_isr(&m);
+}
+
+static void bench_cb(libti2cit_int_st * st, uint32_t status)
+{
+	m_status |= status;
+	if (status & I2C_MIMR_STOPIM) m_done = 1;
+}
+
+/* the engines: each one writes addr, data (a page write) then reads it back with a repeated start */
+
+typedef struct bench_engine_ {
+	const char * name;
+	void (* send)(libti2cit_int_st * st);	// 0 = use the sync functions
+	void (* recv)(libti2cit_int_st * st);
+} bench_engine;
+
+static const bench_engine engines[] = {
+	{ "sync",         0, 0 },
+	{ "isr_nofifo",   libti2cit_m_isr_nofifo_send, libti2cit_m_isr_nofifo_recv },
+	{ "isr (FIFO)",   libti2cit_m_isr_send, libti2cit_m_isr_recv },
+	{ "isrdma",       libti2cit_m_isrdma_send, libti2cit_m_isrdma_recv },
+};
+
+static void bench_setup(const bench_engine * e, uint32_t scl_hz)
+{
+	sim_reset();
+	bus = sim_bus_new(scl_hz);
+	sim_eeprom_init(&eeprom, EEPROM_ADDR, eeprom_mem, sizeof(eeprom_mem), EEPROM_PAGE, 2, 0);
+	sim_bus_add(bus, &eeprom.dev);
+	sim_ctl_attach(I2C2_BASE, bus, bench_isr);
+	uint32_t hz = libti2cit_m_speed(I2C2_BASE, SIM_SYSCLOCK, scl_hz);
+	if (hz > scl_hz || hz < scl_hz * 9 / 10) fail++, printf("libti2cit_m_speed(%u) = %u\n", scl_hz, hz);
+	hs_code = (scl_hz > 1000000) ? 0x08 : 0;
+
+	memset(&m, 0, sizeof(m));
+	m.base = I2C2_BASE;
+	m.hs = hs_code;
+	m.user_cb = bench_cb;
+	m.dma_tx = 13;	// any two channels: the model connects them through the FIFODATA address
+	m.dma_rx = 12;
+	if (e->send) HWREG(I2C2_BASE + I2C_O_MIMR) = I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_IM;	// the sync functions poll I2C_O_MRIS
+}
+
+/* wait in thread mode until user_cb has been called with I2C_MIMR_STOPIM */
+static uint32_t bench_wait(void)
+{
+	while (!m_done) sim_idle(8);
+	m_done = 0;
+	uint32_t s = m_status;
+	m_status = 0;
+	return s;
+}
+
+
+static uint32_t bench_send(const bench_engine * e, uint8_t addr, uint32_t len, uint8_t * buf)
+{
+	if (!e->send) {
+		if (hs_code && libti2cit_m_sync_hs(I2C2_BASE, hs_code)) return I2C_MIMR_NACKIM;
+		return libti2cit_m_sync_send(I2C2_BASE, addr, len, buf) ? I2C_MIMR_NACKIM : 0;
+	}
+	m.addr = addr;
+	m.len = len;
+	m.buf = buf;
+	e->send(&m);
+	if (!(addr & 1)) return bench_wait();
+
+	// repeated start: user_cb(I2C_MIMR_STOPIM) when the first byte is in MDR, but there is no i2c STOP
+	return bench_wait() & I2C_MIMR_NACKIM;
+}
+
+static uint32_t bench_recv(const bench_engine * e, uint32_t len, uint8_t * buf)
+{
+	if (!e->recv) return libti2cit_m_sync_recv(I2C2_BASE, len, buf) ? I2C_MIMR_NACKIM : 0;
+	m.len = len;
+	m.buf = buf;
+	e->recv(&m);
+	return bench_wait() & I2C_MIMR_NACKIM;
+}
+
+/* latency is the bus time seen by the caller; busy is what the transfer took from the cpu: polling in thread mode plus
+ * interrupt handlers (everything except sim_idle())
+ */
+static void bench_print(const char * what, const bench_engine * e, uint32_t len, uint32_t nisr)
+{
+	sim_stats s = sim_stats_get();
+	printf("%-12s %-6s %4u bytes: %8.1f us  busy %7llu cyc (isr %6llu)  %4u ints (lib counted %4u)  %5u polls  %4u isr regs  %4u rom  %4u stall bits  %4u dma\n",
+		e->name, what, len, s.cycles * 1e6 / SIM_SYSCLOCK, (unsigned long long) (s.cycles - s.idle_cycles),
+		(unsigned long long) s.isr_cycles, s.isrs, nisr, s.hwreg, s.hwreg_isr, s.romcalls, s.stall_bits, s.dma_bytes);
+}
+
+static void bench_one(const bench_engine * e, uint32_t scl_hz, uint32_t len)
+{
+	static uint8_t wbuf[2 + EEPROM_SIZE];
+	static uint8_t rbuf[EEPROM_SIZE + 1];
+	uint32_t i;
+
+	bench_setup(e, scl_hz);
+	memset(eeprom_mem, 0xff, sizeof(eeprom_mem));
+	wbuf[0] = 0;
+	wbuf[1] = 0;
+	for (i = 0; i < len; i++) wbuf[2 + i] = (uint8_t) (i * 7 + 3);
+
+	sim_stats_clear();
+	if (bench_send(e, EEPROM_ADDR << 1, 2 + len, wbuf) & I2C_MIMR_NACKIM) {
+		printf("%s: write NACK\n", e->name);
+		fail++;
+		return;
+	}
+	bench_print("write", e, len, m.nisr);
+
+	sim_stats_clear();
+	uint32_t nisr = 0;
+	if (bench_send(e, (EEPROM_ADDR << 1) | 1, 2, wbuf) & I2C_MIMR_NACKIM) {
+		printf("%s: read NACK\n", e->name);
+		fail++;
+		return;
+	}
+	nisr = m.nisr;
+	memset(rbuf, 0, sizeof(rbuf));
+	if (bench_recv(e, len, rbuf) & I2C_MIMR_NACKIM) {
+		printf("%s: recv NACK\n", e->name);
+		fail++;
+		return;
+	}
+	bench_print("read", e, len, nisr + m.nisr);
+
+	if (memcmp(eeprom_mem, wbuf + 2, len) || memcmp(rbuf, wbuf + 2, len)) {
+		printf("%s: data mismatch\n", e->name);
+		fail++;
+	}
+}
+
+/* read back in pieces with libti2cit_m_..._recvpart(), recvpart == 0 uses libti2cit_m_sync_recvpart() */
+static void bench_recvpart(const bench_engine * e, void (* recvpart)(libti2cit_int_st * st))
+{
+	static const uint32_t part[] = { 10, 1, 20, 0 };
+	static uint8_t rbuf[64];
+	uint8_t * p = rbuf;
+	uint32_t i;
+
+	bench_setup(e, 400000);
+	for (i = 0; i < sizeof(rbuf); i++) eeprom_mem[i] = (uint8_t) (i * 5 + 1);
+	static uint8_t wbuf[2];
+	if (bench_send(e, (EEPROM_ADDR << 1) | 1, 2, wbuf) & I2C_MIMR_NACKIM) {
+		printf("%s: recvpart NACK\n", e->name);
+		fail++;
+		return;
+	}
+	sim_stats_clear();
+	for (i = 0; i < sizeof(part)/sizeof(part[0]); i++) {
+		p += part[i];
+		if (!recvpart) {
+			if (libti2cit_m_sync_recvpart(I2C2_BASE, part[i], p - part[i])) fail++;
+			continue;
+		}
+		m.len = part[i];
+		m.buf = p - part[i];
+		recvpart(&m);
+		if (bench_wait() & I2C_MIMR_NACKIM) fail++;
+	}
+	bench_print("rdpart", e, p - rbuf, m.nisr);
+	if (memcmp(rbuf, eeprom_mem, p - rbuf)) {
+		printf("%s: recvpart data mismatch\n", e->name);
+		fail++;
+	}
+}
+
+/* what the sync engine adds to the bus time per byte: the cycles a transfer took minus its bit-times on the wire */
+static void bench_sync_gap(uint32_t scl_hz)
+{
+	static uint8_t wbuf[2 + 256];
+	static uint8_t rbuf[256];
+	const uint32_t len = sizeof(rbuf);
+	const double bit = (double) SIM_SYSCLOCK / scl_hz;
+	uint32_t i;
+
+	bench_setup(&engines[0], scl_hz);
+	for (i = 0; i < len; i++) wbuf[2 + i] = (uint8_t) (i * 13 + 1);
+	sim_stats_clear();
+	uint8_t r = libti2cit_m_sync_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(wbuf), wbuf);
+	sim_stats sw = sim_stats_get();
+	sim_stats_clear();
+	r |= libti2cit_m_sync_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+	r |= libti2cit_m_sync_recv(I2C2_BASE, len, rbuf);
+	sim_stats sr = sim_stats_get();
+	printf("%-12s gap %7u Hz: write %5.1f cyc/byte %4.2f rom/byte   read %5.1f cyc/byte %4.2f rom/byte\n",
+		engines[0].name, scl_hz, (sw.cycles - sw.bus_bits * bit) / len, (double) sw.romcalls / len,
+		(sr.cycles - sr.bus_bits * bit) / len, (double) sr.romcalls / len);
+	if (r || memcmp(rbuf, wbuf + 2, len)) fail++, printf("sync: gap data mismatch\n");
+}
+
+/* libti2cit_m_syncfifo_...() next to libti2cit_m_sync_...(): a bootloader-sized write and read back of the eeprom */
+static void bench_syncfifo(uint32_t scl_hz)
+{
+	static uint8_t wbuf[2 + EEPROM_SIZE];
+	static uint8_t rbuf[EEPROM_SIZE];
+	const uint32_t len = sizeof(rbuf);
+	const double bit = (double) SIM_SYSCLOCK / scl_hz;
+	uint32_t i, fifo;
+
+	for (fifo = 0; fifo < 2; fifo++) {
+		const char * name = fifo ? "syncfifo" : engines[0].name;
+		bench_setup(&engines[0], scl_hz);
+		memset(eeprom_mem, 0xff, sizeof(eeprom_mem));
+		for (i = 0; i < len; i++) wbuf[2 + i] = (uint8_t) (i * 3 + fifo);
+
+		sim_stats_clear();
+		uint8_t r = fifo ? libti2cit_m_syncfifo_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(wbuf), wbuf) :
+			libti2cit_m_sync_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(wbuf), wbuf);
+		sim_stats sw = sim_stats_get();
+		sim_stats_clear();
+		if (fifo) {
+			r |= libti2cit_m_syncfifo_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+			r |= libti2cit_m_syncfifo_recv(I2C2_BASE, len, rbuf);
+		} else {
+			r |= libti2cit_m_sync_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+			r |= libti2cit_m_sync_recv(I2C2_BASE, len, rbuf);
+		}
+		sim_stats sr = sim_stats_get();
+		printf("%-12s %7u Hz %4u bytes: write %8.1f us %5.1f kB/s gap %4.1f cyc/byte   "
+			"read %8.1f us %5.1f kB/s gap %4.1f cyc/byte\n", name, scl_hz, len,
+			sw.cycles * 1e6 / SIM_SYSCLOCK, len * (double) SIM_SYSCLOCK / sw.cycles / 1000,
+			(sw.cycles - sw.bus_bits * bit) / len,
+			sr.cycles * 1e6 / SIM_SYSCLOCK, len * (double) SIM_SYSCLOCK / sr.cycles / 1000,
+			(sr.cycles - sr.bus_bits * bit) / len);
+		if (r || memcmp(eeprom_mem, wbuf + 2, len) || memcmp(rbuf, wbuf + 2, len)) {
+			fail++, printf("%s: %u bytes failed %u\n", name, len, r);
+		}
+	}
+}
+
+/* a slave that NACKs data byte nack_at: libti2cit_m_syncfifo_send() must return what libti2cit_m_sync_send() does */
+static uint32_t nack_n, nack_at;
+
+static int nack_start(sim_dev * d, uint32_t rw)
+{
+	nack_n = 0;
+	return SIM_ACK;
+}
+
+static int nack_write(sim_dev * d, uint8_t data)
+{
+	return (++nack_n == nack_at) ? SIM_NACK : SIM_ACK;
+}
+
+static void bench_syncfifo_nack(void)
+{
+	static sim_dev dev;
+	static uint8_t buf[400];
+	static const uint32_t at[] = { 1, 8, 9, 255, 256, 300, 400 };
+	uint32_t i;
+
+	for (i = 0; i < sizeof(at)/sizeof(at[0]); i++) {
+		nack_at = at[i];
+		bench_setup(&engines[0], 1000000);
+		memset(&dev, 0, sizeof(dev));
+		dev.addr = 0x33;
+		dev.start = nack_start;
+		dev.write = nack_write;
+		sim_bus_add(bus, &dev);
+		uint8_t want = libti2cit_m_sync_send(I2C2_BASE, 0x33 << 1, sizeof(buf), buf);
+		bench_setup(&engines[0], 1000000);
+		sim_bus_add(bus, &dev);
+		uint8_t got = libti2cit_m_syncfifo_send(I2C2_BASE, 0x33 << 1, sizeof(buf), buf);
+		if (got != want) fail++, printf("syncfifo: NACK of byte %u returned %u, sync %u\n", nack_at, got, want);
+	}
+	bench_setup(&engines[0], 1000000);
+	if (libti2cit_m_syncfifo_send(I2C2_BASE, 0x22 << 1, sizeof(buf), buf) != 1) fail++, printf("syncfifo: missing NACK\n");
+	printf("%-12s NACK: same return values as %s\n", "syncfifo", engines[0].name);
+}
+
+/* libti2cit_m_syncfifo_send() then _recv() from a High-Speed slave in a libti2cit_m_speed_table(): one lookup and
+ * one master code for the whole transaction, the repeated start must not send another
+ */
+static void bench_syncfifo_hs(void)
+{
+	static uint8_t wbuf[2 + 16] = { 0, 0x80 };
+	static uint8_t rbuf[16];
+	static libti2cit_dev_st dev[] = { { EEPROM_ADDR, 0x09, 0x40, 3400000 } };
+	static libti2cit_speed_st sp;
+	uint32_t i;
+
+	bench_setup(&engines[0], 100000);
+	memset(&sp, 0, sizeof(sp));
+	sp.sysclock = SIM_SYSCLOCK;
+	sp.dev = dev;
+	sp.ndev = sizeof(dev)/sizeof(dev[0]);
+	sp.other.scl_hz = 400000;
+	libti2cit_m_speed_table(I2C2_BASE, &sp);
+	for (i = 2; i < sizeof(wbuf); i++) eeprom_mem[0x80 + i - 2] = wbuf[i] = (uint8_t) (i * 5);
+
+	sim_stats_clear();
+	uint8_t r = libti2cit_m_syncfifo_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+	r |= libti2cit_m_syncfifo_recv(I2C2_BASE, sizeof(rbuf), rbuf);
+	sim_stats s = sim_stats_get();
+	libti2cit_m_speed_table(I2C2_BASE, 0);
+	printf("%-12s hs     %3u bytes: %8.1f us  %u master codes, %u lookups\n", "syncfifo", (unsigned) sizeof(rbuf),
+		s.cycles * 1e6 / SIM_SYSCLOCK, s.hs_codes, sp.ncheck);
+	if (r || memcmp(rbuf, wbuf + 2, sizeof(rbuf))) fail++, printf("syncfifo: hs read failed %u\n", r);
+	if (s.hs_codes != 1 || sp.ncheck != 1) fail++, printf("syncfifo: hs read sent %u master codes\n", s.hs_codes);
+}
+
+/* libti2cit_m_isr_queue(): a sensor poll of 7 transactions, two of them to an address with no device */
+static void bench_queue(void)
+{
+	static sim_hih hih;
+	static uint8_t eep_w[2 + 8] = { 0, 0x40, 1, 2, 3, 4, 5, 6, 7, 8 };
+	static uint8_t hih_r[4], eep_r[8], none_r[2];
+	static libti2cit_xfer_st xfer[] = {
+		{ 0x27 << 1, 0, 0, 0, 0 },				// HIH6130 quick command: start a measurement
+		{ EEPROM_ADDR << 1, eep_w, sizeof(eep_w), 0, 0 },	// eeprom page write
+		{ 0x30 << 1, 0, 0, 0, 0 },				// no device
+		{ EEPROM_ADDR << 1, eep_w, 2, eep_r, sizeof(eep_r) },	// eeprom read back
+		{ 0x30 << 1, 0, 0, none_r, sizeof(none_r) },		// no device
+		{ 0x27 << 1, 0, 0, hih_r, sizeof(hih_r) },		// HIH6130 read
+		{ 0x27 << 1, 0, 0, 0, 0 },
+	};
+	static const uint32_t want[] = { 0, 0, I2C_MIMR_NACKIM, 0, I2C_MIMR_NACKIM, 0, 0 };
+	uint32_t i;
+
+	bench_setup(&engines[2], 400000);
+	sim_hih_init(&hih, 0x27, 0);
+	sim_bus_add(bus, &hih.dev);
+	m.xfer = xfer;
+	m.nxfer = sizeof(xfer)/sizeof(xfer[0]);
+	sim_stats_clear();
+	libti2cit_m_isr_queue(&m);
+	uint32_t status = bench_wait();
+	uint32_t len = 0;
+	for (i = 0; i < sizeof(xfer)/sizeof(xfer[0]); i++) len += xfer[i].wlen + xfer[i].rlen;
+	bench_print("queue", &engines[2], len, m.nisr);
+
+	if (status != (I2C_MIMR_STOPIM | I2C_MIMR_NACKIM) || m.xfer) fail++, printf("queue: status %x\n", status);
+	for (i = 0; i < sizeof(xfer)/sizeof(xfer[0]); i++) {
+		if (xfer[i].status != want[i]) fail++, printf("queue: xfer[%u].status %x\n", i, xfer[i].status);
+	}
+	if (memcmp(eep_r, eep_w + 2, sizeof(eep_r)) || !(hih.reads)) fail++, printf("queue: data mismatch\n");
+}
+
+/* a slave that stretches SCL forever after its address: libti2cit_m_sync_send_to() must give up on time */
+static int stuck_write(sim_dev * d, uint8_t data)
+{
+	return SIM_STALL;
+}
+
+static void bench_timeout(void)
+{
+	static sim_dev stuck;
+	static const uint8_t buf[4];
+	const uint32_t timeout = SIM_SYSCLOCK / 1000;
+
+	bench_setup(&engines[0], 400000);
+	memset(&stuck, 0, sizeof(stuck));
+	stuck.addr = 0x31;
+	stuck.write = stuck_write;
+	sim_bus_add(bus, &stuck);
+
+	sim_stats_clear();
+	uint8_t r = libti2cit_m_sync_send_to(I2C2_BASE, 0x31 << 1, sizeof(buf), buf, timeout);
+	sim_stats s = sim_stats_get();
+	printf("%-12s stuck slave: returned %u after %.1f us (timeout %.1f us)\n", engines[0].name, r,
+		s.cycles * 1e6 / SIM_SYSCLOCK, timeout * 1e6 / SIM_SYSCLOCK);
+	if (r != LIBTI2CIT_TIMEOUT || s.cycles > timeout + timeout / 10) fail++, printf("sync: timeout failed\n");
+}
+
+/* a slave holds SDA low: the sync caller recovers by hand, the queue recovers by itself and finishes the batch
+ * then another master wins arbitration: the queue reports it and the pins are left alone
+ */
+static void bench_recover(void)
+{
+	static libti2cit_recover_st rec;
+	static uint8_t w[2 + 4] = { 0, 0x80, 9, 8, 7, 6 };
+	static uint8_t r[4];
+	static libti2cit_xfer_st xfer[] = {
+		{ EEPROM_ADDR << 1, w, sizeof(w), 0, 0 },
+		{ EEPROM_ADDR << 1, w, 2, r, sizeof(r) },
+	};
+
+	bench_setup(&engines[0], 100000);
+	memset(&rec, 0, sizeof(rec));
+	rec.gpio_base = GPIO_PORTL_BASE;
+	rec.scl = GPIO_PIN_1;
+	rec.sda = GPIO_PIN_0;
+	rec.half_bit = SIM_SYSCLOCK / 3 / (2 * 100000);
+	sim_bus_gpio(bus, rec.gpio_base, rec.scl, rec.sda);
+
+	sim_bus_wedge(bus, 5);
+	sim_stats_clear();
+	uint8_t ret = libti2cit_m_sync_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(w), w);
+	uint32_t lines = libti2cit_m_recover(I2C2_BASE, &rec);
+	if (ret != 2 || lines || libti2cit_m_sync_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(w), w)) {
+		fail++, printf("sync recover: send %u, recover %u\n", ret, lines);
+	}
+	sim_stats s = sim_stats_get();
+	printf("%-12s recover: %.1f us, %u SCL pulses\n", engines[0].name, s.cycles * 1e6 / SIM_SYSCLOCK, s.gpio_clocks);
+
+	bench_setup(&engines[2], 100000);
+	sim_bus_gpio(bus, rec.gpio_base, rec.scl, rec.sda);
+	HWREG(I2C2_BASE + I2C_O_MIMR) |= I2C_MIMR_ARBLOSTIM;
+	m.recover = &rec;
+	m.xfer = xfer;
+	m.nxfer = sizeof(xfer)/sizeof(xfer[0]);
+	rec.nrecover = 0;
+	memset(eeprom_mem, 0, sizeof(eeprom_mem));
+
+	sim_bus_wedge(bus, 9);
+	sim_stats_clear();
+	libti2cit_m_isr_queue(&m);
+	uint32_t status = bench_wait();
+	s = sim_stats_get();
+	printf("%-12s recover: %.1f us, %u SCL pulses, queue resumed: status %x nrecover %u\n", engines[2].name,
+		s.cycles * 1e6 / SIM_SYSCLOCK, s.gpio_clocks, status, rec.nrecover);
+	if (status != I2C_MIMR_STOPIM || rec.nrecover != 1 || memcmp(r, w + 2, sizeof(r))) fail++, printf("isr recover failed\n");
+
+	rec.nrecover = 0;
+	m.xfer = xfer;
+	m.nxfer = sizeof(xfer)/sizeof(xfer[0]);
+	sim_bus_rival(bus, 1);
+	sim_stats_clear();
+	libti2cit_m_isr_queue(&m);
+	while (!m_status && !m_done) sim_idle(8);	// arbitration lost: user_cb gets no I2C_MIMR_STOPIM
+	status = m_status;
+	m_status = m_done = 0;
+	s = sim_stats_get();
+	printf("%-12s arbitration lost to another master: status %x nrecover %u, %u SCL pulses\n", engines[2].name,
+		status, rec.nrecover, s.gpio_clocks);
+	if (!(status & I2C_MIMR_ARBLOSTIM) || rec.nrecover || s.gpio_clocks) fail++, printf("isr recover on a live bus\n");
+}
+
+/* libti2cit_m_scan() on I2C2 and I2C7 at the same time, each on its own bus */
+static libti2cit_int_st m7;
+static volatile uint32_t m7_done;
+
+static void bench_isr7(void)
+{
+	libti2cit_m_isr_isr(&m7);
+}
+
+static void bench_cb7(libti2cit_int_st * st, uint32_t status)
+{
+	if (status & I2C_MIMR_STOPIM) m7_done = 1;
+}
+
+static void bench_scan(void)
+{
+	static sim_hih hih;
+	static uint32_t map2[4], map7[4];
+
+	bench_setup(&engines[1], 400000);
+	sim_hih_init(&hih, 0x27, 0);
+	sim_bus * bus7 = sim_bus_new(100000);
+	sim_bus_add(bus7, &hih.dev);
+	sim_ctl_attach(I2C7_BASE, bus7, bench_isr7);
+	memset(&m7, 0, sizeof(m7));
+	m7.base = I2C7_BASE;
+	m7.user_cb = bench_cb7;
+	m7_done = 0;
+	HWREG(I2C7_BASE + I2C_O_MIMR) = I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_IM;
+
+	m.scan = map2;
+	m7.scan = map7;
+	sim_stats_clear();
+	libti2cit_m_scan(&m);
+	libti2cit_m_scan(&m7);
+	while (!m_done || !m7_done) sim_idle(8);
+	m_done = 0;
+	sim_stats s = sim_stats_get();
+	printf("%-12s scan   2 buses: %8.1f us  busy %7llu cyc (isr %6llu)  %4u ints  found %08x %08x %08x %08x / %08x %08x %08x %08x\n",
+		"isr_nofifo", s.cycles * 1e6 / SIM_SYSCLOCK, (unsigned long long) (s.cycles - s.idle_cycles),
+		(unsigned long long) s.isr_cycles, s.isrs, map2[3], map2[2], map2[1], map2[0], map7[3], map7[2], map7[1], map7[0]);
+	if (map2[0] || map2[1] || map2[2] != 1 << (EEPROM_ADDR & 31) || map2[3] ||
+		map7[0] || map7[1] != 1 << (0x27 & 31) || map7[2] || map7[3] || m.scan || m7.scan) fail++, printf("scan failed\n");
+}
+
+/* libti2cit_m_syncwfi_...() next to libti2cit_m_sync_...(): the same write and read back, where the cpu sleeps in WFI
+ * between bytes. active is the cycles the core was clocked (what the transfer costs in run-mode current), sleep the
+ * cycles it spent in WFI. Meanwhile I2C7 runs an isr transfer of its own: its handler must still be taken
+ */
+static void bench_syncwfi(uint32_t scl_hz)
+{
+	static uint8_t wbuf[2 + 256];
+	static uint8_t rbuf[256];
+	static uint8_t r7[8];
+	const uint32_t len = sizeof(rbuf);
+	uint32_t i, wfi;
+
+	for (wfi = 0; wfi < 2; wfi++) {
+		const char * name = wfi ? "syncwfi" : engines[0].name;
+		bench_setup(&engines[0], scl_hz);
+		memset(eeprom_mem, 0xff, sizeof(eeprom_mem));
+		for (i = 0; i < len; i++) wbuf[2 + i] = (uint8_t) (i * 7 + wfi);
+
+		sim_stats_clear();
+		uint8_t r = wfi ? libti2cit_m_syncwfi_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(wbuf), wbuf) :
+			libti2cit_m_sync_send(I2C2_BASE, EEPROM_ADDR << 1, sizeof(wbuf), wbuf);
+		sim_stats sw = sim_stats_get();
+		sim_stats_clear();
+		if (wfi) {
+			r |= libti2cit_m_syncwfi_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+			r |= libti2cit_m_syncwfi_recv(I2C2_BASE, len, rbuf);
+		} else {
+			r |= libti2cit_m_sync_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+			r |= libti2cit_m_sync_recv(I2C2_BASE, len, rbuf);
+		}
+		sim_stats sr = sim_stats_get();
+		printf("%-12s %7u Hz %4u bytes: write %8.1f us active %7llu sleep %7llu cyc   "
+			"read %8.1f us active %7llu sleep %7llu cyc   %5.1f active cyc/byte\n", name, scl_hz, len,
+			sw.cycles * 1e6 / SIM_SYSCLOCK, (unsigned long long) (sw.cycles - sw.sleep_cycles),
+			(unsigned long long) sw.sleep_cycles,
+			sr.cycles * 1e6 / SIM_SYSCLOCK, (unsigned long long) (sr.cycles - sr.sleep_cycles),
+			(unsigned long long) sr.sleep_cycles,
+			(double) (sw.cycles - sw.sleep_cycles + sr.cycles - sr.sleep_cycles) / (2 * len));
+		if (r || sw.isrs || sr.isrs || memcmp(eeprom_mem, wbuf + 2, len) || memcmp(rbuf, wbuf + 2, len)) {
+			fail++, printf("%s: %u bytes failed %u, %u isrs\n", name, len, r, sw.isrs + sr.isrs);
+		}
+		if (wfi && (!sw.sleep_cycles || !sr.sleep_cycles)) fail++, printf("syncwfi: never slept\n");
+	}
+
+	// libti2cit_m_syncwfi_meter() on the chip: it must see the sleep the model counts, give or take its CYCCNT reads
+	static libti2cit_wfi_st meter;
+	memset(&meter, 0, sizeof(meter));
+	libti2cit_m_syncwfi_meter(I2C2_BASE, &meter);
+	sim_stats_clear();
+	uint8_t rm = libti2cit_m_syncwfi_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+	rm |= libti2cit_m_syncwfi_recv(I2C2_BASE, len, rbuf);
+	sim_stats sm = sim_stats_get();
+	uint32_t active, slept = libti2cit_m_syncwfi_slept(I2C2_BASE, &active);
+	libti2cit_m_syncwfi_meter(I2C2_BASE, 0);
+	printf("%-12s %7u Hz meter read: active %7u sleep %7u cyc in %u WFIs (model: active %7llu sleep %7llu)\n",
+		"syncwfi", scl_hz, active, slept, meter.nwfi, (unsigned long long) (sm.cycles - sm.sleep_cycles),
+		(unsigned long long) sm.sleep_cycles);
+	if (rm || slept > sm.sleep_cycles + 4 * meter.nwfi || slept + 4 * meter.nwfi < sm.sleep_cycles ||
+			active + slept > sm.cycles || libti2cit_m_syncwfi_slept(I2C2_BASE, &active) || active) {
+		fail++, printf("syncwfi: meter counted %u sleep cycles, the model %llu\n", slept,
+			(unsigned long long) sm.sleep_cycles);
+	}
+
+	// another controller's handler runs while syncwfi sleeps, and the i2c handler of I2C2 never does
+	bench_setup(&engines[0], scl_hz);
+	static uint8_t eeprom7_mem[256];
+	static sim_eeprom eeprom7;
+	sim_bus * bus7 = sim_bus_new(100000);
+	sim_eeprom_init(&eeprom7, EEPROM_ADDR, eeprom7_mem, sizeof(eeprom7_mem), sizeof(eeprom7_mem), 1, 0);
+	for (i = 0; i < sizeof(eeprom7_mem); i++) eeprom7_mem[i] = (uint8_t) (i ^ 0x5a);
+	sim_bus_add(bus7, &eeprom7.dev);
+	sim_ctl_attach(I2C7_BASE, bus7, bench_isr7);
+	libti2cit_m_speed(I2C7_BASE, SIM_SYSCLOCK, 100000);
+	memset(&m7, 0, sizeof(m7));
+	m7.base = I2C7_BASE;
+	m7.user_cb = bench_cb7;
+	m7_done = 0;
+	HWREG(I2C7_BASE + I2C_O_MIMR) = I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_IM;
+	static uint8_t ptr7 = 0x10;
+	m7.addr = (EEPROM_ADDR << 1) | 1;
+	m7.len = 1;
+	m7.buf = &ptr7;
+	libti2cit_m_isr_nofifo_send(&m7);
+	uint8_t r = libti2cit_m_syncwfi_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+	r |= libti2cit_m_syncwfi_recvpart(I2C2_BASE, 100, rbuf);
+	while (!m7_done) sim_idle(8);
+	m7_done = 0;
+	m7.len = sizeof(r7);
+	m7.buf = r7;
+	libti2cit_m_isr_nofifo_recv(&m7);
+	r |= libti2cit_m_sync_recvpart(I2C2_BASE, 100, rbuf + 100);
+	r |= libti2cit_m_syncwfi_recvpart(I2C2_BASE, len - 200, rbuf + 200);
+	r |= libti2cit_m_syncwfi_recvpart(I2C2_BASE, 0, 0);
+	while (!m7_done) sim_idle(8);
+	for (i = 0; i < sizeof(r7); i++) if (r7[i] != (uint8_t) ((0x10 + i) ^ 0x5a)) r |= 0x80;
+	if (r || memcmp(rbuf, wbuf + 2, len)) fail++, printf("syncwfi: with I2C7 busy failed %x\n", r);
+
+	// NACKs return what the sync functions do, and without the NVIC interrupt enabled it polls
+	uint8_t nack = libti2cit_m_syncwfi_send(I2C2_BASE, 0x31 << 1, 4, wbuf);
+	nack |= libti2cit_m_syncwfi_send(I2C2_BASE, 0x31 << 1, 0, 0) << 1;
+	sim_ctl_irq(I2C2_BASE, 0);
+	sim_stats_clear();
+	r = libti2cit_m_syncwfi_send(I2C2_BASE, (EEPROM_ADDR << 1) | 1, 2, wbuf);
+	r |= libti2cit_m_syncwfi_recv(I2C2_BASE, 16, rbuf);
+	sim_stats s = sim_stats_get();
+	if (nack != 3 || r || s.sleep_cycles || memcmp(rbuf, wbuf + 2, 16)) {
+		fail++, printf("syncwfi: nack %u, NVIC off %u slept %llu\n", nack, r, (unsigned long long) s.sleep_cycles);
+	}
+}
+
+/* libti2cit_mgr_...(): the same eeprom reads on 1 bus, then spread over 6 buses */
+#define MGR_NBUS (6)
+#define MGR_NXFER (24)
+static libti2cit_mgr_st mgr;
+static volatile uint32_t mgr_ndone;
+
+#define BENCH_MGR_ISR(n) static void bench_mgr_isr##n(void) { libti2cit_mgr_isr(&mgr, n); }
+BENCH_MGR_ISR(0) BENCH_MGR_ISR(1) BENCH_MGR_ISR(2) BENCH_MGR_ISR(3) BENCH_MGR_ISR(4) BENCH_MGR_ISR(5)
+static void (* const bench_mgr_isrs[MGR_NBUS])(void) = {
+	bench_mgr_isr0, bench_mgr_isr1, bench_mgr_isr2, bench_mgr_isr3, bench_mgr_isr4, bench_mgr_isr5,
+};
+static const uint32_t mgr_bases[MGR_NBUS] = { I2C0_BASE, I2C1_BASE, I2C2_BASE, I2C3_BASE, I2C4_BASE, I2C5_BASE };
+
+static void bench_mgr_done(libti2cit_mgr_st * mgr, uint32_t id, libti2cit_xfer_st * x)
+{
+	if (x->status) fail++, printf("mgr: bus %u status %x\n", id, x->status);
+	mgr_ndone++;
+}
+
+static void bench_mgr(uint32_t nbus)
+{
+	static sim_eeprom eep[MGR_NBUS];
+	static uint8_t mem[MGR_NBUS][256];
+	static uint8_t rbuf[MGR_NXFER][16];
+	static uint8_t wbuf[2];
+	static libti2cit_xfer_st xfer[MGR_NXFER];
+	uint32_t i;
+
+	sim_reset();
+	libti2cit_mgr_init(&mgr, bench_mgr_done);
+	for (i = 0; i < nbus; i++) {
+		sim_bus * b = sim_bus_new(400000);
+		memset(mem[i], 0x5a, sizeof(mem[i]));
+		sim_eeprom_init(&eep[i], EEPROM_ADDR, mem[i], sizeof(mem[i]), EEPROM_PAGE, 2, 0);
+		sim_bus_add(b, &eep[i].dev);
+		sim_ctl_attach(mgr_bases[i], b, bench_mgr_isrs[i]);
+		HWREG(mgr_bases[i] + I2C_O_MIMR) = I2C_MIMR_NACKIM | I2C_MIMR_STOPIM | I2C_MIMR_IM;
+	}
+
+	mgr_ndone = 0;
+	memset(rbuf, 0, sizeof(rbuf));
+	sim_stats_clear();
+	libti2cit_mgr_util_clear(&mgr);
+	for (i = 0; i < MGR_NXFER; i++) {
+		libti2cit_xfer_st * x = &xfer[i];
+		x->addr = EEPROM_ADDR << 1;
+		x->wbuf = wbuf;
+		x->wlen = sizeof(wbuf);
+		x->rbuf = rbuf[i];
+		x->rlen = sizeof(rbuf[i]);
+		while (libti2cit_mgr_submit(&mgr, i % nbus, x)) sim_idle(8);	// queue full: wait
+	}
+	while (mgr_ndone < MGR_NXFER) sim_idle(8);
+
+	sim_stats s = sim_stats_get();
+	printf("%-12s mgr    %u bus%s: %8.1f us  busy %7llu cyc (isr %6llu)  %4u ints  util",
+		"isr (FIFO)", nbus, nbus > 1 ? "es" : "  ", s.cycles * 1e6 / SIM_SYSCLOCK,
+		(unsigned long long) (s.cycles - s.idle_cycles), (unsigned long long) s.isr_cycles, s.isrs);
+	for (i = 0; i < nbus; i++) printf(" %u.%u%%", libti2cit_mgr_util(&mgr, i) / 10, libti2cit_mgr_util(&mgr, i) % 10);
+	printf("\n");
+	for (i = 0; i < MGR_NXFER; i++) if (rbuf[i][0] != 0x5a || rbuf[i][15] != 0x5a) fail++, printf("mgr: data mismatch\n");
+}
+
+/* libti2cit_m_speed_table(): the eeprom only does 100kHz, a sensor does 1MHz and another one High-Speed
+ * the same poll runs with the whole bus at 100kHz, then with each transaction at the speed of its slave
+ */
+static void bench_speed(const bench_engine * e)
+{
+	static sim_hih hih, hih_hs;
+	static uint8_t eep_w[2 + 8] = { 0, 0x40, 9, 8, 7, 6, 5, 4, 3, 2 };
+	static uint8_t eep_r[8], hih_r[4], hs_r[4];
+	static libti2cit_xfer_st poll[] = {
+		{ EEPROM_ADDR << 1, eep_w, sizeof(eep_w), 0, 0 },
+		{ 0x27 << 1, 0, 0, 0, 0 },
+		{ 0x28 << 1, 0, 0, 0, 0 },
+		{ 0x27 << 1, 0, 0, hih_r, sizeof(hih_r) },
+		{ 0x28 << 1, 0, 0, hs_r, sizeof(hs_r) },
+		{ EEPROM_ADDR << 1, eep_w, 2, eep_r, sizeof(eep_r) },
+	};
+	static libti2cit_dev_st dev[] = {
+		{ EEPROM_ADDR, 0, 0, 100000 },
+		{ 0x27, 0, 0x40, 1000000 },
+		{ 0x28, 0x09, 0x40, 3400000 },
+	};
+	static libti2cit_speed_st sp;
+	uint32_t pass, i;
+
+	for (pass = 0; pass < 2; pass++) {
+		bench_setup(e, 100000);
+		sim_hih_init(&hih, 0x27, 0);
+		sim_hih_init(&hih_hs, 0x28, 0);
+		sim_bus_add(bus, &hih.dev);
+		sim_bus_add(bus, &hih_hs.dev);
+		memset(&sp, 0, sizeof(sp));
+		sp.sysclock = SIM_SYSCLOCK;
+		sp.dev = dev;
+		sp.ndev = sizeof(dev)/sizeof(dev[0]);
+		sp.other.scl_hz = 400000;
+		if (pass) libti2cit_m_speed_table(I2C2_BASE, &sp);
+		memset(eep_r, 0, sizeof(eep_r));
+
+		sim_stats_clear();
+		uint32_t status = 0, len = 0;
+		for (i = 0; i < sizeof(poll)/sizeof(poll[0]); i++) {
+			libti2cit_xfer_st * x = &poll[i];
+			len += x->wlen + x->rlen;
+			if (!x->rlen) {
+				status |= bench_send(e, x->addr, x->wlen, (uint8_t *) x->wbuf);
+				continue;
+			}
+			status |= bench_send(e, x->addr | 1, x->wlen, (uint8_t *) x->wbuf);
+			status |= bench_recv(e, x->rlen, x->rbuf);
+		}
+		sim_stats s = sim_stats_get();
+		printf("%-12s speed  %-5s %3u bytes: %8.1f us  busy %7llu cyc  %u switches in %u transactions\n",
+			e->name, pass ? "table" : "100k", len, s.cycles * 1e6 / SIM_SYSCLOCK,
+			(unsigned long long) (s.cycles - s.idle_cycles), sp.nswitch, sp.ncheck);
+		libti2cit_m_speed_table(I2C2_BASE, 0);
+
+		if ((status & I2C_MIMR_NACKIM) || memcmp(eep_r, eep_w + 2, sizeof(eep_r)) || !hih.reads || !hih_hs.reads) {
+			fail++, printf("%s: speed table data mismatch %x\n", e->name, status);
+		}
+		if (pass && (sp.nswitch != 6 || sp.ncheck != 6)) fail++, printf("%s: speed table nswitch %u\n", e->name, sp.nswitch);
+	}
+}
+
+/* an SMBus slave with Packet Error Checking: the first byte written is the register pointer
+ * a write is only stored if its PEC is right. A read returns SMB_BLOCK bytes and then the PEC (wrong if bad is set)
+ * the CRC here is the bit-at-a-time one, so it does not share a mistake with the table in libti2cit.c
+ */
+#define SMB_ADDR (0x0b)
+#define SMB_BLOCK (20)
+typedef struct bench_smb_ {
+	sim_dev dev;
+	uint8_t regs[64];
+	uint8_t pending[1 + SMB_BLOCK + 1];
+	uint32_t n;	// bytes written since the last START
+	uint32_t nrd;	// bytes read since the last START
+	uint32_t rd;	// there was a read since the last STOP
+	uint8_t crc;
+	uint8_t bad;
+	uint32_t pec_ok, pec_bad;
+} bench_smb;
+
+static uint8_t bench_crc8(uint8_t crc, uint8_t b)
+{
+	int i;
+	crc ^= b;
+	for (i = 0; i < 8; i++) crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+	return crc;
+}
+
+static int bench_smb_start(sim_dev * d, uint32_t rw)
+{
+	bench_smb * s = (bench_smb *) d;
+	s->crc = bench_crc8(s->crc, (d->addr << 1) | (rw ? 1 : 0));	// a repeated start goes into the same PEC
+	s->nrd = 0;
+	if (rw) s->rd = 1;
+	else s->n = 0;
+	return SIM_ACK;
+}
+
+static int bench_smb_write(sim_dev * d, uint8_t data)
+{
+	bench_smb * s = (bench_smb *) d;
+	s->crc = bench_crc8(s->crc, data);
+	if (s->n < sizeof(s->pending)) s->pending[s->n] = data;
+	s->n++;
+	return SIM_ACK;
+}
+
+static int bench_smb_read(sim_dev * d, uint8_t * data)
+{
+	bench_smb * s = (bench_smb *) d;
+	uint8_t v = 0xff;
+	if (s->nrd < SMB_BLOCK) v = s->regs[(s->pending[0] + s->nrd) % sizeof(s->regs)];
+	else if (s->nrd == SMB_BLOCK) v = s->crc ^ s->bad;
+	s->crc = bench_crc8(s->crc, v);
+	s->nrd++;
+	*data = v;
+	return SIM_ACK;
+}
+
+static void bench_smb_stop(sim_dev * d)
+{
+	bench_smb * s = (bench_smb *) d;
+	if (!s->rd && s->n > 2) {
+		// the CRC over everything including the PEC byte is 0 if the PEC was right
+		if (s->crc) s->pec_bad++;
+		else {
+			uint32_t i;
+			for (i = 1; i < s->n - 1 && i < sizeof(s->pending); i++) {
+				s->regs[(s->pending[0] + i - 1) % sizeof(s->regs)] = s->pending[i];
+			}
+			s->pec_ok++;
+		}
+	}
+	s->crc = 0;
+	s->rd = 0;
+}
+
+/* returns 0, I2C_MIMR_NACKIM or LIBTI2CIT_ISR_PEC */
+static uint32_t bench_pec_sync(uint8_t r)
+{
+	return !r ? 0 : (r == LIBTI2CIT_PEC_ERROR) ? LIBTI2CIT_ISR_PEC : I2C_MIMR_NACKIM;
+}
+
+/* read SMB_BLOCK bytes from register ptr: in one recv, or in two pieces and a final recvpart(0) if part is set */
+static uint32_t bench_pec_read(const bench_engine * e, void (* recvpart)(libti2cit_int_st * st), int part, uint8_t ptr,
+	uint8_t * buf)
+{
+	static const uint32_t piece[] = { 7, SMB_BLOCK - 7, 0 };
+	static uint8_t wptr;
+	uint8_t pec;
+	uint32_t i, status = 0;
+	wptr = ptr;
+	if (!e->send) {
+		status = bench_pec_sync(libti2cit_m_sync_send_pec(I2C2_BASE, (SMB_ADDR << 1) | 1, 1, &wptr, 0, &pec));
+		if (status) return status;
+		if (!part) return bench_pec_sync(libti2cit_m_sync_recv_pec(I2C2_BASE, SMB_BLOCK, buf, 0, &pec));
+		for (i = 0; i < 3; i++) {
+			status |= bench_pec_sync(libti2cit_m_sync_recvpart_pec(I2C2_BASE, piece[i], buf, 0, &pec));
+			buf += piece[i];
+		}
+		return status;
+	}
+	m.addr = (SMB_ADDR << 1) | 1;
+	m.len = 1;
+	m.buf = &wptr;
+	e->send(&m);
+	status = bench_wait() & I2C_MIMR_NACKIM;
+	if (status) return status;
+	if (!part) {
+		m.len = SMB_BLOCK;
+		m.buf = buf;
+		e->recv(&m);
+		return bench_wait() & (I2C_MIMR_NACKIM | LIBTI2CIT_ISR_PEC);
+	}
+	for (i = 0; i < 3; i++) {
+		m.len = piece[i];
+		m.buf = buf;
+		recvpart(&m);
+		status |= bench_wait() & (I2C_MIMR_NACKIM | LIBTI2CIT_ISR_PEC);
+		buf += piece[i];
+	}
+	return status;
+}
+
+/* SMBus PEC on each engine: a block write, the block read back, and a read where the slave sends a wrong PEC */
+static void bench_pec(const bench_engine * e, void (* recvpart)(libti2cit_int_st * st))
+{
+	static bench_smb smb;
+	static uint8_t w[1 + SMB_BLOCK], r[SMB_BLOCK];
+	uint32_t i, status;
+
+	bench_setup(e, 400000);
+	memset(&smb, 0, sizeof(smb));
+	smb.dev.addr = SMB_ADDR;
+	smb.dev.start = bench_smb_start;
+	smb.dev.write = bench_smb_write;
+	smb.dev.read = bench_smb_read;
+	smb.dev.stop = bench_smb_stop;
+	sim_bus_add(bus, &smb.dev);
+	m.pec = 1;
+	w[0] = 8;
+	for (i = 0; i < SMB_BLOCK; i++) w[1 + i] = (uint8_t) (i * 11 + 5);
+
+	sim_stats_clear();
+	if (!e->send) {
+		uint8_t pec;
+		status = bench_pec_sync(libti2cit_m_sync_send_pec(I2C2_BASE, SMB_ADDR << 1, sizeof(w), w, 0, &pec));
+	} else {
+		m.addr = SMB_ADDR << 1;
+		m.len = sizeof(w);
+		m.buf = w;
+		e->send(&m);
+		status = bench_wait() & (I2C_MIMR_NACKIM | LIBTI2CIT_ISR_PEC);
+	}
+	status |= bench_pec_read(e, recvpart, 0, w[0], r);
+	bench_print("pec", e, sizeof(w) + sizeof(r), m.nisr);
+	if (status || smb.pec_ok != 1 || smb.pec_bad || memcmp(r, w + 1, sizeof(r))) {
+		fail++, printf("%s: pec status %x ok %u bad %u\n", e->name, status, smb.pec_ok, smb.pec_bad);
+	}
+
+	memset(r, 0, sizeof(r));
+	status = bench_pec_read(e, recvpart, 1, w[0], r);
+	if (status || memcmp(r, w + 1, sizeof(r))) fail++, printf("%s: pec recvpart status %x\n", e->name, status);
+
+	smb.bad = 0x40;
+	status = bench_pec_read(e, recvpart, 0, w[0], r) | bench_pec_read(e, recvpart, 1, w[0], r);
+	if (status != LIBTI2CIT_ISR_PEC) fail++, printf("%s: bad pec not seen: %x\n", e->name, status);
+}
+
+/* libti2cit_nvm_...(): a 24C32 with a 5ms write cycle and the HIH6130 command mode eeprom, ACK polled (status
+ * polled for the HIH) instead of waiting the datasheet maximums like the examples used to
+ */
+#define NVM_ADDR	(0x51)
+#define NVM_PAGE	(32)
+static uint8_t nvm_mem[EEPROM_SIZE];
+static libti2cit_nvm_st nvm, nvm_hih;
+static libti2cit_nvm_st * nvm_cur;	// nvm and nvm_hih take turns: only one libti2cit_int_st may own the base at a time
+static volatile uint32_t nvm_ndone;
+static volatile uint8_t nvm_r;
+
+static void bench_nvm_isr(void)
+{
+	libti2cit_m_isr_isr(&nvm_cur->st);
+}
+
+static void bench_nvm_done(libti2cit_nvm_st * n, uint8_t r)
+{
+	nvm_r = r;
+	nvm_ndone++;
+}
+
+/* one libti2cit_nvm_sync_...() call, or the _isr_...() one and wait for done */
+static uint8_t bench_nvm_op(int isr, libti2cit_nvm_st * n, int write, uint32_t mem, uint32_t len, uint8_t * buf)
+{
+	if (!isr) return write ? libti2cit_nvm_sync_write(n, mem, len, buf) : libti2cit_nvm_sync_read(n, mem, len, buf);
+	uint32_t want = nvm_ndone + 1;
+	nvm_cur = n;
+	if (write) libti2cit_nvm_isr_write(n, mem, len, buf);
+	else libti2cit_nvm_isr_read(n, mem, len, buf);
+	while (nvm_ndone != want) sim_idle(8);
+	return nvm_r;
+}
+
+static void bench_nvm(const bench_engine * e)
+{
+	static sim_eeprom eep;
+	static sim_hih hih;
+	static uint8_t wbuf[200], rbuf[200], words[64];
+	static const uint8_t cmd_mode[] = { 0xa0, 0, 0 }, cmd_exit[] = { 0x80, 0, 0 };
+	const uint32_t mem = 0x1f0;	// 16 bytes to the end of a page, then 5 full pages and part of one more
+	int isr = e->send != 0;
+	uint32_t i;
+	uint8_t r;
+
+	bench_setup(e, 400000);
+	sim_ctl_attach(I2C2_BASE, bus, bench_nvm_isr);
+	sim_eeprom_init(&eep, NVM_ADDR, nvm_mem, sizeof(nvm_mem), NVM_PAGE, 2, SIM_SYSCLOCK / 200);
+	sim_hih_init(&hih, 0x27, 0);
+	hih.t_eep_rd = SIM_SYSCLOCK / 20000;	// 50us and 8ms: a bit quicker than the 100us and 12ms in the datasheet
+	hih.t_eep_wr = SIM_SYSCLOCK / 125;
+	for (i = 0; i < 32; i++) hih.eep[i] = 0x8100 + i * 0x0101;
+	sim_bus_add(bus, &eep.dev);
+	sim_bus_add(bus, &hih.dev);
+	memset(nvm_mem, 0xff, sizeof(nvm_mem));
+	for (i = 0; i < sizeof(wbuf); i++) wbuf[i] = i * 7 + 3;
+
+	memset(&nvm, 0, sizeof(nvm));
+	nvm.st.base = I2C2_BASE;
+	nvm.addr = NVM_ADDR;
+	nvm.type = LIBTI2CIT_NVM_24CXX;
+	nvm.addr_bytes = 2;
+	nvm.page = NVM_PAGE;
+	nvm.size = sizeof(nvm_mem);
+	nvm.timeout = SIM_SYSCLOCK / 50;
+	nvm.done = bench_nvm_done;
+	nvm_hih = nvm;
+	nvm_hih.addr = 0x27;
+	nvm_hih.type = LIBTI2CIT_NVM_HIH;
+	nvm_cur = &nvm;
+
+	// the write returns after the last page is sent, the read polls until that page is written
+	sim_stats_clear();
+	r = bench_nvm_op(isr, &nvm, 1, mem, sizeof(wbuf), wbuf);
+	r |= bench_nvm_op(isr, &nvm, 0, mem, sizeof(rbuf), rbuf);
+	sim_stats s = sim_stats_get();
+	uint32_t npages = (sizeof(wbuf) + mem % NVM_PAGE + NVM_PAGE - 1) / NVM_PAGE;
+	printf("%-12s nvm    24C32 %3u bytes: %8.1f us  busy %7llu cyc  %u page writes (%u ms of write cycle), %u polls\n",
+		e->name, (unsigned) sizeof(wbuf), s.cycles * 1e6 / SIM_SYSCLOCK, (unsigned long long) (s.cycles - s.idle_cycles),
+		npages, npages * 5, nvm.npoll);
+	if (r || memcmp(rbuf, wbuf, sizeof(wbuf)) || memcmp(nvm_mem + mem, wbuf, sizeof(wbuf))) {
+		fail++, printf("%s: nvm 24Cxx failed %u\n", e->name, r);
+	}
+
+	// the whole HIH eeprom in one call, then a write and read back of one word
+	sim_ctl_irq(I2C2_BASE, 0);	// the sync functions poll I2C_O_MRIS: keep the isr from clearing it
+	r = libti2cit_m_sync_send(I2C2_BASE, 0x27 << 1, sizeof(cmd_mode), cmd_mode);
+	sim_idle(SIM_SYSCLOCK / 10000);
+	libti2cit_m_int_clear(&nvm_hih.st);	// the sync send left I2C_O_MMIS set
+	sim_ctl_irq(I2C2_BASE, 1);
+	sim_stats_clear();
+	r |= bench_nvm_op(isr, &nvm_hih, 0, 0, sizeof(words), words);
+	s = sim_stats_get();
+	for (i = 0; i < 32; i++) if (words[2 * i] != hih.eep[i] >> 8 || words[2 * i + 1] != (hih.eep[i] & 0xff)) r |= 0x40;
+	uint32_t npoll = nvm_hih.npoll;
+	static uint8_t w1c[2] = { 0x12, 0x34 };
+	r |= bench_nvm_op(isr, &nvm_hih, 1, 0x1c * 2, 2, w1c);
+	r |= bench_nvm_op(isr, &nvm_hih, 0, 0x1c * 2, 2, words);
+	sim_ctl_irq(I2C2_BASE, 0);
+	r |= libti2cit_m_sync_send(I2C2_BASE, 0x27 << 1, sizeof(cmd_exit), cmd_exit);
+	sim_idle(SIM_SYSCLOCK / 10000);	// the sync send returns before its STOP is on the bus
+	sim_ctl_irq(I2C2_BASE, 1);
+	printf("%-12s nvm    HIH   %3u bytes: %8.1f us  busy %7llu cyc  %u status polls, then 1 word write: %u polls\n",
+		e->name, (unsigned) sizeof(words), s.cycles * 1e6 / SIM_SYSCLOCK, (unsigned long long) (s.cycles - s.idle_cycles),
+		npoll, nvm_hih.npoll - npoll);
+	if (r || hih.eep[0x1c] != 0x1234 || words[0] != 0x12 || words[1] != 0x34 || hih.cmd_mode) {
+		fail++, printf("%s: nvm HIH failed %x\n", e->name, r);
+	}
+}
+
+/* libti2cit_sched_...(): SCHED_NDEV HIH6130s on one 400kHz bus, each measured SCHED_HZ times a second
+ * the timer interrupt is modelled by calling libti2cit_sched_tick() every tick with the i2c interrupt masked, which is
+ * what equal priorities do on the NVIC
+ */
+#define SCHED_NDEV	(32)
+#define SCHED_HZ	(10)
+#define SCHED_TICK	(SIM_SYSCLOCK / 1000)	// 1ms
+#define SCHED_CONV	(SIM_SYSCLOCK / 100000 * 3665)	// 36.65ms, the typical HIH6130 measurement cycle
+static libti2cit_sched_st sched;
+static uint32_t sched_nstale;
+
+static void bench_sched_isr(void)
+{
+	libti2cit_m_isr_isr(&sched.st);
+}
+
+static uint32_t bench_sched_done(libti2cit_sched_st * s, libti2cit_sched_dev_st * d)
+{
+	if (d->measure.status || d->fetch.status) fail++, printf("sched: status %x %x\n", d->measure.status, d->fetch.status);
+	if (!(d->fetch.rbuf[0] & 0x40)) return 0;
+	sched_nstale++;
+	return 1;	// stale: try again next tick
+}
+
+static void bench_sched(void)
+{
+	static sim_hih hih[SCHED_NDEV];
+	static libti2cit_sched_dev_st dev[SCHED_NDEV];
+	static uint8_t rbuf[SCHED_NDEV][4];
+	const uint32_t nticks = 1000;
+	uint32_t i, nread = 0, nfresh = 0;
+
+	bench_setup(&engines[2], 400000);
+	sim_ctl_attach(I2C2_BASE, bus, bench_sched_isr);
+	memset(&sched, 0, sizeof(sched));
+	memset(dev, 0, sizeof(dev));
+	for (i = 0; i < SCHED_NDEV; i++) {
+		sim_hih_init(&hih[i], 0x10 + i, SCHED_CONV);
+		sim_bus_add(bus, &hih[i].dev);
+		dev[i].measure.addr = (0x10 + i) << 1;	// quick command
+		dev[i].fetch.addr = (0x10 + i) << 1;
+		dev[i].fetch.rbuf = rbuf[i];
+		dev[i].fetch.rlen = sizeof(rbuf[i]);
+		dev[i].period = 1000 / SCHED_HZ;
+		dev[i].conv = (SCHED_CONV + SCHED_TICK - 1) / SCHED_TICK;
+		dev[i].done = bench_sched_done;
+	}
+	sched.st.base = I2C2_BASE;
+	sched.dev = dev;
+	sched.ndev = SCHED_NDEV;
+	sched_nstale = 0;
+	libti2cit_sched_start(&sched);
+
+	sim_stats_clear();
+	for (i = 0; i < nticks; i++) {
+		sim_idle(SCHED_TICK);
+		sim_ctl_irq(I2C2_BASE, 0);
+		libti2cit_sched_tick(&sched);
+		sim_ctl_irq(I2C2_BASE, 1);
+	}
+	sim_stats s = sim_stats_get();
+	for (i = 0; i < SCHED_NDEV; i++) nread += dev[i].nread, nfresh += hih[i].reads;
+
+	// the delay it replaces: one sensor at a time, the cpu spinning in ROM_SysCtlDelay() through every conversion
+	double xfer_us = 15 * 1e6 / 400000;	// quick command and a 4-byte read, with START and STOP: about 15 bytes of bus time
+	printf("%-12s sched  %u HIH x %u Hz: %8.1f us  %u fresh reads/s (%u stale)  bus %.1f%%  cpu %.2f%% (isr %llu cyc, %u ints)  %u late\n",
+		"isr (FIFO)", SCHED_NDEV, SCHED_HZ, s.cycles * 1e6 / SIM_SYSCLOCK,
+		(unsigned) (nfresh * (uint64_t) SIM_SYSCLOCK / s.cycles), sched_nstale,
+		s.bus_bits * 100.0 * SIM_SYSCLOCK / 400000 / s.cycles, (s.cycles - s.idle_cycles) * 100.0 / s.cycles,
+		(unsigned long long) s.isr_cycles, s.isrs, sched.nlate);
+	printf("%-12s delay  1 HIH at a time: at most %.0f reads/s, cpu 100%%\n",
+		"isr (FIFO)", 1e6 / (SCHED_CONV * 1e6 / SIM_SYSCLOCK + xfer_us));
+	if (nread != nfresh || nfresh < SCHED_NDEV * SCHED_HZ * (nticks - 1000 / SCHED_HZ) / 1000) {
+		fail++, printf("sched: %u reads, %u fresh\n", nread, nfresh);
+	}
+}
+
+/* libti2cit_pt_...(): PT_NREAD readings of one HIH6130 (measure, sleep, fetch until it is not stale) written as a
+ * protothread, then the same conversation written as a chain of user_cb functions, to compare what they cost
+ */
+#define PT_NREAD	(10)
+#define PT_CONV		(SIM_SYSCLOCK / 1000 * 3)	// 3ms: short enough that the fetch after 2 ticks comes back stale
+typedef struct bench_pt_ {
+	libti2cit_pt_st pt;
+	uint8_t buf[4];
+	uint32_t nread;
+	uint32_t nstale;
+} bench_pt_st;
+static bench_pt_st hpt;
+
+static void bench_pt_isr(void)
+{
+	libti2cit_m_isr_isr(&hpt.pt.st);
+}
+
+static void bench_pt_fn(libti2cit_pt_st * pt)
+{
+	bench_pt_st * h = (bench_pt_st *) pt;
+	LIBTI2CIT_PT_BEGIN(pt);
+	for (h->nread = 0; h->nread < PT_NREAD; h->nread++) {
+		LIBTI2CIT_PT_XFER(pt, 0x27 << 1, 0, 0, 0, 0);
+		if (pt->status) break;
+		for (;;) {
+			LIBTI2CIT_PT_SLEEP(pt, 2);
+			LIBTI2CIT_PT_XFER(pt, 0x27 << 1, 0, 0, h->buf, sizeof(h->buf));
+			if (pt->status || !(h->buf[0] & 0x40)) break;
+			h->nstale++;
+		}
+		if (pt->status) break;
+	}
+	LIBTI2CIT_PT_END(pt);
+}
+
+/* the same with callbacks: the state lives in cb_phase, the timer tick and each user_cb pick up from it */
+static libti2cit_xfer_st cb_x;
+static uint32_t cb_phase, cb_sleep;
+static void bench_cb_fetched(libti2cit_int_st * st, uint32_t status);
+
+static void bench_cb_measure(void)
+{
+	cb_x.rbuf = 0;
+	cb_x.rlen = 0;
+	cb_phase = 1;
+	hpt.pt.st.xfer = &cb_x;
+	hpt.pt.st.nxfer = 1;
+	libti2cit_m_isr_queue(&hpt.pt.st);
+}
+
+static void bench_cb_measured(libti2cit_int_st * st, uint32_t status)
+{
+	if (cb_phase == 2) {
+		bench_cb_fetched(st, status);
+		return;
+	}
+	if (cb_x.status) {
+		hpt.pt.running = 0;
+		return;
+	}
+	cb_sleep = 2;
+}
+
+static void bench_cb_tick(void)
+{
+	if (!cb_sleep || --cb_sleep) return;
+	cb_x.rbuf = hpt.buf;
+	cb_x.rlen = sizeof(hpt.buf);
+	cb_phase = 2;
+	hpt.pt.st.xfer = &cb_x;
+	hpt.pt.st.nxfer = 1;
+	libti2cit_m_isr_queue(&hpt.pt.st);
+}
+
+static void bench_cb_fetched(libti2cit_int_st * st, uint32_t status)
+{
+	if (cb_x.status) {
+		hpt.pt.running = 0;
+		return;
+	}
+	if (hpt.buf[0] & 0x40) {
+		hpt.nstale++;
+		cb_sleep = 2;
+		return;
+	}
+	if (++hpt.nread == PT_NREAD) {
+		hpt.pt.running = 0;
+		return;
+	}
+	bench_cb_measure();
+}
+
+static void bench_pt(int cb)
+{
+	static sim_hih hih;
+	bench_setup(&engines[2], 400000);
+	sim_ctl_attach(I2C2_BASE, bus, bench_pt_isr);
+	sim_hih_init(&hih, 0x27, PT_CONV);
+	sim_bus_add(bus, &hih.dev);
+	memset(&hpt, 0, sizeof(hpt));
+	hpt.pt.st.base = I2C2_BASE;
+
+	sim_stats_clear();
+	if (cb) {
+		memset(&cb_x, 0, sizeof(cb_x));
+		cb_x.addr = 0x27 << 1;
+		cb_sleep = 0;
+		hpt.pt.running = 1;
+		hpt.pt.st.user_cb = bench_cb_measured;
+		bench_cb_measure();
+	} else {
+		libti2cit_pt_start(&hpt.pt, bench_pt_fn);
+	}
+	while (hpt.pt.running) {
+		sim_idle(SIM_SYSCLOCK / 1000);
+		sim_ctl_irq(I2C2_BASE, 0);	// a 1ms timer interrupt at the priority of the i2c interrupt
+		if (cb) bench_cb_tick();
+		else libti2cit_pt_tick(&hpt.pt);
+		sim_ctl_irq(I2C2_BASE, 1);
+	}
+	sim_stats s = sim_stats_get();
+	printf("%-12s %-6s %u HIH reads: %8.1f us  busy %7llu cyc (isr %6llu)  %4u ints  %u stale fetches\n",
+		"isr (FIFO)", cb ? "cb" : "pt", hpt.nread, s.cycles * 1e6 / SIM_SYSCLOCK,
+		(unsigned long long) (s.cycles - s.idle_cycles), (unsigned long long) s.isr_cycles, s.isrs, hpt.nstale);
+	if (hpt.nread != PT_NREAD || hih.reads != PT_NREAD || !hpt.nstale) {
+		fail++, printf("%s: %u reads, %u fresh, %u stale\n", cb ? "cb" : "pt", hpt.nread, hih.reads, hpt.nstale);
+	}
+}
+
+/* a write to an address with no device must NACK; report whether the engine also released the bus with a STOP */
+static void bench_nack(const bench_engine * e)
+{
+	static uint8_t buf[16];
+	bench_setup(e, 400000);
+	if (!e->send) {
+		if (!libti2cit_m_sync_send(I2C2_BASE, 0x22 << 1, sizeof(buf), buf)) fail++, printf("%s: missing NACK\n", e->name);
+	} else {
+		m.addr = 0x22 << 1;
+		m.len = sizeof(buf);
+		m.buf = buf;
+		e->send(&m);
+		while (!(m_status & I2C_MIMR_NACKIM)) sim_idle(8);
+	}
+	sim_idle(SIM_SYSCLOCK / 10000);	// a few bit-times for the STOP
+	printf("%-12s NACK: %s\n", e->name, (HWREG(I2C2_BASE + I2C_O_MCS) & I2C_MCS_BUSBSY) ? "bus left busy, the caller must send STOP" :
+		(m_done ? "STOP sent, user_cb(I2C_MIMR_STOPIM) called" : "STOP sent"));
+}
+
+/* the on-chip slave of I2C7 as a register bank (st->regs), talking to libti2cit_m_sync_...() on I2C2 */
+#define SLAVE_ADDR (0x3c)
+static libti2cit_int_st s7;
+static libti2cit_s_regs_st s7_regs;
+static uint32_t s7_first, s7_n, s7_ncb;
+
+static void bench_s_isr7(void)
+{
+	libti2cit_s_isr_isr(&s7);
+}
+
+static void bench_s_wr_cb(libti2cit_int_st * st, uint32_t first, uint32_t n)
+{
+	s7_first = first;
+	s7_n = n;
+	s7_ncb++;
+}
+
+static void bench_slave(void)
+{
+	static uint8_t regs[32];
+	static uint8_t wmask[32];
+	uint8_t w[1 + 16], r[16];
+	uint32_t i;
+
+	bench_setup(&engines[0], 400000);
+	sim_ctl_attach(I2C7_BASE, bus, bench_s_isr7);
+	sim_ctl_slave(I2C7_BASE, bus);
+	HWREG(I2C7_BASE + I2C_O_SOAR) = SLAVE_ADDR;	// a.k.a. ROM_I2CSlaveInit()
+	HWREG(I2C7_BASE + I2C_O_SCSR) = I2C_SCSR_DA;
+	HWREG(I2C7_BASE + I2C_O_SIMR) = I2C_SIMR_DATAIM | I2C_SIMR_STOPIM;
+
+	memset(regs, 0, sizeof(regs));
+	memset(wmask, 0xff, sizeof(wmask));
+	wmask[0x10] = 0x0f;	// only the low nibble of register 0x10 is writable
+	wmask[0x11] = 0x00;	// register 0x11 is read-only
+	regs[0x11] = 0xa5;
+	memset(&s7, 0, sizeof(s7));
+	memset(&s7_regs, 0, sizeof(s7_regs));
+	s7.base = I2C7_BASE;
+	s7.regs = &s7_regs;
+	s7_regs.regs = regs;
+	s7_regs.nregs = sizeof(regs);
+	s7_regs.wmask = wmask;
+	s7_regs.wr_cb = bench_s_wr_cb;
+	s7_ncb = 0;
+
+	// write 16 registers from 0x10, wrapping past the end of the bank at 0x20
+	w[0] = 0x18;
+	for (i = 1; i < sizeof(w); i++) w[i] = 0x30 + i;
+	sim_stats_clear();
+	uint8_t ret = libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, sizeof(w), w);
+	sim_idle(SIM_SYSCLOCK / 10000);	// the STOP
+	sim_stats sw = sim_stats_get();
+
+	// set the pointer, repeated start, read them back
+	w[0] = 0x10;
+	sim_stats_clear();
+	ret |= libti2cit_m_sync_send(I2C2_BASE, (SLAVE_ADDR << 1) | 1, 1, w);
+	ret |= libti2cit_m_sync_recv(I2C2_BASE, sizeof(r), r);
+	sim_idle(SIM_SYSCLOCK / 10000);
+	sim_stats sr = sim_stats_get();
+
+	printf("%-12s slave  write %2u: %4u ints  %5.1f isr cyc/byte   read %2u: %4u ints  %5.1f isr cyc/byte\n",
+		"s_isr regs", (unsigned) sizeof(w), sw.isrs, (double) sw.isr_cycles / sizeof(w),
+		(unsigned) sizeof(r), sr.isrs, (double) sr.isr_cycles / sizeof(r));
+
+	// 0x18..0x1f got w[1..8], 0x00..0x07 got w[9..16]; 0x10 and 0x11 kept their read-only bits
+	for (i = 0; i < 8; i++) if (regs[0x18 + i] != 0x31 + i || regs[i] != 0x39 + i) ret |= 0x80;
+	if (regs[0x10] != 0 || regs[0x11] != 0xa5 || r[0] != 0 || r[1] != 0xa5 || r[8] != 0x31 || r[15] != 0x38) ret |= 0x80;
+	if (s7_ncb != 1 || s7_first != 0x18 || s7_n != 16) ret |= 0x80;
+
+	// the pointer past the end of the bank: the first data byte is NACKed
+	w[0] = 0x40;
+	uint8_t nack = libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, 3, w);
+	if (nack == 3 + 1) ROM_I2CMasterControl(I2C2_BASE, I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+	sim_idle(SIM_SYSCLOCK / 10000);
+	HWREG(I2C2_BASE + I2C_O_MICR) = HWREG(I2C2_BASE + I2C_O_MRIS);	// the STOP left RIS and STOPRIS set
+	// and the next write is ACKed again
+	w[0] = 0x00;
+	w[1] = 0x77;
+	ret |= libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, 2, w);
+	sim_idle(SIM_SYSCLOCK / 10000);
+	// nread is one more than sizeof(r): libti2cit_m_sync_recv() reads a byte it does not store before the STOP
+	if (ret || nack != 3 + 1 || regs[0] != 0x77 || s7_regs.nwrite != 17 || s7_regs.nread != 16 + 1) {
+		fail++, printf("slave regs failed: ret %x nack %u regs[0] %x nwrite %u nread %u\n", ret, nack, regs[0], s7_regs.nwrite, s7_regs.nread);
+	}
+}
+
+/* the I2C7 slave as two devices: SLAVE_ADDR served from one bank, SLAVE_ADDR2 (I2C_O_SOAR2) from another */
+#define SLAVE_ADDR2 (0x3d)
+static libti2cit_s_regs_st s7_regs2;
+static uint32_t s7_ncb2;
+
+static void bench_s_wr_cb2(libti2cit_int_st * st, uint32_t first, uint32_t n)
+{
+	s7_ncb2++;
+}
+
+static void bench_slave_dual(void)
+{
+	static uint8_t regs[8], regs2[4];
+	uint8_t w[3], r[2];
+
+	bench_setup(&engines[0], 400000);
+	sim_ctl_attach(I2C7_BASE, bus, bench_s_isr7);
+	sim_ctl_slave(I2C7_BASE, bus);
+	HWREG(I2C7_BASE + I2C_O_SOAR) = SLAVE_ADDR;	// a.k.a. ROM_I2CSlaveInit()
+	HWREG(I2C7_BASE + I2C_O_SOAR2) = I2C_SOAR2_OAR2EN | SLAVE_ADDR2;	// a.k.a. ROM_I2CSlaveAddressSet(base, 1, addr2)
+	HWREG(I2C7_BASE + I2C_O_SCSR) = I2C_SCSR_DA;
+	HWREG(I2C7_BASE + I2C_O_SIMR) = I2C_SIMR_DATAIM | I2C_SIMR_STOPIM;
+
+	memset(regs, 0x11, sizeof(regs));
+	memset(regs2, 0x22, sizeof(regs2));
+	memset(&s7, 0, sizeof(s7));
+	memset(&s7_regs, 0, sizeof(s7_regs));
+	memset(&s7_regs2, 0, sizeof(s7_regs2));
+	s7.base = I2C7_BASE;
+	s7.regs = &s7_regs;
+	s7.regs2 = &s7_regs2;
+	s7_regs.regs = regs;
+	s7_regs.nregs = sizeof(regs);
+	s7_regs.wr_cb = bench_s_wr_cb;
+	s7_regs2.regs = regs2;
+	s7_regs2.nregs = sizeof(regs2);
+	s7_regs2.wr_cb = bench_s_wr_cb2;
+	s7_ncb = s7_ncb2 = 0;
+
+	// the same register number on each address
+	sim_stats_clear();
+	w[0] = 1;
+	w[1] = 0xa1;
+	uint8_t ret = libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, 2, w);
+	w[1] = 0xb1;
+	ret |= libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR2 << 1, 2, w);
+	ret |= libti2cit_m_sync_send(I2C2_BASE, (SLAVE_ADDR << 1) | 1, 1, w);
+	ret |= libti2cit_m_sync_recv(I2C2_BASE, sizeof(r), r);
+	if (r[0] != 0xa1 || r[1] != 0x11) ret |= 0x80;
+	ret |= libti2cit_m_sync_send(I2C2_BASE, (SLAVE_ADDR2 << 1) | 1, 1, w);
+	ret |= libti2cit_m_sync_recv(I2C2_BASE, sizeof(r), r);
+	if (r[0] != 0xb1 || r[1] != 0x22) ret |= 0x80;
+	sim_idle(SIM_SYSCLOCK / 10000);
+	sim_stats st = sim_stats_get();
+
+	// a NACK from the first bank does not leak into the second
+	w[0] = 0x40;
+	uint8_t nack = libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, 2, w);
+	if (nack) ROM_I2CMasterControl(I2C2_BASE, I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+	sim_idle(SIM_SYSCLOCK / 10000);
+	HWREG(I2C2_BASE + I2C_O_MICR) = HWREG(I2C2_BASE + I2C_O_MRIS);	// the STOP left RIS and STOPRIS set
+	w[0] = 3;
+	w[1] = 0xb3;
+	ret |= libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR2 << 1, 2, w);
+	sim_idle(SIM_SYSCLOCK / 10000);
+
+	printf("%-12s slave  2 addresses, 1 controller: %u ints %.1f isr cyc/int\n", "s_isr regs2", st.isrs,
+		(double) st.isr_cycles / st.isrs);
+	if (ret || nack != 3 || regs[1] != 0xa1 || regs2[1] != 0xb1 || regs2[3] != 0xb3 || s7_ncb != 1 || s7_ncb2 != 2) {
+		fail++, printf("slave regs2 failed: ret %x nack %u regs %x %x %x ncb %u %u\n", ret, nack, regs[1], regs2[1], regs2[3], s7_ncb, s7_ncb2);
+	}
+}
+
+/* the I2C7 slave answers a 256 byte read and takes a 256 byte write through the FIFO or the uDMA
+ * the master is the sync engine, so every interrupt and every stall bit is the slave's
+ */
+static volatile uint32_t s7_done;
+
+static void bench_s_cb(libti2cit_int_st * st, uint32_t status)
+{
+	if (status & I2C_SIMR_STOPIM) s7_done = 1;
+}
+
+static void bench_slave_fifo(const char * name, void (* send)(libti2cit_int_st * st), void (* recv)(libti2cit_int_st * st))
+{
+	static uint8_t sbuf[256], mbuf[256 + 1];
+	uint32_t i;
+
+	bench_setup(&engines[0], 400000);
+	sim_ctl_attach(I2C7_BASE, bus, bench_s_isr7);
+	sim_ctl_slave(I2C7_BASE, bus);
+	HWREG(I2C7_BASE + I2C_O_SOAR) = SLAVE_ADDR;	// a.k.a. ROM_I2CSlaveInit()
+	HWREG(I2C7_BASE + I2C_O_SCSR) = I2C_SCSR_DA;
+	HWREG(I2C7_BASE + I2C_O_SIMR) = I2C_SIMR_DATAIM | I2C_SIMR_STOPIM;
+	memset(&s7, 0, sizeof(s7));
+	s7.base = I2C7_BASE;
+	s7.user_cb = bench_s_cb;
+	s7.dma_tx = 21;	// not the master's channels
+	s7.dma_rx = 20;
+
+	// master read: the sync engine reads one byte more than it stores, the slave answers it with 0xff
+	for (i = 0; i < sizeof(sbuf); i++) sbuf[i] = i ^ 0x5a;
+	s7.buf = sbuf;
+	s7.len = sizeof(sbuf);
+	s7_done = 0;
+	send(&s7);
+	sim_stats_clear();
+	uint8_t ret = libti2cit_m_sync_send(I2C2_BASE, (SLAVE_ADDR << 1) | 1, 0, 0);
+	ret |= libti2cit_m_sync_recv(I2C2_BASE, sizeof(sbuf), mbuf);
+	while (!s7_done) sim_idle(8);
+	sim_stats sr = sim_stats_get();
+	if (ret || memcmp(mbuf, sbuf, sizeof(sbuf)) || s7.nread != sizeof(sbuf)) ret |= 0x80;
+
+	// master write
+	for (i = 0; i < sizeof(mbuf); i++) mbuf[i] = i * 7;
+	memset(sbuf, 0, sizeof(sbuf));
+	s7_done = 0;
+	recv(&s7);
+	sim_stats_clear();
+	ret |= libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, sizeof(sbuf), mbuf);
+	while (!s7_done) sim_idle(8);
+	sim_stats sw = sim_stats_get();
+	if (ret || memcmp(mbuf, sbuf, sizeof(sbuf)) || s7.nread != sizeof(sbuf)) ret |= 0x40;
+
+	// one byte more than buf holds: the slave NACKs it
+	s7_done = 0;
+	recv(&s7);
+	uint8_t nack = libti2cit_m_sync_send(I2C2_BASE, SLAVE_ADDR << 1, sizeof(sbuf) + 1, mbuf);
+	while (!s7_done) sim_idle(8);
+	if (nack != 1 + 2 || s7.nread != sizeof(sbuf)) ret |= 0x20;
+
+	printf("%-12s slave  read %3u: %4u ints %5.1f isr cyc/byte %4u stall bits   write %3u: %4u ints %5.1f isr cyc/byte %4u stall bits\n",
+		name, (unsigned) sizeof(sbuf), sr.isrs, (double) sr.isr_cycles / sizeof(sbuf), sr.stall_bits,
+		(unsigned) sizeof(sbuf), sw.isrs, (double) sw.isr_cycles / sizeof(sbuf), sw.stall_bits);
+	if (ret) fail++, printf("%s: slave failed: %x nack %u nread %u\n", name, ret, nack, s7.nread);
+}
+
+/* with -DLIBTI2CIT_PROF (make sim-prof): the libti2cit_prof_...() histograms of everything above */
+static void bench_prof(void)
+{
+	uint32_t id, k;
+	printf("\n%-28s %8s %8s %8s %8s  log2 histogram (bin:count)\n", "libti2cit_prof", "calls", "min", "avg", "max");
+	for (id = 0; id < LIBTI2CIT_PROF_N; id++) {
+		const libti2cit_prof_st * p = libti2cit_prof_get(id);
+		if (!p || !p->count) continue;
+		printf("%-28s %8u %8u %8llu %8u ", libti2cit_prof_name(id), p->count, p->min,
+			(unsigned long long) (p->total / p->count), p->max);
+		for (k = 0; k < LIBTI2CIT_PROF_NBIN; k++) if (p->bin[k]) printf(" %u:%u", k, p->bin[k]);
+		printf("\n");
+	}
+}
+
+/* save libti2cit_trace the way gdb's "dump binary value" would, for tools/ti2cit-trace */
+static void bench_trace_dump(const char * path)
+{
+	const libti2cit_trace_st * t = libti2cit_trace_get();
+	FILE * f = t ? fopen(path, "wb") : 0;
+	if (!f || fwrite(t, sizeof(*t), 1, f) != 1) fail++, printf("trace: cannot write %s\n", path);
+	if (f) fclose(f);
+}
+
+/* sim-bench [trace.bin]: also save the last LIBTI2CIT_TRACE_LEN events in trace.bin */
+int main(int argc, char ** argv)
+{
+	libti2cit_prof_clear();
+	libti2cit_trace_clear();
+	static const uint32_t speeds[] = { 100000, 400000, 1000000, 3400000 };
+	uint32_t i, j;
+	for (i = 0; i < sizeof(speeds)/sizeof(speeds[0]); i++) {
+		printf("\n--- %u Hz ---\n", speeds[i]);
+		for (j = 0; j < sizeof(engines)/sizeof(engines[0]); j++) {
+			bench_one(&engines[j], speeds[i], 64);
+			bench_one(&engines[j], speeds[i], 300);
+		}
+	}
+	bench_recvpart(&engines[0], 0);
+	bench_recvpart(&engines[1], libti2cit_m_isr_nofifo_recvpart);
+	bench_recvpart(&engines[2], libti2cit_m_isr_recvpart);
+	bench_recvpart(&engines[3], libti2cit_m_isrdma_recvpart);
+	bench_sync_gap(400000);
+	bench_sync_gap(1000000);
+	bench_syncfifo(100000);
+	bench_syncfifo(400000);
+	bench_syncfifo(1000000);
+	bench_syncfifo_nack();
+	bench_syncfifo_hs();
+	bench_syncwfi(100000);
+	bench_syncwfi(400000);
+	bench_syncwfi(1000000);
+	bench_pec(&engines[0], 0);
+	bench_pec(&engines[1], libti2cit_m_isr_nofifo_recvpart);
+	bench_pec(&engines[2], libti2cit_m_isr_recvpart);
+	bench_pec(&engines[3], libti2cit_m_isrdma_recvpart);
+	bench_queue();
+	bench_timeout();
+	bench_recover();
+	bench_scan();
+	bench_mgr(1);
+	bench_mgr(MGR_NBUS);
+	for (j = 0; j < sizeof(engines)/sizeof(engines[0]); j++) bench_speed(&engines[j]);
+	bench_nvm(&engines[0]);
+	bench_nvm(&engines[2]);
+	bench_sched();
+	bench_pt(0);
+	bench_pt(1);
+	bench_slave();
+	bench_slave_dual();
+	bench_slave_fifo("s_isr (FIFO)", libti2cit_s_isr_send, libti2cit_s_isr_recv);
+	bench_slave_fifo("s_isrdma", libti2cit_s_isrdma_send, libti2cit_s_isrdma_recv);
+	for (j = 0; j < sizeof(engines)/sizeof(engines[0]); j++) bench_nack(&engines[j]);
+
+	if (libti2cit_prof_get(0)) bench_prof();
+	if (argc > 1) bench_trace_dump(argv[1]);
+
+	printf("\n%s\n", fail ? "FAILED" : "ok");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,1286 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * ti2cit-sim: see description in ti2cit-sim.h
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ti2cit-sim.h"
+
+#include "inc/hw_i2c.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_nvic.h"
+#include "driverlib/i2c.h"
+#include "driverlib/udma.h"
+
+/* SIM_MARK is ORed into registers whose stores have side effects even when the same value is written back
+ * (MCS, FIFODATA, SDR). A store always clears it, a read leaves it behind.
+ */
+#define SIM_MARK	(0x0a5a0000)
+
+#define SIM_MAX_CTL	(10)
+#define SIM_MAX_BUS	(10)
+#define SIM_MAX_REG	(64)
+#define SIM_FIFO_LEN	(8)
+#define SIM_MAX_SECONDS	(10)
+#define SIM_DMA_CHANNELS	(32)
+
+enum sim_phase { M_IDLE, M_START, M_ADDR, M_DATA, M_STOP };
+
+typedef struct sim_dma_ {
+	uint32_t ctl;
+	uint32_t mode;
+	uint8_t * src;
+	uint8_t * dst;
+	uint32_t n;
+	uint32_t en;
+} sim_dma;
+
+typedef struct sim_fifo_ {
+	uint8_t d[SIM_FIFO_LEN];
+	uint32_t head;
+	uint32_t n;
+} sim_fifo;
+
+struct sim_bus_ {
+	uint32_t scl_hz;
+	sim_dev * devs;
+	uint32_t wedge;		// SCL pulses a slave still needs before it lets go of SDA
+	uint32_t rival;		// STARTs another master still wins
+
+	// GPIO port of the SCL and SDA pins
+	uint32_t gpio;
+	uint8_t scl, sda;
+	uint32_t dir, afsel;
+	uint32_t gpio_shadow;
+};
+
+typedef struct sim_ctl_ {
+	uint32_t base;
+	sim_bus * bus;
+	void (* isr)(void);
+	int irq_en;
+	uint32_t shadow[0x1000/4];
+
+	// master registers
+	uint32_t msa, mdr, mtpr, mimr, mris, mcr, mblen, mbcnt, mclkocnt;
+	uint32_t mtpr_hs;	// the High-Speed timer period: a store to I2C_O_MTPR with I2C_MTPR_HS set
+	uint32_t mcs;		// only the error bits: ERROR, ADRACK, DATACK, ARBLST, CLKTO
+
+	// master state machine
+	enum sim_phase ph;
+	uint64_t t_next;	// when the current phase ends, 0 = stalled: retry at every step
+	uint64_t t_stall;	// when the stall started
+	uint32_t cmd;
+	uint32_t cmd_q;		// command written while the STOP was on the bus
+	uint32_t nleft;
+	uint32_t rw;
+	uint32_t owned;		// START was sent and no STOP yet
+	uint32_t hs;		// the master code was sent: High-Speed mode until the STOP
+	uint32_t loaded;	// M_DATA: the byte is in the shift register
+	uint8_t shift;
+	sim_dev * dev;
+
+	// FIFO
+	uint32_t fifoctl;
+	sim_fifo tx, rx;
+
+	// slave
+	sim_bus * s_bus;
+	sim_dev s_dev, s_dev2;
+	uint32_t soar, soar2, sdr, simr, sris, sackctl, scsr_ctl;
+	uint32_t s_rreq;	// 1 = byte in SDR waiting for the cpu, 2 = cpu read it
+	uint32_t s_treq;	// 1 = waiting for the cpu to write SDR, 2 = cpu wrote it
+	uint32_t s_fbr, s_oar2sel, s_qcmd, s_rw, s_nbytes;
+} sim_ctl;
+
+static struct {
+	uint64_t now;
+	int in_isr;
+	int in_idle;
+	int in_sleep;	// in CPUwfi()
+	int woke;	// an interrupt was taken since CPUwfi() went to sleep
+	int master_en;
+	int primask;	// CPUcpsid(): no interrupt is taken
+	sim_stats st;
+
+	sim_ctl ctl[SIM_MAX_CTL];
+	uint32_t nctl;
+	sim_bus bus[SIM_MAX_BUS];
+	uint32_t nbus;
+	sim_dma dma[SIM_DMA_CHANNELS];
+
+	// the last HWREG() access, whose store (if any) is applied at the next access
+	sim_ctl * pend_ctl;
+	sim_bus * pend_gpio;
+	uint32_t pend_off;
+	uint32_t pend_val;
+
+	// any other register (GPIO, UART, ...) is plain memory
+	uint32_t reg_addr[SIM_MAX_REG];
+	uint32_t reg_val[SIM_MAX_REG];
+	uint32_t nreg;
+} sim;
+
+static void sim_advance(uint32_t cycles);
+static void sim_m_command(sim_ctl * c, uint32_t cmd);
+static void sim_commit(void);
+
+
+
+
+static void sim_fatal(const char * why, uint32_t base)
+{
+	fprintf(stderr, "ti2cit-sim: %s (base %08x, t=%llu)\n", why, base, (unsigned long long) sim.now);
+	exit(2);
+}
+
+static sim_ctl * sim_ctl_find(uint32_t base)
+{
+	uint32_t i;
+	for (i = 0; i < sim.nctl; i++) if (sim.ctl[i].base == base) return &sim.ctl[i];
+	return 0;
+}
+
+static uint32_t sim_bit(sim_ctl * c)
+{
+	// SCL = SysClk / (2 * (SCL_LP + SCL_HP) * (TPR + 1)) with SCL_LP + SCL_HP = 10, or 3 in High-Speed mode
+	if (c->hs) return 6 * (c->mtpr_hs + 1);
+	return 20 * ((c->mtpr & I2C_MTPR_TPR_M) + 1);
+}
+
+static uint32_t sim_tpr(uint32_t scl_hz)
+{
+	return (SIM_SYSCLOCK + 20 * scl_hz - 1) / (20 * scl_hz) - 1;	// same as I2CMasterInitExpClk()
+}
+
+static uint32_t sim_fifo_pop(sim_fifo * f)
+{
+	uint8_t v = f->d[f->head];
+	f->head = (f->head + 1) % SIM_FIFO_LEN;
+	f->n--;
+	return v;
+}
+
+static void sim_fifo_push(sim_fifo * f, uint8_t v)
+{
+	f->d[(f->head + f->n) % SIM_FIFO_LEN] = v;
+	f->n++;
+}
+
+static uint32_t sim_txtrig(sim_ctl * c) { return (c->fifoctl & I2C_FIFOCTL_TXTRIG_M) >> I2C_FIFOCTL_TXTRIG_S; }
+static uint32_t sim_rxtrig(sim_ctl * c) { return (c->fifoctl & I2C_FIFOCTL_RXTRIG_M) >> I2C_FIFOCTL_RXTRIG_S; }
+
+/* the TX FIFO just lost a byte: raise the TX FIFO service request and TX FIFO empty interrupts
+ * of the master or the slave, whichever I2C_FIFOCTL_TXASGNMT gave the FIFO to
+ */
+static void sim_tx_popped(sim_ctl * c)
+{
+	uint32_t s = c->fifoctl & I2C_FIFOCTL_TXASGNMT;
+	if (c->tx.n == sim_txtrig(c)) {
+		if (s) c->sris |= I2C_SRIS_TXRIS;
+		else c->mris |= I2C_MRIS_TXRIS;
+	}
+	if (!c->tx.n) {
+		if (s) c->sris |= I2C_SRIS_TXFERIS;
+		else c->mris |= I2C_MRIS_TXFERIS;
+	}
+}
+
+/* the RX FIFO just gained a byte */
+static void sim_rx_pushed(sim_ctl * c)
+{
+	uint32_t s = c->fifoctl & I2C_FIFOCTL_RXASGNMT;
+	if (c->rx.n == sim_rxtrig(c)) {
+		if (s) c->sris |= I2C_SRIS_RXRIS;
+		else c->mris |= I2C_MRIS_RXRIS;
+	}
+	if (c->rx.n == SIM_FIFO_LEN) {
+		if (s) c->sris |= I2C_SRIS_RXFFRIS;
+		else c->mris |= I2C_MRIS_RXFFRIS;
+	}
+}
+
+
+
+
+/* uDMA: serve the FIFO requests of every enabled channel that points at an I2C_O_FIFODATA */
+
+static sim_ctl * sim_dma_fifo(void * p)
+{
+	uintptr_t a = (uintptr_t) p;
+	if ((a & 0xfff) != I2C_O_FIFODATA) return 0;
+	return sim_ctl_find(a & ~(uintptr_t) 0xfff);
+}
+
+/* the channel moved its last byte: the uDMA done interrupt goes to the master or the slave, like the FIFO */
+static void sim_dma_done(sim_dma * d, sim_ctl * c, uint32_t slave, uint32_t mris, uint32_t sris)
+{
+	d->en = 0;
+	d->mode = UDMA_MODE_STOP;
+	if (slave) c->sris |= sris;
+	else c->mris |= mris;
+}
+
+static void sim_dma_service(void)
+{
+	uint32_t i;
+	for (i = 0; i < SIM_DMA_CHANNELS; i++) {
+		sim_dma * d = &sim.dma[i];
+		if (!d->en || d->mode == UDMA_MODE_STOP) continue;
+		uint32_t arb = 1 << ((d->ctl >> 14) & 15);
+		sim_ctl * c;
+		if ((c = sim_dma_fifo(d->dst))) {
+			// TX FIFO: requests while it holds TXTRIG bytes or less
+			if (!(c->fifoctl & I2C_FIFOCTL_DMATXENA)) continue;
+			while (d->n && c->tx.n <= sim_txtrig(c)) {
+				uint32_t k = arb;
+				while (k-- && d->n && c->tx.n < SIM_FIFO_LEN) {
+					sim_fifo_push(&c->tx, *d->src++);
+					d->n--;
+					sim.st.dma_bytes++;
+				}
+			}
+			if (!d->n) sim_dma_done(d, c, c->fifoctl & I2C_FIFOCTL_TXASGNMT, I2C_MRIS_DMATXRIS, I2C_SRIS_DMATXRIS);
+		} else if ((c = sim_dma_fifo(d->src))) {
+			// RX FIFO: requests while it holds RXTRIG bytes or more
+			if (!(c->fifoctl & I2C_FIFOCTL_DMARXENA)) continue;
+			while (d->n && c->rx.n && c->rx.n >= sim_rxtrig(c)) {
+				uint32_t k = arb;
+				while (k-- && d->n && c->rx.n) {
+					*d->dst++ = sim_fifo_pop(&c->rx);
+					d->n--;
+					sim.st.dma_bytes++;
+				}
+			}
+			if (!d->n) sim_dma_done(d, c, c->fifoctl & I2C_FIFOCTL_RXASGNMT, I2C_MRIS_DMARXRIS, I2C_SRIS_DMARXRIS);
+		}
+	}
+}
+
+void sim_rom_uDMAChannelControlSet(uint32_t ch, uint32_t ctl)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	sim.dma[ch & 31].ctl = ctl;
+}
+
+void sim_rom_uDMAChannelTransferSet(uint32_t ch, uint32_t mode, void * src, void * dst, uint32_t n)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	sim_dma * d = &sim.dma[ch & 31];
+	if (!n || n > 1024) sim_fatal("uDMA transfer size must be 1 to 1024", ch);
+	d->mode = mode;
+	d->src = src;
+	d->dst = dst;
+	d->n = n;
+}
+
+void sim_rom_uDMAChannelEnable(uint32_t ch)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	sim.dma[ch & 31].en = 1;
+}
+
+void sim_rom_uDMAChannelDisable(uint32_t ch)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	sim.dma[ch & 31].en = 0;
+}
+
+void sim_rom_SysCtlDelay(uint32_t n)
+{
+	sim.st.romcalls++;
+	sim_commit();
+	sim_advance(SIM_CYCLES_ROMCALL);
+	uint64_t cycles = 3 * (uint64_t) n;	// 3 cycles per loop
+	while (cycles) {
+		uint32_t k = cycles > 8 ? 8 : cycles;
+		sim_advance(k);
+		cycles -= k;
+	}
+}
+
+uint32_t sim_rom_uDMAChannelModeGet(uint32_t ch)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	return sim.dma[ch & 31].mode;
+}
+
+uint32_t sim_rom_uDMAChannelSizeGet(uint32_t ch)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	sim_dma * d = &sim.dma[ch & 31];
+	return d->mode == UDMA_MODE_STOP ? 0 : d->n;
+}
+
+
+
+
+/* master state machine */
+
+static void sim_m_done(sim_ctl * c, uint32_t mris)
+{
+	c->ph = M_IDLE;
+	c->t_next = 0;
+	c->mris |= mris;
+}
+
+static void sim_m_stall(sim_ctl * c)
+{
+	if (c->t_next) c->t_stall = sim.now;
+	c->t_next = 0;
+}
+
+static void sim_m_unstall(sim_ctl * c, uint64_t t_next)
+{
+	if (!c->t_next) sim.st.stall_bits += (sim.now - c->t_stall) / sim_bit(c);
+	c->t_next = t_next;
+}
+
+static void sim_m_nack(sim_ctl * c, uint32_t which)
+{
+	c->mcs |= I2C_MCS_ERROR | which;
+	c->mris |= I2C_MRIS_NACKRIS;
+	if (c->cmd & I2C_MCS_STOP) {
+		// the STOP that was requested still happens; RIS is signalled with the NACK
+		c->mris |= I2C_MRIS_RIS;
+		c->ph = M_STOP;
+		c->t_next = sim.now + sim_bit(c);
+		return;
+	}
+	// the bus stays owned until software sends a STOP (..._ERROR_STOP) or a repeated START
+	sim_m_done(c, I2C_MRIS_RIS);
+}
+
+/* start the next data byte, or stall if the FIFO is not ready */
+static void sim_m_byte(sim_ctl * c)
+{
+	c->ph = M_DATA;
+	c->loaded = 0;
+	if (c->cmd & I2C_MCS_BURST) {
+		if (!c->rw) {
+			if (!c->tx.n) { sim_m_stall(c); return; }
+			c->shift = sim_fifo_pop(&c->tx);
+			sim_tx_popped(c);
+		} else if (c->rx.n >= SIM_FIFO_LEN) {
+			sim_m_stall(c);
+			return;
+		}
+	} else if (!c->rw) {
+		c->shift = c->mdr;
+	}
+	c->loaded = 1;
+	sim_m_unstall(c, sim.now + 9 * sim_bit(c));
+	sim.st.bus_bits += 9;
+}
+
+/* I2C_MCR_MFE cleared: the master forgets what it was doing */
+static void sim_m_reset(sim_ctl * c)
+{
+	if (c->dev && c->dev->stop) c->dev->stop(c->dev);
+	c->dev = 0;
+	c->ph = M_IDLE;
+	c->t_next = 0;
+	c->owned = 0;
+	c->hs = 0;
+	c->cmd_q = 0;
+	c->mcs = 0;
+}
+
+/* after the address or a data byte: more data, STOP, or done */
+static void sim_m_next(sim_ctl * c)
+{
+	if (c->nleft) {
+		sim_m_byte(c);
+	} else if (c->cmd & I2C_MCS_STOP) {
+		// the transfer is complete (RIS), the STOP condition follows one bit-time later (STOPRIS)
+		c->mris |= I2C_MRIS_RIS;
+		c->ph = M_STOP;
+		sim_m_unstall(c, sim.now + sim_bit(c));
+		sim.st.bus_bits++;
+	} else {
+		if (!c->t_next) sim_m_unstall(c, sim.now);
+		sim_m_done(c, I2C_MRIS_RIS);
+	}
+}
+
+static void sim_m_event(sim_ctl * c)
+{
+	switch (c->ph) {
+	case M_IDLE:
+		return;
+
+	case M_START:
+		if (c->bus->wedge || c->bus->rival) {
+			// SDA is already low, or the other master's address wins: this master loses arbitration at the START
+			if (c->bus->rival) c->bus->rival--;
+			c->mcs |= I2C_MCS_ERROR | I2C_MCS_ARBLST;
+			sim_m_done(c, I2C_MRIS_ARBLOSTRIS | I2C_MRIS_RIS);
+			return;
+		}
+		c->owned = 1;
+		c->rw = c->msa & I2C_MSA_RS;
+		c->ph = M_ADDR;
+		c->t_next = sim.now + 9 * sim_bit(c);
+		sim.st.bus_bits += 9;
+		return;
+
+	case M_ADDR: {
+		if (c->cmd & I2C_MCS_HS) {
+			// the master code: nobody ACKs it, the bus stays owned and runs at the High-Speed rate until the STOP
+			c->hs = 1;
+			sim.st.hs_codes++;
+			sim_m_nack(c, I2C_MCS_ADRACK);
+			return;
+		}
+		sim_dev * d;
+		for (d = c->bus->devs; d; d = d->next) if (d->addr == (c->msa >> 1)) break;
+		int r = d ? (d->start ? d->start(d, c->rw) : SIM_ACK) : SIM_NACK;
+		if (r == SIM_STALL) { sim_m_stall(c); return; }
+		if (!c->t_next) sim_m_unstall(c, sim.now);
+		c->dev = d;
+		if (r == SIM_NACK) { sim_m_nack(c, I2C_MCS_ADRACK); return; }
+		sim_m_next(c);
+		return;
+	}
+
+	case M_DATA:
+		if (!c->loaded) {
+			sim_m_byte(c);
+			return;
+		}
+		if (!c->rw) {
+			int r = c->dev->write(c->dev, c->shift);
+			if (r == SIM_STALL) { sim_m_stall(c); return; }
+			if (!c->t_next) sim_m_unstall(c, sim.now);
+			c->nleft--;
+			if (c->cmd & I2C_MCS_BURST) c->mbcnt--;
+			if (r == SIM_NACK) { sim_m_nack(c, I2C_MCS_DATACK); return; }
+		} else {
+			uint8_t v;
+			if (c->dev->read(c->dev, &v) == SIM_STALL) { sim_m_stall(c); return; }
+			if (!c->t_next) sim_m_unstall(c, sim.now);
+			c->nleft--;
+			if (c->cmd & I2C_MCS_BURST) {
+				c->mbcnt--;
+				sim_fifo_push(&c->rx, v);
+				sim_rx_pushed(c);
+			} else {
+				c->mdr = v;
+			}
+		}
+		sim_m_next(c);
+		return;
+
+	case M_STOP:
+		c->owned = 0;
+		c->hs = 0;
+		if (c->dev && c->dev->stop) c->dev->stop(c->dev);
+		c->dev = 0;
+		sim_m_done(c, I2C_MRIS_STOPRIS);
+		if (c->cmd_q) {
+			// a command written during the STOP starts now
+			uint32_t cmd = c->cmd_q;
+			c->cmd_q = 0;
+			sim_m_command(c, cmd);
+		}
+		return;
+	}
+}
+
+static void sim_m_command(sim_ctl * c, uint32_t cmd)
+{
+	if (c->ph == M_STOP && !c->cmd_q) {
+		c->cmd_q = cmd;
+		return;
+	}
+	if (c->ph != M_IDLE) {
+		fprintf(stderr, "ti2cit-sim: MCS = %02x while busy, ignored (base %08x)\n", cmd, c->base);
+		return;
+	}
+	c->cmd = cmd;
+	c->mcs = 0;
+	c->t_next = sim.now;	// not stalled
+	if (cmd & I2C_MCS_QCMD) {
+		c->nleft = 0;
+	} else if (cmd & I2C_MCS_BURST) {
+		c->nleft = c->mblen & I2C_MBLEN_CNTL_M;
+		c->mbcnt = c->nleft;
+	} else {
+		c->nleft = cmd & I2C_MCS_RUN;
+	}
+
+	if (cmd & I2C_MCS_START) {
+		c->ph = M_START;
+		c->t_next = sim.now + sim_bit(c);
+		sim.st.bus_bits++;
+	} else if (!c->owned) {
+		// nothing to continue: the command completes after one bit-time
+		c->mris |= I2C_MRIS_RIS;
+		c->ph = M_STOP;
+		c->t_next = sim.now + sim_bit(c);
+	} else {
+		sim_m_next(c);
+	}
+}
+
+
+
+
+/* on-chip slave, seen from the bus as a sim_dev */
+
+static sim_ctl * sim_s_ctl(sim_dev * d)
+{
+	return (sim_ctl *) d->priv;
+}
+
+static int sim_s_start(sim_dev * d, uint32_t rw)
+{
+	sim_ctl * c = sim_s_ctl(d);
+	if (!(c->scsr_ctl & I2C_SCSR_DA)) return SIM_NACK;
+	c->s_rw = rw;
+	c->s_fbr = 1;
+	c->s_nbytes = 0;
+	c->s_qcmd = 0;
+	c->s_rreq = 0;
+	c->s_treq = 0;
+	c->s_oar2sel = (d == &c->s_dev2);
+	c->sris |= I2C_SRIS_STARTRIS;
+	return SIM_ACK;
+}
+
+/* I2C_SCSR_RXFIFO / I2C_SCSR_TXFIFO: the slave moves data through the FIFO instead of I2C_O_SDR */
+static int sim_s_rxfifo(sim_ctl * c)
+{
+	return (c->scsr_ctl & I2C_SCSR_RXFIFO) && (c->fifoctl & I2C_FIFOCTL_RXASGNMT);
+}
+
+static int sim_s_txfifo(sim_ctl * c)
+{
+	return (c->scsr_ctl & I2C_SCSR_TXFIFO) && (c->fifoctl & I2C_FIFOCTL_TXASGNMT);
+}
+
+static int sim_s_write(sim_dev * d, uint8_t data)
+{
+	sim_ctl * c = sim_s_ctl(d);
+	if (!c->s_rreq && sim_s_rxfifo(c)) {
+		// SCL is held low while the RX FIFO is full
+		if (c->rx.n >= SIM_FIFO_LEN) return SIM_STALL;
+		sim_fifo_push(&c->rx, data);
+		sim_rx_pushed(c);
+		c->s_fbr = 0;
+		c->s_nbytes++;
+		if ((c->sackctl & I2C_SACKCTL_ACKOEN) && (c->sackctl & I2C_SACKCTL_ACKOVAL)) return SIM_NACK;
+		return SIM_ACK;
+	}
+	if (!c->s_rreq) {
+		c->sdr = data;
+		c->s_rreq = 1;
+		c->sris |= I2C_SRIS_DATARIS;
+		return SIM_STALL;
+	}
+	if (c->s_rreq == 1) return SIM_STALL;
+	c->s_rreq = 0;
+	c->s_fbr = 0;
+	c->s_nbytes++;
+	if ((c->sackctl & I2C_SACKCTL_ACKOEN) && (c->sackctl & I2C_SACKCTL_ACKOVAL)) return SIM_NACK;
+	return SIM_ACK;
+}
+
+static int sim_s_read(sim_dev * d, uint8_t * data)
+{
+	sim_ctl * c = sim_s_ctl(d);
+	if (c->s_treq != 2 && sim_s_txfifo(c)) {
+		if (c->tx.n) {
+			c->s_treq = 0;
+			c->s_nbytes++;
+			*data = sim_fifo_pop(&c->tx);
+			sim_tx_popped(c);
+			return SIM_ACK;
+		}
+		// the TX FIFO is empty: I2C_SCSR_TREQ, SCL is held low until the cpu fills the FIFO or writes I2C_O_SDR
+		if (!c->s_treq) {
+			c->s_treq = 1;
+			c->sris |= I2C_SRIS_DATARIS;
+		}
+		return SIM_STALL;
+	}
+	if (!c->s_treq) {
+		c->s_treq = 1;
+		c->sris |= I2C_SRIS_DATARIS;
+		return SIM_STALL;
+	}
+	if (c->s_treq == 1) return SIM_STALL;
+	c->s_treq = 0;
+	c->s_nbytes++;
+	*data = c->sdr;
+	return SIM_ACK;
+}
+
+static void sim_s_stop(sim_dev * d)
+{
+	sim_ctl * c = sim_s_ctl(d);
+	if (!c->s_nbytes) {
+		c->s_qcmd = 1;
+		c->sris |= I2C_SRIS_DATARIS;
+	}
+	c->sris |= I2C_SRIS_STOPRIS;
+}
+
+static uint32_t sim_s_scsr(sim_ctl * c)
+{
+	uint32_t v = 0;
+	if (c->s_rreq == 1) v |= I2C_SCSR_RREQ;
+	if (c->s_treq == 1) v |= I2C_SCSR_TREQ;
+	if (c->s_rreq == 1 && c->s_fbr) v |= I2C_SCSR_FBR;
+	if (c->s_oar2sel) v |= I2C_SCSR_OAR2SEL;
+	if (c->s_qcmd) v |= I2C_SCSR_QCMDST | (c->s_rw ? I2C_SCSR_QCMDRW : 0);
+	return v;
+}
+
+
+
+
+/* register file */
+
+static uint32_t sim_reg_read(sim_ctl * c, uint32_t off)
+{
+	switch (off) {
+	case I2C_O_MSA: return c->msa;
+	case I2C_O_MCS: {
+		uint32_t v = c->mcs | SIM_MARK;
+		if (c->ph != M_IDLE) v |= I2C_MCS_BUSY;
+		else v |= I2C_MCS_IDLE;
+		if (c->owned || c->ph != M_IDLE) v |= I2C_MCS_BUSBSY;
+		return v;
+	}
+	case I2C_O_MDR: return c->mdr;
+	case I2C_O_MTPR: return c->mtpr;
+	case I2C_O_MIMR: return c->mimr;
+	case I2C_O_MRIS: return c->mris;
+	case I2C_O_MMIS: return c->mris & c->mimr;
+	case I2C_O_MICR: return 0;
+	case I2C_O_MCR: return c->mcr;
+	case I2C_O_MCLKOCNT: return c->mclkocnt;
+	case I2C_O_MBMON: return (c->bus && c->bus->wedge ? 0 : I2C_MBMON_SDA) | I2C_MBMON_SCL;
+	case I2C_O_MBLEN: return c->mblen;
+	case I2C_O_MBCNT: return c->mbcnt;
+	case I2C_O_SOAR: return c->soar;
+	case I2C_O_SCSR: return sim_s_scsr(c);
+	case I2C_O_SDR: return c->sdr | SIM_MARK;
+	case I2C_O_SIMR: return c->simr;
+	case I2C_O_SRIS: return c->sris;
+	case I2C_O_SMIS: return c->sris & c->simr;
+	case I2C_O_SICR: return 0;
+	case I2C_O_SOAR2: return c->soar2;
+	case I2C_O_SACKCTL: return c->sackctl;
+	case I2C_O_FIFODATA: return (c->rx.n ? c->rx.d[c->rx.head] : 0) | SIM_MARK;
+	case I2C_O_FIFOCTL: return c->fifoctl;
+	case I2C_O_FIFOSTATUS: {
+		uint32_t v = 0;
+		if (!c->tx.n) v |= I2C_FIFOSTATUS_TXFE;
+		if (c->tx.n == SIM_FIFO_LEN) v |= I2C_FIFOSTATUS_TXFF;
+		if (c->tx.n <= sim_txtrig(c)) v |= I2C_FIFOSTATUS_TXBLWTRIG;
+		if (!c->rx.n) v |= I2C_FIFOSTATUS_RXFE;
+		if (c->rx.n == SIM_FIFO_LEN) v |= I2C_FIFOSTATUS_RXFF;
+		if (c->rx.n >= sim_rxtrig(c)) v |= I2C_FIFOSTATUS_RXABVTRIG;
+		return v;
+	}
+	case I2C_O_PP: return I2C_PP_HS;
+	case I2C_O_PC: return I2C_PC_HS;
+	}
+	return 0;
+}
+
+/* the cpu read a register with a read side effect */
+static void sim_reg_load(sim_ctl * c, uint32_t off)
+{
+	switch (off) {
+	case I2C_O_SDR:
+		if (c->s_rreq == 1) c->s_rreq = 2;
+		return;
+	case I2C_O_FIFODATA:
+		if (!c->rx.n) sim_fatal("FIFODATA read with the RX FIFO empty", c->base);
+		sim_fifo_pop(&c->rx);
+		return;
+	}
+}
+
+/* the cpu stored v to a register */
+static void sim_reg_store(sim_ctl * c, uint32_t off, uint32_t v)
+{
+	switch (off) {
+	case I2C_O_MSA: c->msa = v & 0xff; return;
+	case I2C_O_MCS: sim_m_command(c, v); return;
+	case I2C_O_MDR: c->mdr = v & 0xff; return;
+	case I2C_O_MTPR:
+		if (v & I2C_MTPR_HS) c->mtpr_hs = v & I2C_MTPR_TPR_M;
+		else c->mtpr = v;
+		return;
+	case I2C_O_MIMR: c->mimr = v & 0xfff; return;
+	case I2C_O_MICR: c->mris &= ~v; return;
+	case I2C_O_MMIS: return;	// rev B errata workaround write, ignored
+	case I2C_O_MCR:
+		c->mcr = v;
+		if (!(v & I2C_MCR_MFE)) sim_m_reset(c);
+		return;
+	case I2C_O_MCLKOCNT: c->mclkocnt = v; return;
+	case I2C_O_MBLEN: c->mblen = v & I2C_MBLEN_CNTL_M; return;
+	case I2C_O_SOAR: c->soar = v & I2C_SOAR_OAR_M; c->s_dev.addr = c->soar; return;
+	case I2C_O_SCSR: c->scsr_ctl = v; return;
+	case I2C_O_SDR:
+		c->sdr = v & 0xff;
+		if (c->s_treq == 1) c->s_treq = 2;
+		return;
+	case I2C_O_SIMR: c->simr = v & 0x1ff; return;
+	case I2C_O_SICR: c->sris &= ~v; return;
+	case I2C_O_SOAR2:
+		c->soar2 = v & (I2C_SOAR2_OAR2EN | I2C_SOAR2_OAR2_M);
+		c->s_dev2.addr = (c->soar2 & I2C_SOAR2_OAR2EN) ? (c->soar2 & I2C_SOAR2_OAR2_M) : 0xff;
+		return;
+	case I2C_O_SACKCTL: c->sackctl = v & 3; return;
+	case I2C_O_FIFODATA:
+		if (c->tx.n >= SIM_FIFO_LEN) sim_fatal("FIFODATA write with the TX FIFO full", c->base);
+		sim_fifo_push(&c->tx, v);
+		return;
+	case I2C_O_FIFOCTL:
+		if (v & I2C_FIFOCTL_TXFLUSH) c->tx.n = 0;
+		if (v & I2C_FIFOCTL_RXFLUSH) c->rx.n = 0;
+		c->fifoctl = v & ~(I2C_FIFOCTL_TXFLUSH | I2C_FIFOCTL_RXFLUSH);
+		return;
+	}
+}
+
+static volatile uint32_t * sim_generic(uint32_t addr)
+{
+	uint32_t i;
+	for (i = 0; i < sim.nreg; i++) if (sim.reg_addr[i] == addr) return &sim.reg_val[i];
+	if (sim.nreg >= SIM_MAX_REG) sim_fatal("too many registers", addr);
+	sim.reg_addr[sim.nreg] = addr;
+	sim.reg_val[sim.nreg] = 0;
+	return &sim.reg_val[sim.nreg++];
+}
+
+/* apply the store (or the read side effect) of the previous HWREG() access */
+static void sim_gpio_store(sim_bus * b, uint32_t off, uint32_t v)
+{
+	switch (off) {
+	case GPIO_O_DIR: {
+		// SCL released by the GPIO pin: a clock pulse
+		uint32_t was = b->dir;
+		b->dir = v;
+		if ((was & b->scl) && !(v & b->scl) && !(b->afsel & b->scl)) {
+			sim.st.gpio_clocks++;
+			if (b->wedge) b->wedge--;
+		}
+		return;
+	}
+	case GPIO_O_AFSEL: b->afsel = v; return;
+	}
+}
+
+static uint32_t sim_gpio_read(sim_bus * b, uint32_t off)
+{
+	switch (off) {
+	case GPIO_O_DIR: return b->dir;
+	case GPIO_O_AFSEL: return b->afsel;
+	}
+	if (off >= 0x400) return 0;
+
+	uint32_t gp = ~b->afsel & b->dir;	// pins driven low
+	uint32_t lv = 0xff;
+	if (gp & b->scl) lv &= ~b->scl;
+	if ((gp & b->sda) || b->wedge) lv &= ~b->sda;
+	return lv & (off >> 2);
+}
+
+static sim_bus * sim_gpio_find(uint32_t port)
+{
+	uint32_t i;
+	for (i = 0; i < sim.nbus; i++) if (sim.bus[i].gpio == port) return &sim.bus[i];
+	return 0;
+}
+
+static void sim_commit(void)
+{
+	sim_bus * b = sim.pend_gpio;
+	if (b) {
+		sim.pend_gpio = 0;
+		if (b->gpio_shadow != sim.pend_val) sim_gpio_store(b, sim.pend_off, b->gpio_shadow);
+	}
+
+	sim_ctl * c = sim.pend_ctl;
+	if (!c) return;
+	sim.pend_ctl = 0;
+	uint32_t v = c->shadow[sim.pend_off / 4];
+	if (v == sim.pend_val) sim_reg_load(c, sim.pend_off);
+	else sim_reg_store(c, sim.pend_off, v);
+}
+
+/* the NVIC interrupt number of the controller at base, see inc/hw_ints.h */
+static uint32_t sim_ctl_int(uint32_t base)
+{
+	static const uint32_t b[] = { I2C0_BASE, I2C1_BASE, I2C2_BASE, I2C3_BASE, I2C4_BASE,
+		I2C5_BASE, I2C6_BASE, I2C7_BASE, I2C8_BASE, I2C9_BASE };
+	static const uint32_t n[] = { INT_I2C0, INT_I2C1, INT_I2C2, INT_I2C3, INT_I2C4,
+		INT_I2C5, INT_I2C6, INT_I2C7, INT_I2C8, INT_I2C9 };
+	uint32_t i;
+	for (i = 0; i < sizeof(b)/sizeof(b[0]); i++) if (b[i] == base) return n[i];
+	return 0;
+}
+
+/* NVIC_EN0 + 4 * word: a bit for each controller with sim_ctl_irq() on */
+static uint32_t sim_nvic_en(uint32_t word)
+{
+	uint32_t en = 0;
+	uint32_t i;
+	for (i = 0; i < sim.nctl; i++) {
+		uint32_t n = sim_ctl_int(sim.ctl[i].base);
+		if (n && sim.ctl[i].irq_en && (n - 16) / 32 == word) en |= 1 << ((n - 16) % 32);
+	}
+	return en;
+}
+
+volatile uint32_t * sim_hwreg(uint32_t addr)
+{
+	sim_commit();
+	if (sim.in_isr) sim.st.hwreg_isr++;
+	else sim.st.hwreg++;
+	sim_advance(SIM_CYCLES_HWREG);
+
+	sim_bus * b = sim_gpio_find(addr & ~0xfff);
+	if (b) {
+		b->gpio_shadow = sim_gpio_read(b, addr & 0xfff);
+		sim.pend_gpio = b;
+		sim.pend_off = addr & 0xfff;
+		sim.pend_val = b->gpio_shadow;
+		return &b->gpio_shadow;
+	}
+
+	sim_ctl * c = sim_ctl_find(addr & ~0xfff);
+	if (addr >= NVIC_EN0 && addr <= NVIC_EN3) {
+		volatile uint32_t * r = sim_generic(addr);
+		*r = sim_nvic_en((addr - NVIC_EN0) / 4);	// stores are ignored, use sim_ctl_irq()
+		return r;
+	}
+	if (addr == SIM_DWT_CYCCNT) {
+		volatile uint32_t * r = sim_generic(addr);
+		*r = (uint32_t) sim.now;	// stores to CYCCNT are ignored
+		return r;
+	}
+	if (!c) return sim_generic(addr);
+
+	uint32_t off = addr & 0xffc;
+	uint32_t v = sim_reg_read(c, off);
+	c->shadow[off / 4] = v;
+	sim.pend_ctl = c;
+	sim.pend_off = off;
+	sim.pend_val = v;
+	return &c->shadow[off / 4];
+}
+
+void sim_rom_I2CMasterControl(uint32_t base, uint32_t cmd)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	*sim_hwreg(base + I2C_O_MCS) = cmd;
+	sim_commit();
+}
+
+bool sim_rom_I2CMasterBusy(uint32_t base)
+{
+	sim.st.romcalls++;
+	sim_advance(SIM_CYCLES_ROMCALL);
+	return (*sim_hwreg(base + I2C_O_MCS) & I2C_MCS_BUSY) ? true : false;
+}
+
+
+
+
+/* time and interrupts */
+
+/* the interrupt line of c is up and the NVIC has it enabled: it is pending, and wakes CPUwfi() */
+static int sim_irq_raised(sim_ctl * c)
+{
+	if (!c->irq_en) return 0;
+	return (c->mris & c->mimr) || (c->sris & c->simr);
+}
+
+static int sim_irq_pending(sim_ctl * c)
+{
+	return c->isr && sim_irq_raised(c);
+}
+
+static void sim_dispatch(void)
+{
+	uint32_t storm = 0;
+	uint32_t i;
+	for (i = 0; i < sim.nctl; i++) {
+		sim_ctl * c = &sim.ctl[i];
+		while (sim.master_en && !sim.primask && sim_irq_pending(c)) {
+			if (++storm > 100000) sim_fatal("interrupt storm: the isr does not clear its interrupt", c->base);
+			uint64_t t0 = sim.now;
+			sim.in_isr = 1;
+			sim.woke = 1;
+			sim.st.isrs++;
+			sim_advance(SIM_CYCLES_ISR / 2);
+			c->isr();
+			sim_commit();
+			sim_advance(SIM_CYCLES_ISR / 2);
+			sim.in_isr = 0;
+			sim.st.isr_cycles += sim.now - t0;
+		}
+	}
+}
+
+/* run every bus event that happens before t, in order */
+static void sim_run_to(uint64_t t)
+{
+	sim_dma_service();
+	for (;;) {
+		sim_ctl * e = 0;
+		uint32_t i;
+		for (i = 0; i < sim.nctl; i++) {
+			sim_ctl * c = &sim.ctl[i];
+			if (c->ph == M_IDLE || !c->t_next || c->t_next > t) continue;
+			if (!e || c->t_next < e->t_next) e = c;
+		}
+		if (!e) break;
+		if (e->t_next > sim.now) sim.now = e->t_next;
+		sim_m_event(e);
+		sim_dma_service();
+	}
+	sim.now = t;
+
+	// retry anything that is stalled on the cpu
+	uint32_t i;
+	for (i = 0; i < sim.nctl; i++) {
+		sim_ctl * c = &sim.ctl[i];
+		if (c->ph != M_IDLE && !c->t_next) sim_m_event(c);
+	}
+	sim_dma_service();
+}
+
+static void sim_advance(uint32_t cycles)
+{
+	if (sim.now > (uint64_t) SIM_SYSCLOCK * SIM_MAX_SECONDS) sim_fatal("simulated time limit reached, the cpu is stuck", 0);
+	sim_run_to(sim.now + cycles);
+	sim.st.cycles += cycles;
+	if (sim.in_idle && !sim.in_isr) sim.st.idle_cycles += cycles;
+	if (sim.in_sleep && !sim.in_isr) sim.st.sleep_cycles += cycles;
+	if (!sim.in_isr) sim_dispatch();
+}
+
+uint64_t sim_now(void)
+{
+	return sim.now;
+}
+
+void sim_idle(uint32_t cycles)
+{
+	sim_commit();
+	sim.in_idle = 1;
+	while (cycles) {
+		uint32_t n = cycles > 8 ? 8 : cycles;
+		sim_advance(n);
+		cycles -= n;
+	}
+	sim.in_idle = 0;
+}
+
+uint32_t sim_cpu_cpsid(void)
+{
+	uint32_t was = sim.primask;
+	sim.primask = 1;
+	return was;
+}
+
+uint32_t sim_cpu_cpsie(void)
+{
+	uint32_t was = sim.primask;
+	sim_commit();
+	sim.primask = 0;
+	if (!sim.in_isr) sim_dispatch();
+	return was;
+}
+
+void sim_cpu_wfi(void)
+{
+	sim_commit();
+	if (sim.in_isr) sim_fatal("WFI in an interrupt handler", 0);
+	sim.in_sleep = 1;
+	sim.woke = 0;
+	for (;;) {
+		uint32_t i;
+		for (i = 0; i < sim.nctl && !sim_irq_raised(&sim.ctl[i]); i++);
+		if (i < sim.nctl || sim.woke) break;
+		sim_advance(1);
+	}
+	sim.in_sleep = 0;
+}
+
+int sim_in_isr(void)
+{
+	return sim.in_isr;
+}
+
+void sim_stats_clear(void)
+{
+	memset(&sim.st, 0, sizeof(sim.st));
+}
+
+sim_stats sim_stats_get(void)
+{
+	sim_commit();
+	return sim.st;
+}
+
+
+
+
+/* setup */
+
+void sim_reset(void)
+{
+	memset(&sim, 0, sizeof(sim));
+	sim.master_en = 1;
+}
+
+sim_bus * sim_bus_new(uint32_t scl_hz)
+{
+	if (sim.nbus >= SIM_MAX_BUS) sim_fatal("too many buses", 0);
+	sim_bus * b = &sim.bus[sim.nbus++];
+	b->scl_hz = scl_hz;
+	return b;
+}
+
+void sim_bus_gpio(sim_bus * bus, uint32_t port, uint8_t scl, uint8_t sda)
+{
+	bus->gpio = port;
+	bus->scl = scl;
+	bus->sda = sda;
+	bus->afsel = scl | sda;
+}
+
+void sim_bus_wedge(sim_bus * bus, uint32_t nclocks)
+{
+	bus->wedge = nclocks;
+}
+
+void sim_bus_rival(sim_bus * bus, uint32_t nstarts)
+{
+	bus->rival = nstarts;
+}
+
+void sim_bus_add(sim_bus * bus, sim_dev * d)
+{
+	d->next = bus->devs;
+	bus->devs = d;
+}
+
+static sim_ctl * sim_ctl_get(uint32_t base)
+{
+	sim_ctl * c = sim_ctl_find(base);
+	if (c) return c;
+	if (sim.nctl >= SIM_MAX_CTL) sim_fatal("too many controllers", base);
+	c = &sim.ctl[sim.nctl++];
+	c->base = base;
+	c->s_dev.priv = c;
+	c->s_dev.addr = 0xff;
+	c->s_dev2.priv = c;
+	c->s_dev2.addr = 0xff;
+	return c;
+}
+
+void sim_ctl_attach(uint32_t base, sim_bus * bus, void (* isr)(void))
+{
+	sim_ctl * c = sim_ctl_get(base);
+	c->bus = bus;
+	c->isr = isr;
+	c->irq_en = 1;
+	c->mtpr = sim_tpr(bus->scl_hz);	// a.k.a. I2CMasterInitExpClk()
+	c->mcr |= I2C_MCR_MFE;
+}
+
+void sim_ctl_slave(uint32_t base, sim_bus * bus)
+{
+	sim_ctl * c = sim_ctl_get(base);
+	sim_dev * d[2] = { &c->s_dev, &c->s_dev2 };
+	uint32_t i;
+	for (i = 0; i < 2; i++) {
+		d[i]->start = sim_s_start;
+		d[i]->write = sim_s_write;
+		d[i]->read = sim_s_read;
+		d[i]->stop = sim_s_stop;
+		sim_bus_add(bus, d[i]);
+	}
+	c->s_bus = bus;
+	c->mcr |= I2C_MCR_SFE;
+}
+
+void sim_ctl_irq(uint32_t base, int enable)
+{
+	sim_ctl * c = sim_ctl_get(base);
+	c->irq_en = enable;
+}
+
+
+
+
+/* device models */
+
+static int sim_eeprom_start(sim_dev * d, uint32_t rw)
+{
+	sim_eeprom * e = (sim_eeprom *) d;
+	if (sim.now < e->busy_until) return SIM_NACK;	// write cycle in progress: ACK polling
+	if (!rw) e->nwr = 0;
+	return SIM_ACK;
+}
+
+static int sim_eeprom_write(sim_dev * d, uint8_t data)
+{
+	sim_eeprom * e = (sim_eeprom *) d;
+	if (e->nwr < e->addr_bytes) {
+		e->ptr = (e->nwr ? (e->ptr << 8) | data : data) % e->size;
+		e->nwr++;
+		return SIM_ACK;
+	}
+	e->mem[e->ptr] = data;
+	e->ptr = (e->ptr & ~(e->page - 1)) | ((e->ptr + 1) & (e->page - 1));	// page writes wrap inside the page
+	e->dirty = 1;
+	return SIM_ACK;
+}
+
+static int sim_eeprom_read(sim_dev * d, uint8_t * data)
+{
+	sim_eeprom * e = (sim_eeprom *) d;
+	*data = e->mem[e->ptr];
+	e->ptr = (e->ptr + 1) % e->size;	// sequential reads roll over the whole array
+	return SIM_ACK;
+}
+
+static void sim_eeprom_stop(sim_dev * d)
+{
+	sim_eeprom * e = (sim_eeprom *) d;
+	if (e->dirty) e->busy_until = sim.now + e->t_wr;
+	e->dirty = 0;
+}
+
+void sim_eeprom_init(sim_eeprom * e, uint8_t addr, uint8_t * mem, uint32_t size, uint32_t page,
+	uint32_t addr_bytes, uint32_t t_wr)
+{
+	memset(e, 0, sizeof(*e));
+	e->dev.addr = addr;
+	e->dev.start = sim_eeprom_start;
+	e->dev.write = sim_eeprom_write;
+	e->dev.read = sim_eeprom_read;
+	e->dev.stop = sim_eeprom_stop;
+	e->mem = mem;
+	e->size = size;
+	e->page = page;
+	e->addr_bytes = addr_bytes;
+	e->t_wr = t_wr;
+}
+
+static int sim_hih_start(sim_dev * d, uint32_t rw)
+{
+	sim_hih * h = (sim_hih *) d;
+	h->ncmd = 0;
+	if (!rw && !h->cmd_mode) {
+		// measurement request
+		h->ready_at = sim.now + h->t_conv;
+		h->measured = 0;
+		h->hum += 37;
+		h->temp += 11;
+	}
+	h->pos = 0;
+	return SIM_ACK;
+}
+
+static int sim_hih_write(sim_dev * d, uint8_t data)
+{
+	sim_hih * h = (sim_hih *) d;
+	if (h->ncmd < sizeof(h->cmd)) h->cmd[h->ncmd] = data;
+	h->ncmd++;
+	return SIM_ACK;
+}
+
+/* a 3-byte write is a command */
+static void sim_hih_stop(sim_dev * d)
+{
+	sim_hih * h = (sim_hih *) d;
+	if (h->ncmd != sizeof(h->cmd)) return;
+	uint8_t c = h->cmd[0];
+	h->eep_ready_at = sim.now;
+	h->eep_status = 1;
+	if (c == 0xa0) {
+		h->cmd_mode = 1;
+	} else if (c == 0x80) {
+		h->cmd_mode = 0;
+	} else if (!h->cmd_mode || (c & 0xa0)) {
+		h->eep_status = 2;
+	} else if (c & 0x40) {
+		h->eep[c & 0x1f] = (h->cmd[1] << 8) | h->cmd[2];
+		h->eep_ready_at += h->t_eep_wr;
+	} else {
+		h->eep_data = h->eep[c & 0x1f];
+		h->eep_ready_at += h->t_eep_rd;
+	}
+}
+
+static int sim_hih_read(sim_dev * d, uint8_t * data)
+{
+	sim_hih * h = (sim_hih *) d;
+	if (h->cmd_mode) {
+		uint32_t busy = sim.now < h->eep_ready_at;
+		switch (h->pos++) {
+		case 0: *data = 0x80 | (busy ? 0 : h->eep_status); break;
+		case 1: *data = h->eep_data >> 8; break;
+		case 2: *data = h->eep_data & 0xff; break;
+		default: *data = 0xff; break;
+		}
+		return SIM_ACK;
+	}
+	uint32_t stale = (sim.now < h->ready_at || h->measured) ? 1 : 0;
+	uint32_t hum = h->hum & 0x3fff;
+	uint32_t temp = h->temp & 0x3fff;
+	switch (h->pos++) {
+	case 0: *data = (stale << 6) | (hum >> 8); break;
+	case 1: *data = hum & 0xff; break;
+	case 2: *data = temp >> 6; break;
+	case 3: *data = (temp << 2) & 0xff; break;
+	default: *data = 0xff; break;
+	}
+	if (h->pos == 4 && !stale) {
+		h->measured = 1;
+		h->reads++;
+	}
+	return SIM_ACK;
+}
+
+void sim_hih_init(sim_hih * h, uint8_t addr, uint32_t t_conv)
+{
+	memset(h, 0, sizeof(*h));
+	h->dev.addr = addr;
+	h->dev.start = sim_hih_start;
+	h->dev.write = sim_hih_write;
+	h->dev.read = sim_hih_read;
+	h->dev.stop = sim_hih_stop;
+	h->t_conv = t_conv;
+	h->hum = 0x1234;
+	h->temp = 0x1a2b;
+	h->ready_at = 0;
+	h->measured = 1;
+}
@@ -0,0 +1,182 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ * Licensed under the GNU LGPL v3.
+ *
+ * ti2cit-sim: host-side register model of the TM4C129 i2c controllers, used to build and benchmark the
+ * unmodified libti2cit.c on linux.
+ *
+ * The shim headers in sim/inc and sim/driverlib replace tivaware so every HWREG() and ROM_I2C...() call lands
+ * here. Time is counted in cpu cycles (SIM_SYSCLOCK per second): each register access, ROM call and interrupt
+ * entry costs a fixed number of cycles, and the bus advances one bit-time (SIM_SYSCLOCK / scl_hz cycles) at a
+ * time while the cpu runs. Slave devices on the bus are plain C callbacks; the on-chip slave of a controller
+ * can also be put on a bus to exercise libti2cit_s_... against the master of another controller.
+ *
+ * uDMA channels are modelled only as far as the i2c FIFOs go: a channel whose source or destination is the
+ * I2C_O_FIFODATA of a controller serves that controller's FIFO requests and costs the cpu nothing. The FIFOs
+ * work for the master or, with I2C_FIFOCTL_TXASGNMT / I2C_FIFOCTL_RXASGNMT and I2C_SCSR_TXFIFO / I2C_SCSR_RXFIFO,
+ * for the on-chip slave.
+ *
+ * CPUcpsid() and CPUcpsie() (driverlib/cpu.h) set and clear PRIMASK, which holds off every isr. CPUwfi() sleeps
+ * until a controller with sim_ctl_irq() on has its interrupt line up, or an isr has run; the time goes in
+ * sleep_cycles.
+ *
+ * Limitations of the model: HWREG() returns a pointer to a shadow register, and the store (if any) is applied at
+ * the next register access. Do not write expressions like HWREG(a) = HWREG(b) where both have side effects.
+ */
+#ifndef TI2CIT_SIM_H
+#define TI2CIT_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_SYSCLOCK		(120*1000*1000)
+
+/* cost model, in cpu cycles */
+#define SIM_CYCLES_HWREG	(2)	// one peripheral load or store on the AHB
+#define SIM_CYCLES_ROMCALL	(10)	// branch through the ROM function table, prologue and return
+#define SIM_CYCLES_ISR		(24)	// exception entry + exit, 12 + 12 cycles on the Cortex-M4
+
+/* Cortex-M4 DWT cycle counter: reads return the low 32 bits of sim_now() */
+#define SIM_DWT_CYCCNT		(0xE0001004)
+
+/* return values for sim_dev callbacks */
+#define SIM_ACK			(0)
+#define SIM_NACK		(1)
+#define SIM_STALL		(-1)	// hold SCL low (clock stretching), the callback will be called again later
+
+typedef struct sim_dev_ sim_dev;
+struct sim_dev_ {
+	uint8_t addr;	// 7-bit address
+	int (* start)(sim_dev * d, uint32_t rw);	// START (or repeated START) + address matched, 0 = always ACK
+	int (* write)(sim_dev * d, uint8_t data);	// master wrote a byte
+	int (* read)(sim_dev * d, uint8_t * data);	// master reads a byte
+	void (* stop)(sim_dev * d);			// STOP
+	void * priv;
+	sim_dev * next;
+};
+
+typedef struct sim_bus_ sim_bus;
+
+typedef struct sim_stats_ {
+	uint64_t cycles;	// cpu cycles elapsed
+	uint64_t isr_cycles;	// cpu cycles spent in interrupt handlers
+	uint64_t idle_cycles;	// cpu cycles thread mode spent in sim_idle(), free for other work
+	uint64_t sleep_cycles;	// cpu cycles thread mode spent asleep in CPUwfi()
+	uint32_t hwreg;		// register accesses from thread mode
+	uint32_t hwreg_isr;	// register accesses from handler mode
+	uint32_t romcalls;	// ROM_... calls
+	uint32_t isrs;		// interrupt handler entries
+	uint32_t bus_bits;	// bit-times the bus was transferring
+	uint32_t stall_bits;	// bit-times SCL was held low waiting for the cpu
+	uint32_t dma_bytes;	// bytes moved by the uDMA
+	uint32_t gpio_clocks;	// SCL pulses made with the GPIO pins
+	uint32_t hs_codes;	// High-Speed master codes sent
+} sim_stats;
+
+/* called through the shim headers */
+extern volatile uint32_t * sim_hwreg(uint32_t addr);
+extern void sim_rom_I2CMasterControl(uint32_t base, uint32_t cmd);
+extern bool sim_rom_I2CMasterBusy(uint32_t base);
+extern void sim_rom_uDMAChannelControlSet(uint32_t ch, uint32_t ctl);
+extern void sim_rom_uDMAChannelTransferSet(uint32_t ch, uint32_t mode, void * src, void * dst, uint32_t n);
+extern void sim_rom_uDMAChannelEnable(uint32_t ch);
+extern void sim_rom_uDMAChannelDisable(uint32_t ch);
+extern uint32_t sim_rom_uDMAChannelModeGet(uint32_t ch);
+extern uint32_t sim_rom_uDMAChannelSizeGet(uint32_t ch);
+extern void sim_rom_SysCtlDelay(uint32_t n);
+extern uint32_t sim_cpu_cpsid(void);
+extern uint32_t sim_cpu_cpsie(void);
+extern void sim_cpu_wfi(void);
+
+/* simulation setup: sim_reset() forgets all buses, controllers and devices */
+extern void sim_reset(void);
+extern sim_bus * sim_bus_new(uint32_t scl_hz);
+extern void sim_bus_add(sim_bus * bus, sim_dev * d);
+/* sim_bus_gpio(): the SCL and SDA pins of bus are pins scl and sda (GPIO_PIN_...) of the GPIO port at port
+ * the port only models what bus recovery needs: DATA reads the line levels, a pin with AFSEL clear and DIR set
+ * pulls its line low
+ */
+extern void sim_bus_gpio(sim_bus * bus, uint32_t port, uint8_t scl, uint8_t sda);
+/* sim_bus_wedge(): a slave holds SDA low until it has seen nclocks SCL pulses from the GPIO pins
+ * every START on the bus loses arbitration until then
+ */
+extern void sim_bus_wedge(sim_bus * bus, uint32_t nclocks);
+/* sim_bus_rival(): another master wins arbitration against the next nstarts STARTs on the bus
+ * its transfer is not modelled: the lines read idle (SDA and SCL high) in I2C_O_MBMON and the GPIO pins
+ */
+extern void sim_bus_rival(sim_bus * bus, uint32_t nstarts);
+
+/* sim_ctl_attach(): connect the i2c controller at base to bus, call isr() when its interrupt is pending */
+extern void sim_ctl_attach(uint32_t base, sim_bus * bus, void (* isr)(void));
+/* sim_ctl_slave(): put the on-chip slave of base on bus, answering to SOAR (and SOAR2 if enabled) */
+extern void sim_ctl_slave(uint32_t base, sim_bus * bus);
+/* sim_ctl_irq(): enable or disable the NVIC interrupt for base */
+extern void sim_ctl_irq(uint32_t base, int enable);
+
+/* time */
+extern uint64_t sim_now(void);
+extern void sim_idle(uint32_t cycles);	// thread mode does other work for cycles, interrupts are taken
+extern int sim_in_isr(void);
+
+/* statistics since the last sim_stats_clear() */
+extern void sim_stats_clear(void);
+extern sim_stats sim_stats_get(void);
+
+
+
+/* device models */
+
+/* 24Cxx-style eeprom: 1 or 2 address bytes, page writes, NACKs its address for t_wr cycles after a write */
+typedef struct sim_eeprom_ {
+	sim_dev dev;
+	uint8_t * mem;
+	uint32_t size;
+	uint32_t page;
+	uint32_t addr_bytes;
+	uint32_t t_wr;
+
+	uint32_t ptr;
+	uint32_t nwr;
+	uint32_t dirty;
+	uint64_t busy_until;
+} sim_eeprom;
+extern void sim_eeprom_init(sim_eeprom * e, uint8_t addr, uint8_t * mem, uint32_t size, uint32_t page,
+	uint32_t addr_bytes, uint32_t t_wr);
+
+/* Honeywell HIH6130-style humidity/temperature sensor
+ * a write (or quick command) starts a measurement, a read returns 4 bytes with the "stale" bit set until t_conv
+ * cycles have passed
+ * command mode: the 3-byte command 0xa0 enters it (any time, not only just after power up), 0x80 leaves it
+ *   0x00 - 0x1f reads eeprom word n, 0x40 - 0x5f writes it. A read then returns the status byte (0x80 busy until
+ *   t_eep_rd or t_eep_wr cycles have passed, 0x81 done, 0x82 illegal command) and the word
+ */
+typedef struct sim_hih_ {
+	sim_dev dev;
+	uint32_t t_conv;
+	uint16_t hum;
+	uint16_t temp;
+	uint16_t eep[32];
+	uint32_t t_eep_rd;
+	uint32_t t_eep_wr;
+
+	uint64_t ready_at;
+	uint32_t measured;
+	uint32_t pos;
+	uint32_t reads;
+	uint32_t cmd_mode;
+	uint8_t cmd[3];
+	uint32_t ncmd;
+	uint8_t eep_status;
+	uint16_t eep_data;
+	uint64_t eep_ready_at;
+} sim_hih;
+extern void sim_hih_init(sim_hih * h, uint8_t addr, uint32_t t_conv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TI2CIT_SIM_H */
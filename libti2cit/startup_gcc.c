@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include "inc/hw_nvic.h"
 #include "inc/hw_types.h"
+#include "libti2cit.h"
 
 /*
  * Interrupt Service Routines (ISR's) must return void and must take no arguments.
@@ -26,6 +27,8 @@ static void FaultISR();
 static void IntDefaultHandler();
 extern void i2c2IntHandler();
 extern void i2c7IntHandler();
+extern void uart0IntHandler();
+extern void timer0AIntHandler();
 
 
 
@@ -59,7 +62,7 @@ __attribute__ ((section(".isr_vector"))) int_vector_t int_vector_table[] =
 	IntDefaultHandler,                      //  18: GPIO Port C
 	IntDefaultHandler,                      //  19: GPIO Port D
 	IntDefaultHandler,                      //  20: GPIO Port E
-	IntDefaultHandler,                      //  21: UART0 Rx and Tx
+	uart0IntHandler,                        //  21: UART0 Rx and Tx
 	IntDefaultHandler,                      //  22: UART1 Rx and Tx
 	IntDefaultHandler,                      //  23: SSI0 Rx and Tx
 	IntDefaultHandler,                      //  24: I2C0 Master and Slave
@@ -73,7 +76,7 @@ __attribute__ ((section(".isr_vector"))) int_vector_t int_vector_table[] =
 	IntDefaultHandler,                      //  32: ADC Sequence 2
 	IntDefaultHandler,                      //  33: ADC Sequence 3
 	IntDefaultHandler,                      //  34: Watchdog timer
-	IntDefaultHandler,                      //  35: Timer 0 subtimer A
+	timer0AIntHandler,                      //  35: Timer 0 subtimer A
 	IntDefaultHandler,                      //  36: Timer 0 subtimer B
 	IntDefaultHandler,                      //  37: Timer 1 subtimer A
 	IntDefaultHandler,                      //  38: Timer 1 subtimer B
@@ -241,6 +244,7 @@ static void NmiSR()
 
 static void FaultISR()
 {
+	libti2cit_trace_stop();	// keep the i2c events that led up to this for the debugger
 	for (;;) ;
 }
 
@@ -0,0 +1,191 @@
+/* Copyright (c) 2014 David Hubbard github.com/davidhubbard
+ *
+ * ti2cit-trace: print a libti2cit_trace dump as a timeline of i2c transactions
+ *
+ * usage: ti2cit-trace [-m MHz] trace.bin
+ *   trace.bin is libti2cit_trace saved from the target, e.g. in gdb: dump binary value trace.bin libti2cit_trace
+ *   it can also be a dump of all of RAM: the ring is found by LIBTI2CIT_TRACE_MAGIC
+ *   -m is the system clock, to turn DWT CYCCNT into microseconds (default 120)
+ *
+ * the dump is read as little-endian words whatever the host is, so this builds with any cc (see `make trace`)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libti2cit.h"
+
+#include "inc/hw_i2c.h"
+
+/* the libti2cit.c state enums, in order: keep these in step with it */
+static const char * const m_state_name[] = {
+	"IDLE", "WAIT_STOP", "WAIT_RIS", "NOFIFO_SEND", "NOFIFO_RECV", "NOFIFO_RECVPART",
+	"FIFO_SEND", "FIFO_RECV", "FIFO_RECVPART", "DMA_SEND", "DMA_RECV", "DMA_RECVPART", "HS_CODE",
+};
+static const char * const s_state_name[] = {
+	"IDLE", "FIFO_SEND", "FIFO_RECV", "DMA_SEND", "DMA_RECV",
+};
+
+typedef struct bit_name_ {
+	uint32_t bit;
+	const char * name;
+} bit_name;
+
+static const bit_name mmis_name[] = {
+	{ I2C_MIMR_IM, "RIS" }, { I2C_MIMR_CLKIM, "CLK" }, { I2C_MIMR_DMARXIM, "dmaRX" }, { I2C_MIMR_DMATXIM, "dmaTX" },
+	{ I2C_MIMR_NACKIM, "nack" }, { I2C_MIMR_STARTIM, "start" }, { I2C_MIMR_STOPIM, "stop" },
+	{ I2C_MIMR_ARBLOSTIM, "arb" }, { I2C_MIMR_TXIM, "TX" }, { I2C_MIMR_RXIM, "RX" },
+	{ I2C_MIMR_TXFEIM, "TXFE" }, { I2C_MIMR_RXFFIM, "RXFF" }, { LIBTI2CIT_ISR_PEC, "PEC" },
+	{ LIBTI2CIT_ISR_UNEXPECTED, "UNEXPECTED" },
+	{ 0, 0 }
+};
+static const bit_name smis_name[] = {
+	{ I2C_SIMR_DATAIM << 16, "data" }, { I2C_SIMR_STARTIM << 16, "start" }, { I2C_SIMR_STOPIM << 16, "stop" },
+	{ I2C_SIMR_DMARXIM << 16, "dmaRX" }, { I2C_SIMR_DMATXIM << 16, "dmaTX" }, { I2C_SIMR_TXIM << 16, "TX" },
+	{ I2C_SIMR_RXIM << 16, "RX" }, { I2C_SIMR_TXFEIM << 16, "TXFE" }, { I2C_SIMR_RXFFIM << 16, "RXFF" },
+	{ I2C_SCSR_RREQ, "|RREQ" }, { I2C_SCSR_TREQ, "|TREQ" }, { I2C_SCSR_FBR, "|FBR" },
+	{ I2C_SCSR_OAR2SEL, "|OAR2" }, { I2C_SCSR_QCMDST, "|QCMD" },
+	{ 0, 0 }
+};
+
+/* status in hex, then the name of each bit that is set */
+static const char * status_str(const bit_name * t, uint32_t status)
+{
+	static char buf[128];
+	int n = snprintf(buf, sizeof(buf), "%08x", status);
+	for (; t->name; t++) {
+		if ((status & t->bit) && n < (int) sizeof(buf)) n += snprintf(buf + n, sizeof(buf) - n, " %s", t->name);
+	}
+	return buf;
+}
+
+/* bits 19:12 of the I2Cn_BASE addresses */
+static const uint8_t base_id[10] = { 0x20, 0x21, 0x22, 0x23, 0xc0, 0xc1, 0xc2, 0xc3, 0xb8, 0xb9 };
+
+static int bus_num(uint8_t base)
+{
+	int n;
+	for (n = 0; n < 10; n++) if (base_id[n] == base) return n;
+	return -1;
+}
+
+static uint32_t le32(const uint8_t * p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* an open transfer on one bus: when it started and how many interrupts so far */
+typedef struct xact_ {
+	int open;
+	uint64_t t0;
+	uint32_t nisr;
+} xact;
+
+int main(int argc, char ** argv)
+{
+	double mhz = 120;
+	int argi = 1;
+	if (argc > 2 && !strcmp(argv[1], "-m")) {
+		mhz = atof(argv[2]);
+		argi = 3;
+	}
+	if (argi != argc - 1 || mhz <= 0) {
+		fprintf(stderr, "usage: %s [-m MHz] trace.bin\n", argv[0]);
+		return 2;
+	}
+
+	FILE * f = fopen(argv[argi], "rb");
+	if (!f) {
+		perror(argv[argi]);
+		return 1;
+	}
+	static uint8_t dump[4 << 20];
+	size_t size = fread(dump, 1, sizeof(dump), f);
+	fclose(f);
+
+	// find the header: the magic, then a power of 2 len that fits in the file
+	const size_t hdr = 16, evsize = sizeof(libti2cit_trace_ev);
+	size_t off;
+	uint32_t len = 0;
+	for (off = 0; off + hdr <= size; off += 4) {
+		if (le32(dump + off) != LIBTI2CIT_TRACE_MAGIC) continue;
+		len = le32(dump + off + 4);
+		if (len && !(len & (len - 1)) && off + hdr + len * evsize <= size) break;
+		len = 0;
+	}
+	if (!len) {
+		fprintf(stderr, "%s: no libti2cit_trace found\n", argv[argi]);
+		return 1;
+	}
+	uint32_t head = le32(dump + off + 8);
+	uint32_t stop = le32(dump + off + 12);
+	const uint8_t * ev = dump + off + hdr;
+
+	uint32_t n = head < len ? head : len;
+	printf("libti2cit_trace at offset 0x%zx: %u events, showing the last %u%s\n", off, head, n, stop ? " (stopped)" : "");
+	printf("%14s  %-4s  %-7s  %-15s %4s  %-34s %6s\n", "time(us)", "bus", "event", "state", "addr", "status", "count");
+
+	xact bus[2][256];	// master and slave
+	memset(bus, 0, sizeof(bus));
+	uint64_t now = 0;
+	uint32_t prev = 0;
+	uint32_t i;
+	for (i = 0; i < n; i++) {
+		const uint8_t * e = ev + ((head - n + i) & (len - 1)) * evsize;
+		uint32_t cyccnt = le32(e);
+		uint8_t what = e[4], base = e[5], state = e[6], addr = e[7];
+		uint32_t status = le32(e + 8), count = le32(e + 12);
+		if (i) now += (uint32_t) (cyccnt - prev);	// unsigned: CYCCNT wraps every 35 seconds at 120 MHz
+		prev = cyccnt;
+
+		char busname[8];
+		int num = bus_num(base);
+		if (num < 0) snprintf(busname, sizeof(busname), "?%02x", base);
+		else snprintf(busname, sizeof(busname), "I2C%d", num);
+		printf("%14.3f  %-4s  ", now / mhz, busname);
+
+		const char * sname = "?";
+		int slave = (what == LIBTI2CIT_TRACE_S_START || what == LIBTI2CIT_TRACE_S_ISR);
+		xact * x = &bus[slave][base];
+		if (slave && state < sizeof(s_state_name) / sizeof(s_state_name[0])) sname = s_state_name[state];
+		if (!slave && state < sizeof(m_state_name) / sizeof(m_state_name[0])) sname = m_state_name[state];
+
+		switch (what) {
+		case LIBTI2CIT_TRACE_M_START:
+		case LIBTI2CIT_TRACE_S_START:
+			x->open = 1;	// even if the last one never finished: after a NACK the caller may send the STOP itself
+			x->t0 = now;
+			x->nisr = 0;
+			printf("%-7s  %-15s 0x%02x  len %-30u %6u\n", slave ? "s_start" : "m_start", sname, addr, status, count);
+			break;
+
+		case LIBTI2CIT_TRACE_M_ISR:
+			x->nisr++;
+			printf("%-7s  %-15s 0x%02x  %-34s %6u\n", "m_isr", sname, addr, status_str(mmis_name, status), count);
+			break;
+
+		case LIBTI2CIT_TRACE_S_ISR:
+			x->nisr++;
+			printf("%-7s  %-15s       %-34s %6u\n", "s_isr", sname, status_str(smis_name, status), count);
+			if (x->open && (status & (I2C_SIMR_STOPIM << 16)) && state != 0) {
+				printf("%14s  %-4s  done: %.3f us since s_start, %u ints\n", "", busname, (now - x->t0) / mhz, x->nisr);
+				x->open = 0;
+			}
+			break;
+
+		case LIBTI2CIT_TRACE_M_DONE:
+			printf("%-7s  %-15s 0x%02x  %-34s %6u\n", "m_done", sname, addr, status_str(mmis_name, status), count);
+			if (x->open && state == 0) {	// a NACK keeps the state for the STOP that follows it
+				printf("%14s  %-4s  done: %.3f us since m_start, %u ints\n", "", busname, (now - x->t0) / mhz, x->nisr);
+				x->open = 0;
+			}
+			break;
+
+		default:
+			printf("unknown event %u\n", what);
+			break;
+		}
+	}
+	return 0;
+}